@@ -9,27 +9,44 @@
 #include <string.h>
 #include <wchar.h>
 
+#include "../syscalls/syscalls.h"
+
+
 #define BASE_TEN 10
 
 int get_cell_width(const char *str) {
     setlocale(LC_ALL, "");
 
-    size_t len = mbstowcs(NULL, str, 0);
-    if (len == (size_t)-1) {
-        fprintf(stderr, "cells: invaid utf8 string provided as cell shape\n");
-        return -1;
-    }
+    mbstate_t mbstate;
+    memset(&mbstate, 0, sizeof(mbstate));
 
-    wchar_t* wstr = malloc((len + 1) * sizeof(wchar_t));
-    if (wstr == NULL) {
-        fprintf(stderr, "error: failed to allocate memory for wide char\n");
-        return -1;
-    }
+    size_t len = strlen(str);
+    int width = 0;
+
+    // se decodifica carácter a carácter para no reservar
+    // una copia ancha de la cadena entera
+    while (len > 0) {
+        wchar_t wc;
+        size_t read = mbrtowc(&wc, str, len, &mbstate);
+
+        if (read == (size_t)-1 || read == (size_t)-2) {
+            fprintf(stderr, "cells: invaid utf8 string provided as cell shape\n");
+            return -1;
+        }
+        if (read == 0) {
+            break;
+        }
 
-    mbstowcs(wstr, str, len + 1);
+        int char_width = wcwidth(wc);
 
-    int width = wcswidth(wstr, len);
-    free(wstr);
+        if (char_width < 0) {
+            return -1;
+        }
+
+        width += char_width;
+        str += read;
+        len -= read;
+    }
 
     return width;
 }
@@ -98,6 +115,21 @@ parse_u8(const char* haystack, uint8_t* parse, const char* name) {
 
 #define DEFAULT_DELAY 50
 
+#define DEFAULT_THREADS 1
+#define MAX_THREADS 1024
+
+#define MAX_TIME_BLOCK 256
+
+#define MAX_RANKS 1024
+
+// la caché se pide en MiB y se reparte entre los trabajadores
+#define MAX_MEMO_MIB (1 << 20)
+#define MIB ((size_t)1 << 20)
+
+// con --engine auto la caché es uno de los motores entre los que elegir,
+// y si no se pide tamaño se reserva este, que se mapea según se usa
+#define DEFAULT_AUTO_MEMO_MIB 64
+
 typedef enum arg_id {
     ARG_DIMS = 1000,
     ARG_TORUS,
@@ -106,8 +138,377 @@ typedef enum arg_id {
     ARG_SHAPE,
     ARG_COLOR,
     ARG_DELAY,
+    ARG_THREADS,
+    ARG_TILE,
+    ARG_KERNEL,
+    ARG_UNBOUNDED,
+    ARG_ENGINE,
+    ARG_RULE,
+    ARG_TIME_BLOCK,
+    ARG_LAYOUT,
+    ARG_RANDOM,
+    ARG_SUM,
+    ARG_MEMO,
+    ARG_IN_PLACE,
+    ARG_RANKS,
+    ARG_RANK,
+    ARG_SOCKET,
 } arg_id_t;
 
+static const char* const KERNEL_NAME[KERNEL_LEN] = {"auto", "scalar", "sse2", "avx2", "avx512", "lut"};
+
+static int
+parse_kernel(const char* haystack, grid_kernel_t* kernel) {
+    for (size_t i = 0; i < KERNEL_LEN; ++i) {
+        if (strcmp(haystack, KERNEL_NAME[i]) == 0) {
+            *kernel = (grid_kernel_t)i;
+            return 0;
+        }
+    }
+
+    fprintf(stderr, "cells: unknown kernel '%s', expected auto, scalar, sse2, avx2, avx512 or lut\n", haystack);
+    return -1;
+}
+
+static const char* const SUM_NAME[SUM_LEN] = {"auto", "adder", "rowsum"};
+
+static int
+parse_sum(const char* haystack, grid_sum_t* sum) {
+    for (size_t i = 0; i < SUM_LEN; ++i) {
+        if (strcmp(haystack, SUM_NAME[i]) == 0) {
+            *sum = (grid_sum_t)i;
+            return 0;
+        }
+    }
+
+    fprintf(stderr, "cells: unknown neighbour sum '%s', expected auto, adder or rowsum\n", haystack);
+    return -1;
+}
+
+#define RULE_MAX_NEIGHBORS 8
+
+// cuentas de vecinos como cifras seguidas, que pueden no ser ninguna
+static int
+parse_rule_digits(const char** str, uint16_t* mask) {
+    *mask = 0;
+
+    for (; **str >= '0' && **str <= '9'; ++(*str)) {
+        unsigned count = (unsigned)(**str - '0');
+
+        if (count > RULE_MAX_NEIGHBORS) {
+            return -1;
+        }
+
+        *mask |= (uint16_t)(1U << count);
+    }
+
+    return 0;
+}
+
+// letra de un campo de la regla, mayúscula o minúscula
+static int
+parse_rule_prefix(const char** str, char prefix) {
+    if (**str != prefix && **str != prefix + ('a' - 'A')) {
+        return -1;
+    }
+
+    ++(*str);
+
+    return 0;
+}
+
+static int
+parse_rule_counts(const char** str, char prefix, uint16_t* mask) {
+    if (parse_rule_prefix(str, prefix) < 0) {
+        return -1;
+    }
+
+    return parse_rule_digits(str, mask);
+}
+
+// número de como mucho max al principio de str, que queda tras él
+static int
+parse_rule_number(const char** str, unsigned max, unsigned* value) {
+    if (**str < '0' || **str > '9') {
+        return -1;
+    }
+
+    *value = 0;
+
+    for (; **str >= '0' && **str <= '9'; ++(*str)) {
+        *value = (*value * BASE_TEN) + (unsigned)(**str - '0');
+
+        if (*value > max) {
+            return -1;
+        }
+    }
+
+    return 0;
+}
+
+// el siguiente campo de una regla de rango, una coma y su letra
+static int
+parse_rule_field(const char** str, char prefix) {
+    if ((*str)[0] != ',' || ((*str)[1] != prefix && (*str)[1] != prefix + ('a' - 'A'))) {
+        return -1;
+    }
+
+    *str += 2;
+
+    return 0;
+}
+
+// intervalo cerrado de cuentas de la forma min..max
+static int
+parse_rule_interval(const char** str, unsigned max, uint8_t* min_ptr, uint8_t* max_ptr) {
+    unsigned lo, hi;
+
+    if (parse_rule_number(str, max, &lo) < 0 || strncmp(*str, "..", 2) != 0) {
+        return -1;
+    }
+
+    *str += 2;
+
+    if (parse_rule_number(str, max, &hi) < 0 || lo > hi) {
+        return -1;
+    }
+
+    *min_ptr = (uint8_t)lo;
+    *max_ptr = (uint8_t)hi;
+
+    return 0;
+}
+
+// con rango 1 una regla de rango es una B/S más, que usa los kernels de
+// siempre: se pasan los intervalos a máscaras de vecinos, quitando a las
+// cuentas de supervivencia la propia célula si middle
+static void
+parse_rule_masks(grid_rule_t* rule) {
+    unsigned self = rule->middle ? 1 : 0;
+
+    rule->birth = 0;
+    rule->survive = 0;
+
+    for (unsigned count = 0; count <= RULE_MAX_NEIGHBORS; ++count) {
+        if (count >= rule->birth_min && count <= rule->birth_max) {
+            rule->birth |= (uint16_t)(1U << count);
+        }
+        if (count + self >= rule->survive_min && count + self <= rule->survive_max) {
+            rule->survive |= (uint16_t)(1U << count);
+        }
+    }
+}
+
+// reglas Larger than Life como R5,C0,M1,S34..58,B34..45 con los campos
+// en ese orden, y al final NM opcional, que es el único vecindario
+static int
+parse_rule_range(const char* haystack, grid_rule_t* rule) {
+    const char* str = haystack + 1;
+    unsigned range, states, middle;
+
+    *rule = (grid_rule_t) {.states = 2};
+
+    int status = parse_rule_number(&str, RULE_MAX_RANGE, &range);
+
+    if (status == 0) {
+        status = parse_rule_field(&str, 'C');
+    }
+    if (status == 0) {
+        status = parse_rule_number(&str, UINT8_MAX, &states);
+    }
+    if (status == 0) {
+        status = parse_rule_field(&str, 'M');
+    }
+    if (status == 0) {
+        status = parse_rule_number(&str, 1, &middle);
+    }
+
+    unsigned cells = ((2 * range) + 1) * ((2 * range) + 1);
+
+    if (status == 0) {
+        status = parse_rule_field(&str, 'S');
+    }
+    if (status == 0) {
+        status = parse_rule_interval(&str, cells, &rule->survive_min, &rule->survive_max);
+    }
+    if (status == 0) {
+        status = parse_rule_field(&str, 'B');
+    }
+    if (status == 0) {
+        status = parse_rule_interval(&str, cells, &rule->birth_min, &rule->birth_max);
+    }
+    if (status == 0 && *str == ',') {
+        status = parse_rule_field(&str, 'N');
+
+        if (status == 0) {
+            if (*str != 'M' && *str != 'm') {
+                fprintf(stderr, "cells: only the Moore neighbourhood NM is supported in range rules\n");
+                return -1;
+            }
+
+            ++str;
+        }
+    }
+
+    if (status < 0 || *str != '\0' || range == 0) {
+        fprintf(stderr, "cells: malformed rule '%s', expected R<range>,C<states>,M<0|1>,S<min>..<max>,B<min>..<max> "
+                "with range up to %d, such as R5,C0,M1,S34..58,B34..45\n", haystack, RULE_MAX_RANGE);
+        return -1;
+    }
+
+    // C0 y C1 son la forma de escribir dos estados
+    if (states > 2) {
+        fprintf(stderr, "cells: range rules with more than 2 states are not supported\n");
+        return -1;
+    }
+
+    if (rule->birth_min == 0) {
+        fprintf(stderr, "cells: rules with B0 are not supported\n");
+        return -1;
+    }
+
+    rule->range = (uint8_t)range;
+    rule->middle = middle != 0;
+
+    if (range == 1) {
+        parse_rule_masks(rule);
+    }
+
+    return 0;
+}
+
+// reglas Generations de la forma S/B/C, como /2/3 o 345/2/4, con las
+// cuentas de supervivencia, las de nacimiento y el número de estados
+static int
+parse_rule_generations(const char* haystack, grid_rule_t* rule) {
+    const char* str = haystack;
+    unsigned states = 0;
+
+    *rule = (grid_rule_t) {.range = 1};
+
+    int status = parse_rule_digits(&str, &rule->survive);
+
+    if (status == 0 && *str == '/') {
+        ++str;
+        status = parse_rule_digits(&str, &rule->birth);
+    } else {
+        status = -1;
+    }
+
+    if (status == 0 && *str == '/') {
+        ++str;
+        status = parse_rule_number(&str, UINT8_MAX, &states);
+    } else {
+        status = -1;
+    }
+
+    if (status < 0 || *str != '\0') {
+        fprintf(stderr, "cells: malformed rule '%s', expected <survive>/<birth>/<states> such as /2/3\n", haystack);
+        return -1;
+    }
+
+    rule->states = (uint8_t)states;
+
+    return 0;
+}
+
+// reglas de la forma B3/S23, en cualquier orden y con minúsculas, y
+// detrás de ellas /C<states> opcional para una regla Generations
+static int
+parse_rule(const char* haystack, grid_rule_t* rule) {
+    int status;
+
+    if (haystack[0] == 'R' || haystack[0] == 'r') {
+        return parse_rule_range(haystack, rule);
+    }
+
+    if (haystack[0] == '/' || (haystack[0] >= '0' && haystack[0] <= '9')) {
+        status = parse_rule_generations(haystack, rule);
+    } else {
+        const char* str = haystack;
+
+        *rule = (grid_rule_t) {.states = 2, .range = 1};
+
+        status = str[0] == 'S' || str[0] == 's'
+            ? parse_rule_counts(&str, 'S', &rule->survive)
+            : parse_rule_counts(&str, 'B', &rule->birth);
+
+        if (status == 0 && *str == '/') {
+            ++str;
+            status = haystack[0] == 'S' || haystack[0] == 's'
+                ? parse_rule_counts(&str, 'B', &rule->birth)
+                : parse_rule_counts(&str, 'S', &rule->survive);
+        } else {
+            status = -1;
+        }
+
+        if (status == 0 && *str == '/') {
+            unsigned states;
+
+            ++str;
+            status = parse_rule_prefix(&str, 'C');
+
+            if (status == 0) {
+                status = parse_rule_number(&str, UINT8_MAX, &states);
+                rule->states = (uint8_t)states;
+            }
+        }
+
+        if (status < 0 || *str != '\0') {
+            fprintf(stderr, "cells: malformed rule '%s', expected B<counts>/S<counts> such as B3/S23, "
+                    "optionally followed by /C<states>\n", haystack);
+            return -1;
+        }
+    }
+
+    if (status < 0) {
+        return -1;
+    }
+
+    if (rule->states < 2 || rule->states > RULE_MAX_STATES) {
+        fprintf(stderr, "cells: rules must have from 2 to %d states\n", RULE_MAX_STATES);
+        return -1;
+    }
+
+    // con B0 el vacío infinito se enciende entero cada generación
+    if ((rule->birth & 1U) != 0) {
+        fprintf(stderr, "cells: rules with B0 are not supported\n");
+        return -1;
+    }
+
+    return 0;
+}
+
+static const char* const ENGINE_NAME[ENGINE_LEN] = {"bitboard", "hashlife", "lut", "list", "auto"};
+
+static int
+parse_engine(const char* haystack, sim_engine_t* engine) {
+    for (size_t i = 0; i < ENGINE_LEN; ++i) {
+        if (strcmp(haystack, ENGINE_NAME[i]) == 0) {
+            *engine = (sim_engine_t)i;
+            return 0;
+        }
+    }
+
+    fprintf(stderr, "cells: unknown engine '%s', expected bitboard, hashlife, lut, list or auto\n", haystack);
+    return -1;
+}
+
+static const char* const LAYOUT_NAME[LAYOUT_LEN] = {"rows", "morton", "bitset"};
+
+static int
+parse_layout(const char* haystack, grid_layout_t* layout) {
+    for (size_t i = 0; i < LAYOUT_LEN; ++i) {
+        if (strcmp(haystack, LAYOUT_NAME[i]) == 0) {
+            *layout = (grid_layout_t)i;
+            return 0;
+        }
+    }
+
+    fprintf(stderr, "cells: unknown layout '%s', expected rows, morton or bitset\n", haystack);
+    return -1;
+}
+
 int
 config_make(config_t** config_ptr, int argc, char* const* argv) {   /* NOLINT */
     bool has_ifile = false;
@@ -120,12 +521,13 @@ config_make(config_t** config_ptr, int argc, char* const* argv) {   /* NOLINT */
     char* ofile = NULL;
 
     bool use_torus = false;
+    bool verbose = false;
 
     bool silent = false;
     bool graphic = false;
 
     bool has_steps = false;
-    uint32_t steps = STEPS_INFINITE;
+    uint64_t steps = STEPS_INFINITE;
 
     uint32_t delay = DEFAULT_DELAY;
 
@@ -136,6 +538,22 @@ config_make(config_t** config_ptr, int argc, char* const* argv) {   /* NOLINT */
     uint8_t color_dark  = DEFAULT_COLOR_DARK;
     uint8_t color_light = DEFAULT_COLOR_LIGHT;
 
+    uint64_t threads = DEFAULT_THREADS;
+    uint64_t tile = 0;
+    uint64_t time_block = 1;
+    uint64_t memo = 0;
+    grid_kernel_t kernel = KERNEL_AUTO;
+    grid_sum_t sum = SUM_AUTO;
+    grid_layout_t layout = LAYOUT_ROWS;
+    bool random = false;
+    bool unbounded = false;
+    bool in_place = false;
+    uint64_t ranks = 1;
+    uint64_t rank = 0;
+    bool has_rank = false;
+    const char* socket = NULL;
+    sim_engine_t engine = ENGINE_BITBOARD;
+    grid_rule_t rule = RULE_LIFE;
 
     static struct option longopts[] = {
         {"dim",     required_argument, 0, ARG_DIMS},
@@ -145,13 +563,28 @@ config_make(config_t** config_ptr, int argc, char* const* argv) {   /* NOLINT */
         {"shape",   required_argument, 0, ARG_SHAPE},
         {"color",   required_argument, 0, ARG_COLOR},
         {"delay",   required_argument, 0, ARG_DELAY},
+        {"threads", required_argument, 0, ARG_THREADS},
+        {"tile",    required_argument, 0, ARG_TILE},
+        {"kernel",  required_argument, 0, ARG_KERNEL},
+        {"unbounded", no_argument,     0, ARG_UNBOUNDED},
+        {"engine",  required_argument, 0, ARG_ENGINE},
+        {"rule",    required_argument, 0, ARG_RULE},
+        {"time-block", required_argument, 0, ARG_TIME_BLOCK},
+        {"layout",  required_argument, 0, ARG_LAYOUT},
+        {"random",  no_argument,       0, ARG_RANDOM},
+        {"sum",     required_argument, 0, ARG_SUM},
+        {"memo",    required_argument, 0, ARG_MEMO},
+        {"in-place", no_argument,      0, ARG_IN_PLACE},
+        {"ranks",   required_argument, 0, ARG_RANKS},
+        {"rank",    required_argument, 0, ARG_RANK},
+        {"socket",  required_argument, 0, ARG_SOCKET},
         {0,0,0,0}
     };
 
     int opt;
     int longidx;
 
-    while ((opt = getopt_long(argc, argv, "+i:n:o:", longopts, &longidx)) != -1) {
+    while ((opt = getopt_long(argc, argv, "+i:n:o:v", longopts, &longidx)) != -1) {
         switch (opt) {
         case 'i':
             if (has_dims) {
@@ -166,7 +599,7 @@ config_make(config_t** config_ptr, int argc, char* const* argv) {   /* NOLINT */
                 fprintf(stderr, "cells: -n option must be provided after -i or --dims\n");
                 return -1;
             }
-            if (parse_u32(optarg, &steps, "steps") < 0) {
+            if (parse_u64(optarg, &steps, "steps") < 0) {
                 return -1;
             }
             if (steps == 0) {
@@ -178,6 +611,9 @@ config_make(config_t** config_ptr, int argc, char* const* argv) {   /* NOLINT */
         case 'o':
             ofile = optarg;
             break;
+        case 'v':
+            verbose = true;
+            break;
         case ARG_DIMS:
             if (has_ifile) {
                 fprintf(stderr, "cells: --dims option is incompatible with option -i\n");
@@ -281,6 +717,98 @@ config_make(config_t** config_ptr, int argc, char* const* argv) {   /* NOLINT */
                 return -1;
             }
             break;
+        case ARG_THREADS:
+            if (parse_u64(optarg, &threads, "threads") < 0) {
+                return -1;
+            }
+            if (threads == 0 || threads > MAX_THREADS) {
+                fprintf(stderr, "cells: --threads must be between 1 and %d\n", MAX_THREADS);
+                return -1;
+            }
+            break;
+        case ARG_TILE:
+            if (parse_u64(optarg, &tile, "tile") < 0) {
+                return -1;
+            }
+            if (tile == 0) {
+                fprintf(stderr, "cells: --tile must be greater than zero\n");
+                return -1;
+            }
+            break;
+        case ARG_MEMO:
+            if (parse_u64(optarg, &memo, "memo") < 0) {
+                return -1;
+            }
+            if (memo == 0 || memo > MAX_MEMO_MIB) {
+                fprintf(stderr, "cells: --memo must be between 1 and %d MiB\n", MAX_MEMO_MIB);
+                return -1;
+            }
+            break;
+        case ARG_KERNEL:
+            if (parse_kernel(optarg, &kernel) < 0) {
+                return -1;
+            }
+            break;
+        case ARG_SUM:
+            if (parse_sum(optarg, &sum) < 0) {
+                return -1;
+            }
+            break;
+        case ARG_UNBOUNDED:
+            unbounded = true;
+            break;
+        case ARG_IN_PLACE:
+            in_place = true;
+            break;
+        case ARG_RANKS:
+            if (parse_u64(optarg, &ranks, "ranks") < 0) {
+                return -1;
+            }
+            if (ranks == 0 || ranks > MAX_RANKS) {
+                fprintf(stderr, "cells: --ranks must be between 1 and %d\n", MAX_RANKS);
+                return -1;
+            }
+            break;
+        case ARG_RANK:
+            if (parse_u64(optarg, &rank, "rank") < 0) {
+                return -1;
+            }
+            has_rank = true;
+            break;
+        case ARG_SOCKET:
+            socket = optarg;
+            break;
+        case ARG_ENGINE:
+            if (parse_engine(optarg, &engine) < 0) {
+                return -1;
+            }
+            break;
+        case ARG_RULE:
+            if (parse_rule(optarg, &rule) < 0) {
+                return -1;
+            }
+            break;
+        case ARG_LAYOUT:
+            if (parse_layout(optarg, &layout) < 0) {
+                return -1;
+            }
+            break;
+        case ARG_RANDOM:
+            if (!has_dims) {
+                fprintf(stderr, "cells: --random option requires --dims\n");
+                return -1;
+            }
+            random = true;
+            break;
+        case ARG_TIME_BLOCK:
+            if (parse_u64(optarg, &time_block, "time block") < 0) {
+                return -1;
+            }
+            if (time_block == 0 || time_block > MAX_TIME_BLOCK) {
+                fprintf(stderr, "cells: --time-block must be between 1 and %d\n", MAX_TIME_BLOCK);
+                return -1;
+            }
+            break;
         default:
             fprintf(stderr, "cells: unknown or malformed option\n");
             return -1;
@@ -295,8 +823,272 @@ config_make(config_t** config_ptr, int argc, char* const* argv) {   /* NOLINT */
         fprintf(stderr, "cells: -n <steps> is required when using -i\n");
         return -1;
     }
+    if (unbounded && use_torus) {
+        fprintf(stderr, "cells: --unbounded option is incompatible with --torus\n");
+        return -1;
+    }
+
+    // hashlife salta generaciones sin pasar por las intermedias y trabaja
+    // sobre el plano infinito, así que solo tiene sentido sin interfaz
+    if (engine == ENGINE_HASHLIFE) {
+        if (!silent) {
+            fprintf(stderr, "cells: --engine hashlife requires --silent\n");
+            return -1;
+        }
+        if (use_torus) {
+            fprintf(stderr, "cells: --engine hashlife is incompatible with --torus\n");
+            return -1;
+        }
+        unbounded = true;
+    }
+
+    // el plano infinito avanza sus chunks en un solo hilo y sin tiles
+    if (unbounded) {
+        if (threads > 1) {
+            fprintf(stderr, "cells: --threads is incompatible with --unbounded and --engine hashlife\n");
+            return -1;
+        }
+        if (tile > 0) {
+            fprintf(stderr, "cells: --tile is incompatible with --unbounded and --engine hashlife\n");
+            return -1;
+        }
+    }
+
+    // los rangos mayores que 1 solo tienen kernel en el grid de chunks
+    // acotado, que le pasa los 3x3 chunks del vecindario generación a
+    // generación, y ese kernel no tiene variantes ni caché
+    if (rule.range > 1) {
+        if (unbounded) {
+            fprintf(stderr, "cells: range rules are incompatible with --unbounded and --engine hashlife\n");
+            return -1;
+        }
+        if (engine != ENGINE_BITBOARD) {
+            fprintf(stderr, "cells: range rules require --engine bitboard\n");
+            return -1;
+        }
+        if (layout == LAYOUT_BITSET) {
+            fprintf(stderr, "cells: range rules are incompatible with --layout bitset\n");
+            return -1;
+        }
+        if (kernel != KERNEL_AUTO || sum != SUM_AUTO) {
+            fprintf(stderr, "cells: range rules are incompatible with --kernel and --sum\n");
+            return -1;
+        }
+        if (time_block > 1) {
+            fprintf(stderr, "cells: range rules are incompatible with --time-block\n");
+            return -1;
+        }
+        if (memo > 0) {
+            fprintf(stderr, "cells: range rules are incompatible with --memo\n");
+            return -1;
+        }
+        if (in_place) {
+            fprintf(stderr, "cells: range rules are incompatible with --in-place\n");
+            return -1;
+        }
+    }
+
+    // la edad de las reglas Generations solo la guarda el grid de chunks
+    // acotado, y sus bordes y bloques no la copian
+    if (rule.states > 2) {
+        if (unbounded) {
+            fprintf(stderr, "cells: Generations rules are incompatible with --unbounded and --engine hashlife\n");
+            return -1;
+        }
+        if (engine != ENGINE_BITBOARD && engine != ENGINE_LUT) {
+            fprintf(stderr, "cells: Generations rules require --engine bitboard or lut\n");
+            return -1;
+        }
+        if (layout == LAYOUT_BITSET) {
+            fprintf(stderr, "cells: Generations rules are incompatible with --layout bitset\n");
+            return -1;
+        }
+        if (time_block > 1) {
+            fprintf(stderr, "cells: Generations rules are incompatible with --time-block\n");
+            return -1;
+        }
+        if (in_place) {
+            fprintf(stderr, "cells: Generations rules are incompatible with --in-place\n");
+            return -1;
+        }
+    }
+
+    // lut es el mismo grid que bitboard pero con el kernel de tabla
+    if (engine == ENGINE_LUT) {
+        if (kernel != KERNEL_AUTO && kernel != KERNEL_LUT) {
+            fprintf(stderr, "cells: --engine lut is incompatible with --kernel\n");
+            return -1;
+        }
+        kernel = KERNEL_LUT;
+    }
+
+    // la tabla saca el resultado de cada bloque sin sumar vecinos
+    if (kernel == KERNEL_LUT && sum != SUM_AUTO) {
+        fprintf(stderr, "cells: --sum is incompatible with the lut kernel\n");
+        return -1;
+    }
+
+    // la lista vive en el mismo grid acotado que el bitboard, al que pasa
+    // con el resto de opciones cuando el patrón se vuelve denso
+    if (engine == ENGINE_LIST && unbounded) {
+        fprintf(stderr, "cells: --engine list is incompatible with --unbounded\n");
+        return -1;
+    }
+
+    // auto mueve el grid acotado entre el bitboard, la lista y la caché
+    // según lo que mide cada periodo, así que no hay interfaz que pinte
+    // a la vez que el grid cambia, ni bloques que salten generaciones
+    if (engine == ENGINE_AUTO) {
+        if (!silent) {
+            fprintf(stderr, "cells: --engine auto requires --silent\n");
+            return -1;
+        }
+        if (unbounded) {
+            fprintf(stderr, "cells: --engine auto is incompatible with --unbounded\n");
+            return -1;
+        }
+        if (layout == LAYOUT_BITSET) {
+            fprintf(stderr, "cells: --engine auto is incompatible with --layout bitset\n");
+            return -1;
+        }
+        if (time_block > 1) {
+            fprintf(stderr, "cells: --engine auto is incompatible with --time-block\n");
+            return -1;
+        }
+        if (memo == 0) {
+            memo = DEFAULT_AUTO_MEMO_MIB;
+        }
+    }
+
+    if (layout != LAYOUT_ROWS && unbounded) {
+        fprintf(stderr, "cells: --layout is incompatible with --unbounded and --engine hashlife\n");
+        return -1;
+    }
+
+    // las filas de bits no tienen chunks, así que no hay tiles, bloques
+    // temporales ni tabla por chunk, y el kernel siempre suma por filas
+    if (layout == LAYOUT_BITSET) {
+        if (kernel == KERNEL_LUT) {
+            fprintf(stderr, "cells: --layout bitset is incompatible with the lut kernel\n");
+            return -1;
+        }
+        if (sum != SUM_AUTO) {
+            fprintf(stderr, "cells: --layout bitset is incompatible with --sum\n");
+            return -1;
+        }
+        if (tile > 0) {
+            fprintf(stderr, "cells: --layout bitset is incompatible with --tile\n");
+            return -1;
+        }
+        if (time_block > 1) {
+            fprintf(stderr, "cells: --layout bitset is incompatible with --time-block\n");
+            return -1;
+        }
+    }
+
+    // la caché guarda el resultado de cada vecindario de 3x3 chunks, que
+    // solo existe en el grid de chunks y generación a generación
+    if (memo > 0) {
+        if (unbounded) {
+            fprintf(stderr, "cells: --memo is incompatible with --unbounded and --engine hashlife\n");
+            return -1;
+        }
+        if (layout == LAYOUT_BITSET) {
+            fprintf(stderr, "cells: --memo is incompatible with --layout bitset\n");
+            return -1;
+        }
+        if (time_block > 1) {
+            fprintf(stderr, "cells: --memo is incompatible with --time-block\n");
+            return -1;
+        }
+    }
+
+    // en el sitio no hay segundo buffer de chunks, que es donde escriben
+    // los bloques temporales y de donde sale si un vecindario se repite,
+    // y las filas se escriben en orden, así que no hay tiles que robar
+    if (in_place) {
+        if (unbounded) {
+            fprintf(stderr, "cells: --in-place is incompatible with --unbounded and --engine hashlife\n");
+            return -1;
+        }
+        if (layout == LAYOUT_BITSET) {
+            fprintf(stderr, "cells: --in-place is incompatible with --layout bitset\n");
+            return -1;
+        }
+        if (tile > 0) {
+            fprintf(stderr, "cells: --in-place is incompatible with --tile\n");
+            return -1;
+        }
+        if (time_block > 1) {
+            fprintf(stderr, "cells: --in-place is incompatible with --time-block\n");
+            return -1;
+        }
+    }
+
+    // los bloques avanzan varias generaciones sin pasar por la interfaz
+    // y se apoyan en el almacenamiento denso del grid acotado
+    if (time_block > 1) {
+        if (!silent) {
+            fprintf(stderr, "cells: --time-block requires --silent\n");
+            return -1;
+        }
+        if (unbounded) {
+            fprintf(stderr, "cells: --time-block is incompatible with --unbounded and --engine hashlife\n");
+            return -1;
+        }
+    }
+
+    // cada proceso guarda solo su franja del grid de chunks acotado y la
+    // avanza a la vez que los demás, así que no hay interfaz, ni motores
+    // que cambien el almacenamiento, ni hilos, tiles o bloques dentro de
+    // la franja, que se calcula por filas para solapar el intercambio
+    if (ranks > 1) {
+        if (!has_rank || socket == NULL) {
+            fprintf(stderr, "cells: --ranks requires --rank and --socket\n");
+            return -1;
+        }
+        if (rank >= ranks) {
+            fprintf(stderr, "cells: --rank must be lower than --ranks\n");
+            return -1;
+        }
+        if (!silent) {
+            fprintf(stderr, "cells: --ranks requires --silent\n");
+            return -1;
+        }
+        if (unbounded) {
+            fprintf(stderr, "cells: --ranks is incompatible with --unbounded and --engine hashlife\n");
+            return -1;
+        }
+        if (engine != ENGINE_BITBOARD && engine != ENGINE_LUT) {
+            fprintf(stderr, "cells: --ranks requires --engine bitboard or lut\n");
+            return -1;
+        }
+        if (layout != LAYOUT_ROWS) {
+            fprintf(stderr, "cells: --ranks is incompatible with --layout\n");
+            return -1;
+        }
+        if (random) {
+            fprintf(stderr, "cells: --ranks is incompatible with --random\n");
+            return -1;
+        }
+        if (threads > 1 || tile > 0) {
+            fprintf(stderr, "cells: --ranks is incompatible with --threads and --tile\n");
+            return -1;
+        }
+        if (time_block > 1) {
+            fprintf(stderr, "cells: --ranks is incompatible with --time-block\n");
+            return -1;
+        }
+        if (in_place) {
+            fprintf(stderr, "cells: --ranks is incompatible with --in-place\n");
+            return -1;
+        }
+    } else if (has_rank || socket != NULL) {
+        fprintf(stderr, "cells: --rank and --socket require --ranks\n");
+        return -1;
+    }
 
-    *config_ptr = malloc(sizeof(config_t));
+    *config_ptr = safe_malloc(sizeof(config_t));
 
     if (*config_ptr == NULL) {
         fprintf(stderr, "cells: failed to allocate memory for config\n");
@@ -314,9 +1106,29 @@ config_make(config_t** config_ptr, int argc, char* const* argv) {   /* NOLINT */
         .steps = steps,
         .delay = delay,
         .mode = silent ? MODE_SILENT : MODE_GRAPHIC,
+        .engine = engine,
         .color_dark = color_dark,
         .color_light = color_light,
-        .use_torus = use_torus
+        .use_torus = use_torus,
+        .random = random,
+        .verbose = verbose,
+        .grid_opts = {
+            .threads = threads,
+            .tile = tile,
+            .kernel = kernel,
+            .sum = sum,
+            .layout = layout,
+            .rule = rule,
+            .time_block = time_block,
+            .unbounded = unbounded,
+            .list = engine == ENGINE_LIST || engine == ENGINE_AUTO,
+            .adaptive = engine == ENGINE_AUTO,
+            .in_place = in_place,
+            .memo_bytes = (size_t)memo * MIB,
+            .rank = (size_t)rank,
+            .ranks = (size_t)ranks,
+            .socket = socket,
+        },
     };
 
     return 0;
@@ -5,6 +5,8 @@
 #include <stdint.h>
 #include <time.h>
 
+#include "../grid/grid.h"
+
 
 #define STEPS_INFINITE 0
 
@@ -13,6 +15,15 @@ typedef enum sim_mode {
     MODE_GRAPHIC,
 } sim_mode_t;
 
+typedef enum sim_engine {
+    ENGINE_BITBOARD,
+    ENGINE_HASHLIFE,
+    ENGINE_LUT,
+    ENGINE_LIST,
+    ENGINE_AUTO,
+    ENGINE_LEN,
+} sim_engine_t;
+
 typedef struct config {
     const char* input_file;
     const char* output_file;
@@ -21,12 +32,16 @@ typedef struct config {
     size_t shape_len;
     size_t chunk_rows;
     size_t chunk_cols;
-    uint32_t steps;
+    uint64_t steps;
     uint32_t delay;
     sim_mode_t mode;
+    sim_engine_t engine;
     uint8_t color_light;
     uint8_t color_dark;
     bool use_torus;
+    bool random;
+    bool verbose;
+    grid_opts_t grid_opts;
 } config_t;
 
 extern int
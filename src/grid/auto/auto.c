@@ -0,0 +1,282 @@
+#include "auto.h"
+
+#include <stdbool.h>
+#include <stddef.h>
+#include <stdint.h>
+#include <stdio.h>
+#include <stdlib.h>
+
+#include "../../syscalls/syscalls.h"
+
+
+// costes de partida en ns, medidos con un solo hilo: un chunk calculado
+// por el kernel, el mismo con la caché, una célula viva de la lista y lo
+// que cuesta por generación cada chunk del grid solo por recorrer las
+// marcas y los mapas de ocupación. los tres primeros se sustituyen por
+// los medidos en cuanto el motor corre un periodo
+#define AUTO_CHUNK_NS 95.0
+#define AUTO_MEMO_NS 750.0
+#define AUTO_CELL_NS 100.0
+#define AUTO_AREA_NS 0.6
+
+// al salir de la lista no se sabe cuántos chunks calculará el bitboard:
+// se supone un chunk ocupado por cada AUTO_CELLS_PER_CHUNK células y
+// AUTO_SPREAD chunks calculados por cada uno contando sus vecinos
+#define AUTO_CELLS_PER_CHUNK 32.0
+#define AUTO_SPREAD 4.0
+
+// solo se cambia si el motor nuevo promete ser AUTO_MARGIN veces más
+// rápido, y un cambio que resulta más lento deja volver enseguida al
+// motor anterior y multiplica por AUTO_BACKOFF_GROWTH los periodos que
+// hay que esperar para volver a probar el nuevo, hasta AUTO_BACKOFF_MAX,
+// así una caché que no compensa se vuelve a probar cada vez menos
+#define AUTO_MARGIN 1.5
+#define AUTO_BACKOFF_GROWTH 4
+#define AUTO_BACKOFF_MAX 256
+
+#define AUTO_SWITCHES_INIT 16
+
+static const char* const AUTO_ENGINE_NAME[AUTO_ENGINE_LEN] = {"bitboard", "list", "memo"};
+
+// coste por unidad de trabajo de cada motor, lo único que se aprende:
+// lo que hará cada uno sale de multiplicarlo por el trabajo del periodo
+struct auto_model {
+    double cost[AUTO_ENGINE_LEN];
+    bool measured[AUTO_ENGINE_LEN];
+    bool memo;
+
+    size_t wait[AUTO_ENGINE_LEN];
+    size_t backoff[AUTO_ENGINE_LEN];
+
+    double last_rate;
+    auto_engine_t from;
+    bool reverted;
+
+    grid_switch_t* switches;
+    size_t switches_len;
+    size_t switches_cap;
+    bool pending;
+};
+
+int
+auto_make(auto_model_t** model_ptr, bool memo) {
+    *model_ptr = safe_malloc(sizeof(auto_model_t));
+
+    if (*model_ptr == NULL) {
+        fprintf(stderr, "error: failed to allocate memory for engine selection\n");
+        return -1;
+    }
+
+    **model_ptr = (auto_model_t) {
+        .cost = {AUTO_CHUNK_NS, AUTO_CELL_NS, AUTO_MEMO_NS},
+        .measured = {false, false, false},
+        .memo = memo,
+
+        .wait = {0, 0, 0},
+        .backoff = {1, 1, 1},
+
+        .last_rate = 0.0,
+        .from = AUTO_DENSE,
+        .reverted = false,
+
+        .switches = NULL,
+        .switches_len = 0,
+        .switches_cap = 0,
+        .pending = false,
+    };
+
+    return 0;
+}
+
+void
+auto_destroy(auto_model_t** model_ptr) {
+    free((*model_ptr)->switches);
+    free(*model_ptr);
+
+    *model_ptr = NULL;
+}
+
+const char*
+auto_engine_name(auto_engine_t engine) {
+    return AUTO_ENGINE_NAME[engine];
+}
+
+int
+auto_record(auto_model_t* model, size_t generation, auto_engine_t from, auto_engine_t to) {
+    if (model->switches_len == model->switches_cap) {
+        size_t cap = model->switches_cap == 0 ? AUTO_SWITCHES_INIT : 2 * model->switches_cap;
+        grid_switch_t* switches = safe_realloc(model->switches, cap * sizeof(grid_switch_t));
+
+        if (switches == NULL) {
+            fprintf(stderr, "error: failed to allocate memory for engine switches\n");
+            return -1;
+        }
+
+        model->switches = switches;
+        model->switches_cap = cap;
+    }
+
+    model->switches[model->switches_len++] = (grid_switch_t) {
+        .generation = generation,
+        .from = AUTO_ENGINE_NAME[from],
+        .to = AUTO_ENGINE_NAME[to],
+        .before = model->last_rate,
+        .after = 0.0,
+    };
+
+    model->from = from;
+    model->pending = true;
+
+    return 0;
+}
+
+bool
+auto_pending(const auto_model_t* model) {
+    return model->pending;
+}
+
+// el periodo acaba de medir el motor en el que corrió, y su coste
+// por unidad se mezcla a partes iguales con el que ya se tenía
+static void
+auto_learn(auto_model_t* model, const auto_sample_t* sample) {
+    double elapsed = (double)sample->elapsed_ms * 1e6;
+    double units;
+
+    if (sample->engine == AUTO_LIST) {
+        units = (double)sample->population * (double)sample->generations;
+    } else {
+        // lo que cuesta recorrer el grid no depende de los chunks calculados
+        double area = AUTO_AREA_NS * (double)sample->chunks * (double)sample->generations;
+
+        elapsed = elapsed > 2 * area ? elapsed - area : elapsed / 2;
+        units = (double)sample->computed;
+    }
+
+    if (units < 1.0 || sample->elapsed_ms <= 0) {
+        return;
+    }
+
+    double cost = elapsed / units;
+
+    if (model->measured[sample->engine]) {
+        cost = (model->cost[sample->engine] + cost) / 2;
+    }
+
+    model->cost[sample->engine] = cost;
+    model->measured[sample->engine] = true;
+}
+
+auto_engine_t
+auto_decide(auto_model_t* model, const auto_sample_t* sample) {
+    double rate = (double)sample->generations * MS_IN_SC / (double)(sample->elapsed_ms > 0 ? sample->elapsed_ms : 1);
+
+    // el primer periodo tras un cambio dice si de verdad compensó, y si
+    // no, se vuelve sin más al motor anterior, vuelta que solo se mide
+    bool revert = false;
+
+    if (model->pending) {
+        grid_switch_t* last = &model->switches[model->switches_len - 1];
+        last->after = rate;
+
+        if (model->reverted) {
+            model->reverted = false;
+        } else if (rate < last->before) {
+            size_t backoff = AUTO_BACKOFF_GROWTH * model->backoff[sample->engine];
+
+            model->backoff[sample->engine] = backoff < AUTO_BACKOFF_MAX ? backoff : AUTO_BACKOFF_MAX;
+            revert = true;
+        } else {
+            model->backoff[sample->engine] = 1;
+        }
+
+        model->pending = false;
+    }
+
+    model->last_rate = rate;
+    auto_learn(model, sample);
+
+    if (revert) {
+        auto_engine_t back = model->from;
+        model->wait[sample->engine] = model->backoff[sample->engine];
+
+        if (auto_record(model, sample->generation, sample->engine, back) < 0) {
+            return sample->engine;
+        }
+
+        model->reverted = true;
+
+        return back;
+    }
+
+    // chunks que calcularía el bitboard en cada generación
+    double gens = (double)sample->generations;
+    double chunks = (double)sample->chunks;
+    double work = (double)sample->computed / gens;
+
+    if (sample->engine == AUTO_LIST) {
+        work = AUTO_SPREAD * (double)sample->population / AUTO_CELLS_PER_CHUNK;
+        work = work < chunks ? work : chunks;
+    }
+
+    double predicted[AUTO_ENGINE_LEN] = {
+        (model->cost[AUTO_DENSE] * work) + (AUTO_AREA_NS * chunks),
+        model->cost[AUTO_LIST] * (double)sample->population,
+        (model->cost[AUTO_MEMO] * work) + (AUTO_AREA_NS * chunks),
+    };
+
+    // lo que gana la caché depende de cuántos vecindarios se repiten, que
+    // no se puede predecir, así que se prueba un periodo cada vez que vence
+    // su espera y lo medido solo vale hasta la siguiente prueba
+    bool probe = false;
+
+    if (model->memo && sample->engine == AUTO_DENSE && model->wait[AUTO_MEMO] == 0 && sample->computed > 0) {
+        probe = true;
+        model->measured[AUTO_MEMO] = false;
+    }
+
+    auto_engine_t best = sample->engine;
+
+    for (size_t i = 0; i < AUTO_ENGINE_LEN; ++i) {
+        auto_engine_t engine = (auto_engine_t)i;
+
+        if (engine == sample->engine || model->wait[engine] > 0) {
+            continue;
+        }
+
+        if ((engine == AUTO_MEMO && !model->memo) || (engine == AUTO_LIST && !sample->list_fits)) {
+            continue;
+        }
+
+        if (predicted[engine] * AUTO_MARGIN < predicted[best]) {
+            best = engine;
+        }
+    }
+
+    if (best == sample->engine && probe) {
+        best = AUTO_MEMO;
+    }
+
+    for (size_t i = 0; i < AUTO_ENGINE_LEN; ++i) {
+        if (model->wait[i] > 0) {
+            model->wait[i] -= 1;
+        }
+    }
+
+    if (best != sample->engine) {
+        // no se vuelve al motor que se deja hasta que pase su espera
+        model->wait[sample->engine] = model->backoff[sample->engine];
+
+        if (auto_record(model, sample->generation, sample->engine, best) < 0) {
+            return sample->engine;
+        }
+    }
+
+    return best;
+}
+
+size_t
+auto_switches(const auto_model_t* model, const grid_switch_t** switches) {
+    *switches = model->switches;
+
+    return model->switches_len;
+}
@@ -0,0 +1,66 @@
+#ifndef INCLUDE_AUTO_AUTO_H_
+#define INCLUDE_AUTO_AUTO_H_
+
+#include <stdbool.h>
+#include <stddef.h>
+#include <stdint.h>
+
+#include "../grid.h"
+
+
+// motores entre los que puede moverse el grid acotado sin cambiar de
+// resultado: chunks densos, lista de células y chunks con la caché
+typedef enum auto_engine {
+    AUTO_DENSE,
+    AUTO_LIST,
+    AUTO_MEMO,
+    AUTO_ENGINE_LEN,
+} auto_engine_t;
+
+// lo medido en un periodo de generaciones con un mismo motor. computed
+// son los chunks calculados, o las células tocadas con la lista, y
+// list_fits dice si la población cabe bajo el umbral de la lista
+typedef struct auto_sample {
+    auto_engine_t engine;
+    size_t generation;
+    size_t generations;
+    int64_t elapsed_ms;
+    size_t population;
+    size_t computed;
+    size_t chunks;
+    bool list_fits;
+} auto_sample_t;
+
+typedef struct auto_model auto_model_t;
+
+extern int
+auto_make(auto_model_t** model_ptr, bool memo);
+
+extern void
+auto_destroy(auto_model_t** model_ptr);
+
+extern const char*
+auto_engine_name(auto_engine_t engine);
+
+// ajusta el coste del motor del periodo y devuelve el motor en el que
+// conviene seguir, que si no es el actual queda apuntado como cambio
+extern auto_engine_t
+auto_decide(auto_model_t* model, const auto_sample_t* sample);
+
+// apunta un cambio que no decidió el modelo, como pasar al bitboard
+// al llenar el grid de células al azar
+extern int
+auto_record(auto_model_t* model, size_t generation, auto_engine_t from, auto_engine_t to);
+
+// si el último cambio aún no se ha medido, lo que hace el grid con el
+// primer periodo del motor nuevo, que es más corto
+extern bool
+auto_pending(const auto_model_t* model);
+
+// cambios apuntados, con el rendimiento del periodo anterior y el del
+// primero con el motor nuevo, a 0 mientras no se ha medido
+extern size_t
+auto_switches(const auto_model_t* model, const grid_switch_t** switches);
+
+
+#endif  // INCLUDE_AUTO_AUTO_H_
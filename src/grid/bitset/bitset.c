@@ -0,0 +1,405 @@
+#include "bitset.h"
+
+#include <assert.h>
+#include <stdatomic.h>
+#include <stdbool.h>
+#include <stddef.h>
+#include <stdint.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#include "../splitmix/splitmix.h"
+
+#include "../../syscalls/syscalls.h"
+
+
+#define BITSET_WORD_BITS 64U
+#define BITSET_WORD_POW 6U
+
+// cada fila del grid es una tira de palabras de 64 bits de lado a lado,
+// con el bit i de la palabra w en la columna 64 * w + i. las filas se
+// rellenan hasta un múltiplo de KERNEL_STREAM_WORDS palabras y antes de
+// cada una quedan KERNEL_STREAM_WORDS palabras libres, así cada fila
+// empieza alineada y tiene una palabra legible a cada lado
+//
+// como en el grid de chunks hay una fila fantasma arriba y otra abajo, a
+// cero en el modo acotado y copia del borde opuesto en el toroidal. en el
+// toroidal además se escriben antes de cada generación la columna C - 1
+// en el bit alto de la palabra de la izquierda y la columna 0 en el bit C,
+// que cae en el relleno o en la palabra de la derecha
+struct bitset {
+    size_t rows;
+    size_t cols;
+    size_t words;
+    size_t stride;
+
+    uint64_t* cells;
+    uint64_t* cells_next;
+    safe_mapping_t maps[2];
+    int64_t alloc_ms;
+
+    // bits del grid en cada palabra de la fila, el kernel deja a cero el resto
+    uint64_t* mask;
+
+    // changed[r + 1] indica si la fila r cambió en la última generación,
+    // con el mismo significado que las marcas de los chunks del grid
+    uint8_t* changed;
+    uint8_t* changed_next;
+    bool torus_last;
+
+    kernel_stream_fn_t kernel;
+    grid_rule_t rule;
+
+    pool_t* pool;
+
+    _Atomic size_t computed;
+};
+
+static inline uint64_t*
+bitset_row(const bitset_t* bitset, uint64_t* cells, size_t padded_row) {
+    return cells + (padded_row * bitset->stride) + KERNEL_STREAM_WORDS;
+}
+
+// cada trabajador escribe primero en las páginas de su franja de filas
+static void
+bitset_first_touch(void* arg, size_t worker, size_t workers) {
+    bitset_t* bitset = arg;
+
+    size_t begin = worker == 0 ? 0 : (bitset->rows * worker / workers) + 1;
+    size_t end = worker + 1 == workers ? bitset->rows + 3 : (bitset->rows * (worker + 1) / workers) + 1;
+
+    for (size_t i = 0; i < 2; ++i) {
+        char* bytes = bitset->maps[i].ptr;
+        size_t page = bitset->maps[i].page_size;
+
+        size_t first = ((begin * bitset->stride * sizeof(uint64_t)) + page - 1) & ~(page - 1);
+        size_t last = end * bitset->stride * sizeof(uint64_t);
+
+        for (size_t offset = first; offset < last; offset += page) {
+            bytes[offset] = 0;
+        }
+    }
+}
+
+int
+bitset_make(bitset_t** bitset_ptr, size_t rows, size_t cols, kernel_stream_fn_t kernel, grid_rule_t rule, pool_t* pool) {
+    size_t used = (cols + BITSET_WORD_BITS - 1) >> BITSET_WORD_POW;
+    size_t words = (used + KERNEL_STREAM_WORDS - 1) / KERNEL_STREAM_WORDS * KERNEL_STREAM_WORDS;
+    size_t stride = words + KERNEL_STREAM_WORDS;
+
+    // las dos filas fantasma y una más para la palabra de la derecha
+    // de la fila fantasma de abajo
+    size_t len, alloc_size;
+    if (__builtin_mul_overflow(rows + 3, stride, &len) ||
+        __builtin_mul_overflow(len, sizeof(uint64_t), &alloc_size)) {
+        fprintf(stderr, "error: grid dimensions too large\n");
+        return -1;
+    }
+
+    int64_t alloc_start = safe_time();
+    safe_mapping_t maps[2] = {0};
+
+    if (safe_map(&maps[0], alloc_size) < 0 || safe_map(&maps[1], alloc_size) < 0) {
+        safe_unmap(&maps[0]);
+
+        fprintf(stderr, "error: failed to allocate memory for grid rows\n");
+        return -1;
+    }
+
+    uint64_t* mask = safe_calloc(words, sizeof(uint64_t));
+    uint8_t* changed = safe_calloc(rows + 2, sizeof(uint8_t));
+    uint8_t* changed_next = safe_calloc(rows + 2, sizeof(uint8_t));
+
+    if (mask == NULL || changed == NULL || changed_next == NULL) {
+        safe_unmap(&maps[0]);
+        safe_unmap(&maps[1]);
+        free(mask);
+        free(changed);
+        free(changed_next);
+
+        fprintf(stderr, "error: failed to allocate memory for row flags\n");
+        return -1;
+    }
+
+    for (size_t i = 0; i < (cols >> BITSET_WORD_POW); ++i) {
+        mask[i] = UINT64_MAX;
+    }
+    if ((cols & (BITSET_WORD_BITS - 1)) != 0) {
+        mask[cols >> BITSET_WORD_POW] = (UINT64_C(1) << (cols & (BITSET_WORD_BITS - 1))) - 1;
+    }
+
+    *bitset_ptr = safe_malloc(sizeof(bitset_t));
+
+    if (*bitset_ptr == NULL) {
+        safe_unmap(&maps[0]);
+        safe_unmap(&maps[1]);
+        free(mask);
+        free(changed);
+        free(changed_next);
+
+        fprintf(stderr, "error: failed to allocate memory for grid rows\n");
+        return -1;
+    }
+
+    **bitset_ptr = (bitset_t) {
+        .rows = rows,
+        .cols = cols,
+        .words = words,
+        .stride = stride,
+
+        .cells = maps[0].ptr,
+        .cells_next = maps[1].ptr,
+        .maps = {maps[0], maps[1]},
+        .alloc_ms = 0,
+
+        .mask = mask,
+
+        .changed = changed,
+        .changed_next = changed_next,
+        .torus_last = false,
+
+        .kernel = kernel,
+        .rule = rule,
+
+        .pool = pool,
+    };
+
+    atomic_init(&(*bitset_ptr)->computed, 0);
+
+    if (pool != NULL) {
+        pool_run(pool, bitset_first_touch, *bitset_ptr);
+    }
+
+    (*bitset_ptr)->alloc_ms = safe_time() - alloc_start;
+
+    return 0;
+}
+
+void
+bitset_destroy(bitset_t** bitset_ptr) {
+    safe_unmap(&(*bitset_ptr)->maps[0]);
+    safe_unmap(&(*bitset_ptr)->maps[1]);
+    free((*bitset_ptr)->mask);
+    free((*bitset_ptr)->changed);
+    free((*bitset_ptr)->changed_next);
+    free(*bitset_ptr);
+
+    *bitset_ptr = NULL;
+}
+
+int
+bitset_set_alive(bitset_t* bitset, size_t row, size_t col) {
+    if (row >= bitset->rows || col >= bitset->cols) {
+        return -1;
+    }
+
+    bitset_row(bitset, bitset->cells, row + 1)[col >> BITSET_WORD_POW] |= UINT64_C(1) << (col & (BITSET_WORD_BITS - 1));
+    bitset->changed[row + 1] = 1;
+
+    return 0;
+}
+
+int
+bitset_set_dead(bitset_t* bitset, size_t row, size_t col) {
+    if (row >= bitset->rows || col >= bitset->cols) {
+        return -1;
+    }
+
+    bitset_row(bitset, bitset->cells, row + 1)[col >> BITSET_WORD_POW] &= ~(UINT64_C(1) << (col & (BITSET_WORD_BITS - 1)));
+    bitset->changed[row + 1] = 1;
+
+    return 0;
+}
+
+int
+bitset_cell_state(const bitset_t* bitset, cell_state_t* state, size_t row, size_t col) {
+    if (row >= bitset->rows || col >= bitset->cols) {
+        return -1;
+    }
+
+    uint64_t word = bitset_row(bitset, bitset->cells, row + 1)[col >> BITSET_WORD_POW];
+    *state = (cell_state_t)((word >> (col & (BITSET_WORD_BITS - 1))) & 1U);
+
+    return 0;
+}
+
+void
+bitset_randomize(bitset_t* bitset, uint64_t seed) {
+    for (size_t row = 1; row <= bitset->rows; ++row) {
+        uint64_t* words = bitset_row(bitset, bitset->cells, row);
+
+        for (size_t i = 0; i < bitset->words; ++i) {
+            words[i] = seed & bitset->mask[i];
+            splitmix64_next(&seed);
+        }
+
+        bitset->changed[row] = 1;
+    }
+}
+
+void
+bitset_clear(bitset_t* bitset) {
+    // al vaciar los dos buffers vuelven a ser iguales
+    // y ninguna fila necesita recalcularse
+    size_t len = (bitset->rows + 3) * bitset->stride * sizeof(uint64_t);
+
+    memset(bitset->cells, 0, len);
+    memset(bitset->cells_next, 0, len);
+    memset(bitset->changed, 0, bitset->rows + 2);
+}
+
+// escribe en cada fila del buffer actual las columnas del borde opuesto
+// y copia en las filas fantasma las del borde opuesto del grid
+static void
+bitset_wrap(const bitset_t* bitset) {
+    size_t last_word = (bitset->cols - 1) >> BITSET_WORD_POW;
+    size_t last_bit = (bitset->cols - 1) & (BITSET_WORD_BITS - 1);
+    size_t after_word = bitset->cols >> BITSET_WORD_POW;
+    size_t after_bit = bitset->cols & (BITSET_WORD_BITS - 1);
+
+    for (size_t row = 1; row <= bitset->rows; ++row) {
+        uint64_t* words = bitset_row(bitset, bitset->cells, row);
+
+        uint64_t first = words[0] & 1U;
+        uint64_t last = (words[last_word] >> last_bit) & 1U;
+
+        words[-1] = last << (BITSET_WORD_BITS - 1);
+        words[after_word] = (words[after_word] & ~(UINT64_C(1) << after_bit)) | (first << after_bit);
+    }
+
+    size_t span = (bitset->words + 2) * sizeof(uint64_t);
+
+    memcpy(bitset_row(bitset, bitset->cells, 0) - 1, bitset_row(bitset, bitset->cells, bitset->rows) - 1, span);
+    memcpy(bitset_row(bitset, bitset->cells, bitset->rows + 1) - 1, bitset_row(bitset, bitset->cells, 1) - 1, span);
+
+    bitset->changed[0] = bitset->changed[bitset->rows];
+    bitset->changed[bitset->rows + 1] = bitset->changed[1];
+}
+
+// deja a cero en los dos buffers todo lo que no es del grid
+static void
+bitset_unwrap(const bitset_t* bitset) {
+    size_t after_word = bitset->cols >> BITSET_WORD_POW;
+    size_t after_bit = bitset->cols & (BITSET_WORD_BITS - 1);
+    size_t span = (bitset->words + 2) * sizeof(uint64_t);
+
+    uint64_t* buffers[] = {bitset->cells, bitset->cells_next};
+    uint8_t* flags[] = {bitset->changed, bitset->changed_next};
+
+    for (size_t i = 0; i < 2; ++i) {
+        for (size_t row = 1; row <= bitset->rows; ++row) {
+            uint64_t* words = bitset_row(bitset, buffers[i], row);
+
+            words[-1] = 0;
+            words[after_word] &= ~(UINT64_C(1) << after_bit);
+        }
+
+        memset(bitset_row(bitset, buffers[i], 0) - 1, 0, span);
+        memset(bitset_row(bitset, buffers[i], bitset->rows + 1) - 1, 0, span);
+
+        flags[i][0] = 0;
+        flags[i][bitset->rows + 1] = 0;
+    }
+}
+
+static void
+bitset_update_band(void* arg, size_t worker, size_t workers) {
+    bitset_t* bitset = arg;
+
+    size_t begin = (bitset->rows * worker / workers) + 1;
+    size_t end = (bitset->rows * (worker + 1) / workers) + 1;
+
+    const uint8_t* changed = bitset->changed;
+    size_t computed = 0;
+
+    for (size_t row = begin; row < end; ++row) {
+        // si ni la fila ni sus vecinas cambiaron sigue igual, y como su
+        // marca está a 0 el otro buffer ya guarda ese mismo estado
+        if (!(changed[row - 1] | changed[row] | changed[row + 1])) {
+            bitset->changed_next[row] = 0;
+            continue;
+        }
+
+        bitset->changed_next[row] = bitset->kernel(
+            bitset_row(bitset, bitset->cells, row - 1),
+            bitset_row(bitset, bitset->cells, row),
+            bitset_row(bitset, bitset->cells, row + 1),
+            bitset->mask,
+            bitset_row(bitset, bitset->cells_next, row),
+            bitset->words,
+            &bitset->rule);
+
+        computed += 1;
+    }
+
+    atomic_fetch_add_explicit(&bitset->computed, computed, memory_order_relaxed);
+}
+
+void
+bitset_update(bitset_t* bitset, bool torus) {
+    // al cambiar de topología los vecinos de los bordes son otros
+    if (torus != bitset->torus_last) {
+        memset(bitset->changed + 1, 1, bitset->rows);
+        bitset->torus_last = torus;
+
+        if (!torus) {
+            bitset_unwrap(bitset);
+        }
+    }
+
+    if (torus) {
+        bitset_wrap(bitset);
+    }
+
+    atomic_store(&bitset->computed, 0);
+
+    if (bitset->pool == NULL) {
+        bitset_update_band(bitset, 0, 1);
+    } else {
+        pool_run(bitset->pool, bitset_update_band, bitset);
+    }
+
+    uint64_t* cells = bitset->cells;
+    bitset->cells = bitset->cells_next;
+    bitset->cells_next = cells;
+
+    uint8_t* changed = bitset->changed;
+    bitset->changed = bitset->changed_next;
+    bitset->changed_next = changed;
+}
+
+size_t
+bitset_rows(const bitset_t* bitset) {
+    return bitset->rows;
+}
+
+size_t
+bitset_computed(const bitset_t* bitset) {
+    return atomic_load(&bitset->computed);
+}
+
+void
+bitset_memory(const bitset_t* bitset, grid_memory_t* memory) {
+    *memory = (grid_memory_t) {
+        .bytes = bitset->maps[0].len + bitset->maps[1].len,
+        .page_size = bitset->maps[0].page_size,
+        .transparent = bitset->maps[0].transparent,
+        .alloc_ms = bitset->alloc_ms,
+    };
+}
+
+int
+bitset_visit_alive(const bitset_t* bitset, grid_visit_fn_t visit, void* ctx) {
+    for (size_t row = 0; row < bitset->rows; ++row) {
+        const uint64_t* words = bitset_row(bitset, bitset->cells, row + 1);
+
+        for (size_t i = 0; i < bitset->words; ++i) {
+            for (uint64_t word = words[i] & bitset->mask[i]; word != 0; word &= word - 1) {
+                visit(ctx, (int64_t)row, (int64_t)((i << BITSET_WORD_POW) + (size_t)__builtin_ctzll(word)));
+            }
+        }
+    }
+
+    return 0;
+}
@@ -0,0 +1,52 @@
+#ifndef INCLUDE_BITSET_BITSET_H_
+#define INCLUDE_BITSET_BITSET_H_
+
+#include <stdbool.h>
+#include <stddef.h>
+#include <stdint.h>
+
+#include "../grid.h"
+#include "../kernel/kernel.h"
+#include "../pool/pool.h"
+
+
+typedef struct bitset bitset_t;
+
+extern int
+bitset_make(bitset_t** bitset_ptr, size_t rows, size_t cols, kernel_stream_fn_t kernel, grid_rule_t rule, pool_t* pool);
+
+extern void
+bitset_destroy(bitset_t** bitset_ptr);
+
+extern int
+bitset_set_alive(bitset_t* bitset, size_t row, size_t col);
+
+extern int
+bitset_set_dead(bitset_t* bitset, size_t row, size_t col);
+
+extern int
+bitset_cell_state(const bitset_t* bitset, cell_state_t* state, size_t row, size_t col);
+
+extern void
+bitset_randomize(bitset_t* bitset, uint64_t seed);
+
+extern void
+bitset_clear(bitset_t* bitset);
+
+extern void
+bitset_update(bitset_t* bitset, bool torus);
+
+extern size_t
+bitset_rows(const bitset_t* bitset);
+
+extern size_t
+bitset_computed(const bitset_t* bitset);
+
+extern void
+bitset_memory(const bitset_t* bitset, grid_memory_t* memory);
+
+extern int
+bitset_visit_alive(const bitset_t* bitset, grid_visit_fn_t visit, void* ctx);
+
+
+#endif  // INCLUDE_BITSET_BITSET_H_
@@ -0,0 +1,99 @@
+#ifndef INCLUDE_GRID_CHUNK_H_
+#define INCLUDE_GRID_CHUNK_H_
+
+#include <stdbool.h>
+#include <stddef.h>
+#include <stdint.h>
+#include <string.h>
+
+#include "grid.h"
+
+
+#if CHUNK_BITS == 32
+typedef uint32_t chunk_word_t;
+#define CHUNK_POW 5
+#elif CHUNK_BITS == 64
+typedef uint64_t chunk_word_t;
+#define CHUNK_POW 6
+#elif CHUNK_BITS == 128
+__extension__ typedef unsigned __int128 chunk_word_t;
+#define CHUNK_POW 7
+#else
+#error "CHUNK_BITS must be 32, 64 or 128"
+#endif
+
+#define CHUNK_LAST (CHUNK_SIZE - 1)
+#define CHUNK_ONE ((chunk_word_t)1)
+
+// una columna de chunks vista por el kernel: la última fila del chunk
+// de arriba, las CHUNK_SIZE filas del chunk y la primera del de abajo
+#define CHUNK_PADDED (CHUNK_SIZE + 2)
+
+typedef struct chunk {
+    chunk_word_t rows[CHUNK_SIZE];
+} chunk_t;
+
+static inline void
+chunk_set_alive(chunk_t* chunk, size_t row, size_t col) {
+    chunk->rows[row] |= (CHUNK_ONE << col);
+}
+
+static inline void
+chunk_set_dead(chunk_t* chunk, size_t row, size_t col) {
+    chunk->rows[row] &= ~(CHUNK_ONE << col);
+}
+
+static inline cell_state_t
+chunk_get(const chunk_t* chunk, size_t row, size_t col) {
+    return (cell_state_t)((chunk->rows[row] >> col) & CHUNK_ONE);
+}
+
+// índice del bit vivo más bajo de una fila, que no puede ser cero
+static inline size_t
+chunk_word_ctz(chunk_word_t word) {
+#if CHUNK_BITS > 64
+    uint64_t low = (uint64_t)word;
+
+    return low != 0 ? (size_t)__builtin_ctzll(low) : 64 + (size_t)__builtin_ctzll((uint64_t)(word >> 64U));
+#else
+    return (size_t)__builtin_ctzll((unsigned long long)word);
+#endif
+}
+
+static inline size_t
+chunk_population(const chunk_t* chunk) {
+    size_t count = 0;
+
+    for (size_t row = 0; row < CHUNK_SIZE; ++row) {
+#if CHUNK_BITS > 64
+        count += (size_t)__builtin_popcountll((uint64_t)chunk->rows[row]);
+        count += (size_t)__builtin_popcountll((uint64_t)(chunk->rows[row] >> 64U));
+#else
+        count += (size_t)__builtin_popcountll((unsigned long long)chunk->rows[row]);
+#endif
+    }
+
+    return count;
+}
+
+static inline bool
+chunk_empty(const chunk_t* chunk) {
+    chunk_word_t any = 0;
+
+    for (size_t row = 0; row < CHUNK_SIZE; ++row) {
+        any |= chunk->rows[row];
+    }
+
+    return any == 0;
+}
+
+static inline void
+chunk_column(const chunk_t* n, const chunk_t* c, const chunk_t* s, chunk_word_t* column) {
+    column[0] = n->rows[CHUNK_LAST];
+    column[CHUNK_PADDED - 1] = s->rows[0];
+
+    memcpy(column + 1, c->rows, sizeof(c->rows));
+}
+
+
+#endif  // INCLUDE_GRID_CHUNK_H_
@@ -1,56 +1,94 @@
 #include "grid.h"
+#include "grid_impl.h"
 
 #include <assert.h>
+#include <inttypes.h>
 #include <stddef.h>
 #include <stdint.h>
 #include <stdio.h>
 #include <stdlib.h>
 #include <string.h>
+#include <stdatomic.h>
 #include <stdbool.h>
 
+#include "chunk.h"
+#include "auto/auto.h"
+#include "bitset/bitset.h"
+#include "inplace/inplace.h"
+#include "list/list.h"
+#include "memo/memo.h"
+#include "kernel/kernel.h"
+#include "kernel/kernel_gen.h"
+#include "kernel/kernel_ltl.h"
+#include "pool/deque.h"
+#include "pool/pool.h"
+#include "rank/band.h"
+#include "rank/rank.h"
+#include "sparse/sparse.h"
 #include "splitmix/splitmix.h"
+#include "timeblock/timeblock.h"
 
 #include "../syscalls/syscalls.h"
 
 
-#define CHUNK_LAST 31
-#define CHUNK_POW 5
+// la lista de células pasa al bitboard cuando vive más de una de cada
+// GRID_LIST_SPARSITY células, a partir de ahí los chunks salen más baratos
+#define GRID_LIST_SPARSITY ((size_t)8192)
 
-#define CHUNK_ROW_BIT(row, col) (((row) >> (col)) & 1U)
+// con --engine auto se mide cada GRID_AUTO_PERIOD generaciones, o más si
+// no han pasado GRID_AUTO_MIN_MS, que el reloj solo llega a milisegundos.
+// tras un cambio basta con GRID_AUTO_PROBE para saber si compensó, y
+// probar un motor que resulta lento cuesta poco
+#define GRID_AUTO_PERIOD ((size_t)64)
+#define GRID_AUTO_PROBE ((size_t)8)
+#define GRID_AUTO_MIN_MS 20
 
-typedef struct chunk {
-    uint32_t rows[CHUNK_SIZE];
-} chunk_t;
+// células que se mandan de una vez al recoger el grid de varios procesos
 
-static inline void
-chunk_set_alive(chunk_t* chunk, size_t row, size_t col) {
-    chunk->rows[row] |= (1U << col);
-}
-
-static inline void
-chunk_set_dead(chunk_t* chunk, size_t row, size_t col) {
-    chunk->rows[row] &= ~(1U << col);
-}
+// los vecinos en morton se obtienen sumando o restando uno sobre los bits
+// de una sola coordenada, rellenando los de la otra para que el acarreo
+// los atraviese, y si la coordenada da la vuelta se cambia de bloque
+static inline size_t
+grid_morton_step(const grid_t* grid, size_t idx, size_t lane, size_t other, size_t one, bool forward) {
+    size_t block = idx >> (2 * GRID_MORTON_POW);
+    size_t inner = idx & (GRID_MORTON_LEN - 1);
+    size_t jump = lane == GRID_MORTON_COLS ? 1 : grid->stride;
+
+    if (forward) {
+        block += (inner & lane) == lane ? jump : 0;
+        inner = (((inner | other) + one) & lane) | (inner & other);
+    } else {
+        block -= (inner & lane) == 0 ? jump : 0;
+        inner = (((inner & lane) - one) & lane) | (inner & other);
+    }
 
-static inline cell_state_t
-chunk_get(const chunk_t* chunk, size_t row, size_t col) {
-    return (chunk->rows[row] >> col) & 1U;
+    return (block << (2 * GRID_MORTON_POW)) | inner;
 }
 
+// la distancia de un chunk a sus vecinos solo depende de su posición
+// dentro del bloque, así que se calcula una vez para los 64 casos y se
+// guarda de noroeste a sureste
+static void
+grid_morton_table(const grid_t* grid, ptrdiff_t* table) {
+    for (size_t inner = 0; inner < GRID_MORTON_LEN; ++inner) {
+        // se parte de un bloque con vecinos a todos los lados
+        size_t idx = ((grid->stride + 1) << (2 * GRID_MORTON_POW)) | inner;
 
-struct grid {
-    size_t chunk_rows;
-    size_t chunk_cols;
+        size_t up = grid_morton_step(grid, idx, GRID_MORTON_ROWS, GRID_MORTON_COLS, 2, false);
+        size_t down = grid_morton_step(grid, idx, GRID_MORTON_ROWS, GRID_MORTON_COLS, 2, true);
 
-    size_t chunks_len;
+        size_t rows[] = {up, idx, down};
+        ptrdiff_t* ngb = &table[inner * 9];
 
-    chunk_t* chunks;
-    chunk_t* chunks_next;
-};
+        for (size_t i = 0; i < 3; ++i) {
+            size_t west = grid_morton_step(grid, rows[i], GRID_MORTON_COLS, GRID_MORTON_ROWS, 1, false);
+            size_t east = grid_morton_step(grid, rows[i], GRID_MORTON_COLS, GRID_MORTON_ROWS, 1, true);
 
-static inline size_t
-grid_chunk_idx(const grid_t* grid, size_t chunk_row, size_t chunk_col) {
-    return (chunk_row * grid->chunk_cols) + chunk_col;
+            ngb[(3 * i) + 0] = (ptrdiff_t)west - (ptrdiff_t)idx;
+            ngb[(3 * i) + 1] = (ptrdiff_t)rows[i] - (ptrdiff_t)idx;
+            ngb[(3 * i) + 2] = (ptrdiff_t)east - (ptrdiff_t)idx;
+        }
+    }
 }
 
 static int
@@ -80,331 +118,408 @@ grid_inner_coords(
     return 0;
 }
 
-static inline size_t
-wrap_coord(size_t coord, int delta, size_t max) {
-    int signed_coord = (int)coord + delta;
+// primera palabra de occ desde from que no está a cero, u occ_len si no
+// queda ninguna. las del nivel superior que apuntan a palabras vacías se
+// apagan por el camino, así que solo se llama entre generaciones
+static size_t
+grid_occ_next(const grid_t* grid, uint64_t* occ, size_t from) {
+    uint64_t* top = occ + grid->occ_len;
+
+    while (from < grid->occ_len) {
+        size_t top_idx = from >> GRID_OCC_POW;
+        uint64_t bits = top[top_idx] & (~(uint64_t)0 << (from & (GRID_OCC_BITS - 1)));
+
+        if (bits == 0) {
+            from = (top_idx + 1) << GRID_OCC_POW;
+            continue;
+        }
+
+        size_t word = (top_idx << GRID_OCC_POW) + (size_t)__builtin_ctzll(bits);
 
-    if (signed_coord < 0) {
-        return max - 1;
+        if (occ[word] != 0) {
+            return word;
+        }
+
+        top[top_idx] &= ~((uint64_t)1 << (word & (GRID_OCC_BITS - 1)));
+        from = word + 1;
     }
 
-    if (signed_coord >= (int)max) {
-        return 0;
+    return grid->occ_len;
+}
+
+static void
+grid_update_chunk(const grid_t* grid, size_t idx, size_t bit, grid_worker_t* worker) {
+    size_t ngb[9];
+    grid_neighbourhood(grid, idx, ngb);
+
+    const uint8_t* changed = grid->changed;
+
+    // gracias al anillo fantasma los 8 vecinos siempre existen,
+    // así que no hace falta distinguir bordes ni topologías
+    uint8_t active = changed[ngb[0]] | changed[ngb[1]] | changed[ngb[2]]
+                   | changed[ngb[3]] | changed[ngb[4]] | changed[ngb[5]]
+                   | changed[ngb[6]] | changed[ngb[7]] | changed[ngb[8]];
+
+    // nada ha cambiado alrededor, el chunk sigue igual y chunks_next ya
+    // contiene su estado, no hace falta ni calcularlo ni copiarlo
+    if (!active) {
+        grid->changed_next[idx] = 0;
+        return;
+    }
+
+    // el vecindario se repite cada dos generaciones, así que la siguiente
+    // es la que ya guarda chunks_next y cambia respecto a la actual
+    // exactamente igual que la actual cambió respecto a ella
+    if (!(active & (GRID_CHANGED2 | GRID_EDITED))) {
+        grid->changed_next[idx] = changed[idx] & GRID_CHANGED;
+        worker->periodic += 1;
+        return;
+    }
+
+    const chunk_t* chunks = grid->chunks;
+
+    // chunks_next guarda la generación anterior, que al compararla con la
+    // nueva dice si el chunk se repite cada dos. uno editado no sale de
+    // ella, así que se marca como distinto para que se calcule otra vez
+    chunk_t before = grid->chunks_next[idx];
+    chunk_word_t* next = grid->chunks_next[idx].rows;
+
+    unsigned flags;
+    bool aging = grid->ages != NULL;
+
+    if (grid->rule.range > 1) {
+        // con más rango el kernel lee varias filas de los vecinos de
+        // arriba y abajo, así que recibe el vecindario entero
+        const chunk_t* near[9];
+
+        for (size_t i = 0; i < 9; ++i) {
+            near[i] = &chunks[ngb[i]];
+        }
+
+        flags = kernel_ltl(near, next, &grid->rule);
+    } else {
+        chunk_word_t west[CHUNK_PADDED];
+        chunk_word_t centre[CHUNK_PADDED];
+        chunk_word_t east[CHUNK_PADDED];
+
+        chunk_column(&chunks[ngb[0]], &chunks[ngb[3]], &chunks[ngb[6]], west);
+        chunk_column(&chunks[ngb[1]], &chunks[ngb[4]], &chunks[ngb[7]], centre);
+        chunk_column(&chunks[ngb[2]], &chunks[ngb[5]], &chunks[ngb[8]], east);
+
+        if (worker->memo == NULL || !memo_lookup(worker->memo, west, centre, east, next, &flags)) {
+            flags = grid->kernel(west, centre, east, next, &grid->rule);
+
+            if (worker->memo != NULL) {
+                memo_store(worker->memo, next, flags);
+            }
+        }
+    }
+
+    // la regla B/S solo ha visto las vivas, la edad hace el resto
+    if (aging) {
+        flags = kernel_gen_decay(chunks[idx].rows, next, &grid->ages[idx * grid->age_planes], &grid->rule);
+    }
+
+    bool flag = (flags & KERNEL_CHANGED) != 0;
+    bool alive = (flags & KERNEL_ALIVE) != 0;
+
+    // el kernel ya dice si quedan células vivas, y el bit de chunks_next
+    // solo se toca cuando cambia
+    if (alive != grid_occ_get(grid->occ_next, bit)) {
+        grid_occ_put(grid, grid->occ_next, bit, alive);
     }
 
-    return (size_t)signed_coord;
+    // si no cambió, difiere de la de hace dos justo cuando la actual lo
+    // hacía. la edad no tiene la de hace dos, así que con ella todo chunk
+    // que cambia se da por distinto
+    bool flag2 = (changed[idx] & GRID_EDITED) || (flag && aging)
+        || (flag ? memcmp(&before, next, sizeof(chunk_t)) != 0 : (changed[idx] & GRID_CHANGED) != 0);
+
+    grid->changed_next[idx] = (uint8_t)((flag ? GRID_CHANGED : 0U) | (flag2 ? GRID_CHANGED2 : 0U));
+    worker->active += 1;
 }
 
 static void
-grid_update_chunk_toroidal(const grid_t* grid, size_t crow, size_t ccol) {  /* NOLINT */
-    size_t chunk_idx = grid_chunk_idx(grid, crow, ccol);
-
-    chunk_t* c = &grid->chunks[chunk_idx];
-
-    // se toman los 8 vecinos del chunk actual, que en el caso
-    // de un espacio toroidal, siempre existen
-    size_t crow_n = wrap_coord(crow, -1, grid->chunk_rows);
-    size_t crow_s = wrap_coord(crow, +1, grid->chunk_rows);
-    size_t ccol_w = wrap_coord(ccol, -1, grid->chunk_cols);
-    size_t ccol_e = wrap_coord(ccol, +1, grid->chunk_cols);
-
-    chunk_t* n  = &grid->chunks[grid_chunk_idx(grid, crow_n,   ccol)];
-    chunk_t* s  = &grid->chunks[grid_chunk_idx(grid, crow_s,   ccol)];
-    chunk_t* w  = &grid->chunks[grid_chunk_idx(grid,   crow, ccol_w)];
-    chunk_t* e  = &grid->chunks[grid_chunk_idx(grid,   crow, ccol_e)];
-    chunk_t* nw = &grid->chunks[grid_chunk_idx(grid, crow_n, ccol_w)];
-    chunk_t* ne = &grid->chunks[grid_chunk_idx(grid, crow_n, ccol_e)];
-    chunk_t* sw = &grid->chunks[grid_chunk_idx(grid, crow_s, ccol_w)];
-    chunk_t* se = &grid->chunks[grid_chunk_idx(grid, crow_s, ccol_e)];
-
-    // ahora cada fila de 32 células, gracias al uso de
-    // máscaras de bits, se va a poder realizar en paralelo
-    // se hará todo en el bucle inline ya que su eficiencia es fundamental
-    for (size_t row = 0; row < CHUNK_SIZE; ++row) {
-        uint32_t curr = c->rows[row];
-
-        // obtenemos las 8 filas vecinas a la actual
-        uint32_t left       = w->rows[row];
-        uint32_t right      = e->rows[row];
-
-        uint32_t top        = row ==          0 ?  n->rows[CHUNK_LAST] : c->rows[row - 1];
-        uint32_t bot        = row == CHUNK_LAST ?  s->rows[         0] : c->rows[row + 1];
-        uint32_t top_left   = row ==          0 ? nw->rows[CHUNK_LAST] : w->rows[row - 1];
-        uint32_t top_right  = row ==          0 ? ne->rows[CHUNK_LAST] : e->rows[row - 1];
-        uint32_t bot_left   = row == CHUNK_LAST ? sw->rows[         0] : w->rows[row + 1];
-        uint32_t bot_right  = row == CHUNK_LAST ? se->rows[         0] : e->rows[row + 1];
-
-        // se quiere obtener 8 palabras de 32 bits, una con todos los vecinos a la izqda de la palabras
-        // actual, de forma que el vecino izquierdo del bit i esté también en la posición i de la palabra,
-        // otra con los vecinos de la dcha, y así para los 8 vecinos.
-        uint32_t ngb_n = top;
-        uint32_t ngb_s = bot;
-
-        uint32_t ngb_e  =  curr >> 1U | (CHUNK_ROW_BIT(    right, 0) << CHUNK_LAST);
-        uint32_t ngb_ne = ngb_n >> 1U | (CHUNK_ROW_BIT(top_right, 0) << CHUNK_LAST);
-        uint32_t ngb_se = ngb_s >> 1U | (CHUNK_ROW_BIT(bot_right, 0) << CHUNK_LAST);
-       
-        uint32_t ngb_w  =  curr << 1U | CHUNK_ROW_BIT(    left, CHUNK_LAST);
-        uint32_t ngb_nw = ngb_n << 1U | CHUNK_ROW_BIT(top_left, CHUNK_LAST);
-        uint32_t ngb_sw = ngb_s << 1U | CHUNK_ROW_BIT(bot_left, CHUNK_LAST);
-
-        // ahora se suman los bits de los 8 vecinos en paralelo
-        // en 4 paralabras de 32 bits. p0 contiene el primer bit de la 
-        // suma, p1 el segundo etc. se necesitan 4 palabras ya que los vecinos
-        // pueden sumar 8 como máximo, con representacion b1000
-        // se hará la típica suma binaria con XOR y carry
-        uint32_t p0 = 0;
-        uint32_t p1 = 0;
-        uint32_t p2 = 0;
-        uint32_t p3 = 0;
-
-        // aquí se define la suma binaria que,
-        // al igual que antes, de hará inline
-        #define SUM_NEIGHBOR_ROW(ngb) do {      \
-            uint32_t carry1 = p0 & (ngb);       \
-            p0 ^= (ngb);                        \
-                                                \
-            uint32_t carry2 = p1 & (carry1);    \
-            p1 ^= (carry1);                     \
-                                                \
-            uint32_t carry3 = p2 & (carry2);    \
-            p2 ^= (carry2);                     \
-                                                \
-            p3 ^= (carry3);                     \
-        } while(0)                              \
-
-        // se realiza la suma de los 8 vecinos
-        SUM_NEIGHBOR_ROW(ngb_n);
-        SUM_NEIGHBOR_ROW(ngb_s);
-        SUM_NEIGHBOR_ROW(ngb_e);
-        SUM_NEIGHBOR_ROW(ngb_w);
-        SUM_NEIGHBOR_ROW(ngb_nw);
-        SUM_NEIGHBOR_ROW(ngb_ne);
-        SUM_NEIGHBOR_ROW(ngb_sw);
-        SUM_NEIGHBOR_ROW(ngb_se);
-
-        #undef SUM_NEIGHBOR_ROW
-
-        // detectar 2 células vivas
-        uint32_t eq1 = ~p1 & ~p2 & ~p3 & p0;
-
-        // detectar 2 células vivas
-        uint32_t eq2 = p1 & ~p2 & ~p3 & ~p0;
-
-        // detectar 3 células vivas
-        uint32_t eq3 = p0 & p1 & ~p2 & ~p3;
-
-        uint32_t eq4 = ~p1 & p2 & ~p3 & ~p0;
-
-        // detectar 3 células vivas
-        uint32_t eq5 = p0 & ~p1 & p2 & ~p3;
-
-        // detectar 3 células vivas
-        uint32_t eq6 = ~p0 & p1 & p2 & ~p3;
-
-        // detectar 3 células vivas
-        uint32_t eq7 = p0 & p1 & p2 & ~p3;
-
-        // detectar 3 células vivas
-        uint32_t eq8 = ~p0 & ~p1 & ~p2 & p3;
-
-        // siguiente generación de la fila
-        uint32_t next = (curr | eq1 | eq2 | eq3 | eq4 | eq5 | eq6 | eq7) & ~eq8;
-
-        grid->chunks_next[chunk_idx].rows[row] = next;
+grid_halo_copy(const grid_t* grid, size_t dst_row, size_t dst_col, size_t src_row, size_t src_col) {
+    size_t dst = grid_idx(grid, dst_row, dst_col);
+    size_t src = grid_idx(grid, src_row, src_col);
+
+    grid->chunks[dst] = grid->chunks[src];
+    grid->changed[dst] = grid->changed[src];
+
+    grid_occ_put(grid, grid->occ, grid_occ_bit(grid, dst_row, dst_col), grid_occ_get(grid->occ, grid_occ_bit(grid, src_row, src_col)));
+}
+
+// copia en las columnas del anillo las del borde opuesto
+void
+grid_halo_wrap_cols(const grid_t* grid) {
+    size_t rows = grid->chunk_rows;
+    size_t cols = grid->chunk_cols;
+
+    for (size_t row = 1; row <= rows; ++row) {
+        grid_halo_copy(grid, row, 0,        row, cols);
+        grid_halo_copy(grid, row, cols + 1, row, 1);
     }
 }
 
+// copia en el anillo fantasma el borde opuesto del grid, incluidas las
+// esquinas, para que el toro se vea como un grid acotado más
 static void
-grid_update_chunk(const grid_t* grid, size_t crow, size_t ccol) {   /* NOLINT */
-    size_t chunk_idx = grid_chunk_idx(grid, crow, ccol);
+grid_halo_wrap(const grid_t* grid) {
+    size_t rows = grid->chunk_rows;
+    size_t cols = grid->chunk_cols;
+
+    grid_halo_wrap_cols(grid);
+
+    // de los chunks de arriba y abajo el kernel solo lee la fila que
+    // toca al grid, así que basta con copiar esa palabra. con más rango
+    // lee varias y se copian enteros
+    if (grid->rule.range > 1) {
+        for (size_t col = 0; col < cols + 2; ++col) {
+            grid_halo_copy(grid, 0,        col, rows, col);
+            grid_halo_copy(grid, rows + 1, col, 1,    col);
+        }
 
-    chunk_t* chunk = &grid->chunks[chunk_idx];
+        return;
+    }
+
+    for (size_t col = 0; col < cols + 2; ++col) {
+        size_t top = grid_idx(grid, 0, col);
+        size_t bot = grid_idx(grid, rows + 1, col);
+        size_t last = grid_idx(grid, rows, col);
+        size_t first = grid_idx(grid, 1, col);
 
-    // en primer lugar, si existen, se toman los 8 chunks vecinos al actual
-    //
-    chunk_t* n = (crow > 0)
-        ? &grid->chunks[grid_chunk_idx(grid, crow - 1, ccol)]
-        : NULL;
-
-    chunk_t* s = (crow < grid->chunk_rows - 1)
-        ? &grid->chunks[grid_chunk_idx(grid, crow + 1, ccol)]
-        : NULL;
-
-    chunk_t* w = (ccol > 0)
-        ? &grid->chunks[grid_chunk_idx(grid, crow, ccol - 1)]
-        : NULL;
-
-    chunk_t* e = (ccol < grid->chunk_cols - 1)
-        ? &grid->chunks[grid_chunk_idx(grid, crow, ccol + 1)]
-        : NULL;
-
-    chunk_t* nw = (crow > 0 && ccol > 0)
-        ? &grid->chunks[grid_chunk_idx(grid, crow - 1, ccol - 1)]
-        : NULL;
-
-    chunk_t* ne = (crow > 0 && ccol < grid->chunk_cols - 1)
-        ? &grid->chunks[grid_chunk_idx(grid, crow - 1, ccol + 1)]
-        : NULL;
-
-    chunk_t* sw = (crow < grid->chunk_rows - 1 && ccol > 0)
-        ? &grid->chunks[grid_chunk_idx(grid, crow + 1, ccol - 1)]
-        : NULL;
-
-    chunk_t* se = (crow < grid->chunk_rows - 1 && ccol < grid->chunk_cols - 1)
-        ? &grid->chunks[grid_chunk_idx(grid, crow + 1, ccol + 1)]
-        : NULL;
-
-    // ahora cada fila de 32 células, gracias al uso de
-    // máscaras de bits, se va a poder realizar en paralelo
-    // se hará todo en el bucle inline ya que su eficiencia es fundamental
-    for (size_t row = 0; row < CHUNK_SIZE; ++row) {
-        uint32_t curr = chunk->rows[row];
-
-        // obtenemos las 8 filas vecinas a la actual
-        uint32_t left = w == NULL ? 0U : w->rows[row];
-
-        uint32_t right = e == NULL ? 0U : e->rows[row];
-
-        uint32_t top = row == 0
-            ? (n == NULL ? 0U : n->rows[CHUNK_LAST])
-            : chunk->rows[row - 1];
-
-        uint32_t bot = row == CHUNK_LAST
-            ? (s == NULL ? 0U : s->rows[0])
-            : chunk->rows[row + 1];
-
-        uint32_t top_left = row == 0
-            ? (nw == NULL ? 0U : nw->rows[CHUNK_LAST])
-            : ( w == NULL ? 0U :  w->rows[row - 1]);
-
-        uint32_t top_right = row == 0
-            ? (ne == NULL ? 0U : ne->rows[CHUNK_LAST])
-            : ( e == NULL ? 0U :  e->rows[row - 1]);
-
-        uint32_t bot_left = row == CHUNK_LAST
-            ? (sw == NULL ? 0U : sw->rows[0])
-            : ( w == NULL ? 0U :  w->rows[row + 1]);
-
-        uint32_t bot_right = row == CHUNK_LAST
-            ? (se == NULL ? 0U : se->rows[0])
-            : ( e == NULL ? 0U :  e->rows[row + 1]);
-
-        // se quiere obtener 8 palabras de 32 bits, una con todos los vecinos a la izqda de la palabras
-        // actual, de forma que el vecino izquierdo del bit i esté también en la posición i de la palabra,
-        // otra con los vecinos de la dcha, y así para los 8 vecinos.
-        uint32_t ngb_n = top;
-        uint32_t ngb_s = bot;
-        uint32_t ngb_w = curr << 1U | CHUNK_ROW_BIT(left, CHUNK_LAST);
-        uint32_t ngb_e = curr >> 1U | (CHUNK_ROW_BIT(right, 0) << CHUNK_LAST);
-       
-        uint32_t ngb_nw = ngb_n << 1U | CHUNK_ROW_BIT(top_left, CHUNK_LAST);
-        uint32_t ngb_ne = ngb_n >> 1U | (CHUNK_ROW_BIT(top_right, 0) << CHUNK_LAST);
-        uint32_t ngb_sw = ngb_s << 1U | CHUNK_ROW_BIT(bot_left, CHUNK_LAST);
-        uint32_t ngb_se = ngb_s >> 1U | (CHUNK_ROW_BIT(bot_right, 0) << CHUNK_LAST);
-
-        // ahora se suman los bits de los 8 vecinos en paralelo
-        // en 4 paralabras de 32 bits. p0 contiene el primer bit de la 
-        // suma, p1 el segundo etc. se necesitan 4 palabras ya que los vecinos
-        // pueden sumar 8 como máximo, con representacion b1000
-        // se hará la típica suma binaria con XOR y carry
-        uint32_t p0 = 0;
-        uint32_t p1 = 0;
-        uint32_t p2 = 0;
-        uint32_t p3 = 0;
-
-        // aquí se define la suma binaria que,
-        // al igual que antes, de hará inline
-        #define SUM_NEIGHBOR_ROW(ngb) do {      \
-            uint32_t carry1 = p0 & (ngb);       \
-            p0 ^= (ngb);                        \
-                                                \
-            uint32_t carry2 = p1 & (carry1);    \
-            p1 ^= (carry1);                     \
-                                                \
-            uint32_t carry3 = p2 & (carry2);    \
-            p2 ^= (carry2);                     \
-                                                \
-            p3 ^= (carry3);                     \
-        } while(0)                              \
-
-        // se realiza la suma de los 8 vecinos
-        SUM_NEIGHBOR_ROW(ngb_n);
-        SUM_NEIGHBOR_ROW(ngb_s);
-        SUM_NEIGHBOR_ROW(ngb_e);
-        SUM_NEIGHBOR_ROW(ngb_w);
-        SUM_NEIGHBOR_ROW(ngb_nw);
-        SUM_NEIGHBOR_ROW(ngb_ne);
-        SUM_NEIGHBOR_ROW(ngb_sw);
-        SUM_NEIGHBOR_ROW(ngb_se);
-
-        #undef SUM_NEIGHBOR_ROW
-
-        // detectar 2 células vivas
-        uint32_t eq2 = p1 & ~p2 & ~p3 & ~p0;
-
-        // detectar 3 células vivas
-        uint32_t eq3 = p0 & p1 & ~p2 & ~p3;
-
-        // siguiente generación de la fila
-        uint32_t next = (eq2 & curr) | eq3;
-
-        grid->chunks_next[chunk_idx].rows[row] = next;
+        grid->chunks[top].rows[CHUNK_LAST] = grid->chunks[last].rows[CHUNK_LAST];
+        grid->changed[top] = grid->changed[last];
+
+        grid->chunks[bot].rows[0] = grid->chunks[first].rows[0];
+        grid->changed[bot] = grid->changed[first];
+
+        grid_occ_put(grid, grid->occ, grid_occ_bit(grid, 0, col), grid_occ_get(grid->occ, grid_occ_bit(grid, rows, col)));
+        grid_occ_put(grid, grid->occ, grid_occ_bit(grid, rows + 1, col), grid_occ_get(grid->occ, grid_occ_bit(grid, 1, col)));
     }
 }
 
-static int
-grid_changes_init(grid_t* grid) {
+// deja a cero el anillo de los dos buffers, que es lo que
+// ve un grid acotado más allá de sus bordes
+static void
+grid_halo_clear(const grid_t* grid) {
+    size_t rows = grid->chunk_rows;
+    size_t cols = grid->chunk_cols;
+
+    chunk_t* buffers[] = {grid->chunks, grid->chunks_next};
+    uint8_t* flags[] = {grid->changed, grid->changed_next};
+    uint64_t* occs[] = {grid->occ, grid->occ_next};
+
+    for (size_t i = 0; i < 2; ++i) {
+        if (buffers[i] == NULL) {
+            buffers[i] = buffers[0];
+        }
+
+        for (size_t col = 0; col < cols + 2; ++col) {
+            size_t top = grid_idx(grid, 0, col);
+            size_t bot = grid_idx(grid, rows + 1, col);
+
+            memset(&buffers[i][top], 0, sizeof(chunk_t));
+            memset(&buffers[i][bot], 0, sizeof(chunk_t));
+            flags[i][top] = 0;
+            flags[i][bot] = 0;
+
+            grid_occ_put(grid, occs[i], grid_occ_bit(grid, 0, col), false);
+            grid_occ_put(grid, occs[i], grid_occ_bit(grid, rows + 1, col), false);
+        }
+
+        for (size_t row = 1; row <= rows; ++row) {
+            size_t west = grid_idx(grid, row, 0);
+            size_t east = grid_idx(grid, row, cols + 1);
+
+            memset(&buffers[i][west], 0, sizeof(chunk_t));
+            memset(&buffers[i][east], 0, sizeof(chunk_t));
+            flags[i][west] = 0;
+            flags[i][east] = 0;
+
+            grid_occ_put(grid, occs[i], grid_occ_bit(grid, row, 0), false);
+            grid_occ_put(grid, occs[i], grid_occ_bit(grid, row, cols + 1), false);
+        }
+    }
+}
+
+static void
+grid_changes_swap(grid_t* grid) {
     assert(grid->chunks != NULL);
-    assert(grid->chunks_next == NULL);
+    assert(grid->chunks_next != NULL || grid->in_place);
+
+    // los dos buffers viven tanto como el grid, cada generación
+    // sobrescribe entero chunks_next, así que basta con intercambiarlos.
+    // en el sitio solo se intercambian las marcas y la ocupación
+    if (!grid->in_place) {
+        chunk_t* chunks = grid->chunks;
+
+        grid->chunks = grid->chunks_next;
+        grid->chunks_next = chunks;
+    }
+
+    uint8_t* changed = grid->changed;
+
+    grid->changed = grid->changed_next;
+    grid->changed_next = changed;
+
+    uint64_t* occ = grid->occ;
+
+    grid->occ = grid->occ_next;
+    grid->occ_next = occ;
+}
+
+static void
+grid_mark_all(const grid_t* grid) {
+    for (size_t row = 0; row < grid->chunk_rows; ++row) {
+        for (size_t col = 0; col < grid->chunk_cols; ++col) {
+            grid->changed[grid_chunk_idx(grid, row, col)] = GRID_DIRTY;
+        }
+    }
+}
+
+static void
+grid_sched_destroy(deque_t** deques, size_t workers) {
+    for (size_t i = 0; i < workers; ++i) {
+        if (deques[i] != NULL) {
+            deque_destroy(&deques[i]);
+        }
+    }
+
+    free(deques);
+}
 
-    grid->chunks_next = calloc(grid->chunks_len, sizeof(chunk_t));
+static int
+grid_sched_make(deque_t*** deques_ptr, size_t tiles, size_t workers) {
+    *deques_ptr = safe_calloc(workers, sizeof(deque_t*));
 
-    if (grid->chunks_next == NULL) {
-        fprintf(stderr, "error: failed to allocate memory for new chunks\n");
+    if (*deques_ptr == NULL) {
+        fprintf(stderr, "error: failed to allocate memory for scheduler\n");
         return -1;
     }
 
+    // cada trabajador recibe como mucho ceil(tiles / workers) tiles por ronda
+    size_t capacity = (tiles + workers - 1) / workers;
+
+    for (size_t i = 0; i < workers; ++i) {
+        if (deque_make(&(*deques_ptr)[i], capacity) < 0) {
+            grid_sched_destroy(*deques_ptr, workers);
+            *deques_ptr = NULL;
+
+            return -1;
+        }
+    }
+
     return 0;
 }
 
+// posiciones en memoria de la franja de un trabajador, el primero y el
+// último se quedan además con las filas del anillo de su lado
 static void
-grid_changes_end(grid_t* grid) {
-    assert(grid->chunks != NULL);
-    assert(grid->chunks_next != NULL);
+grid_band_span(const grid_t* grid, size_t worker, size_t workers, size_t* begin, size_t* end) {
+    if (grid->layout == LAYOUT_MORTON) {
+        size_t blocks = grid->chunks_len / (grid->stride * GRID_MORTON_LEN);
 
-    free(grid->chunks);
+        *begin = (blocks * worker / workers) * grid->stride * GRID_MORTON_LEN;
+        *end = (blocks * (worker + 1) / workers) * grid->stride * GRID_MORTON_LEN;
+        return;
+    }
 
-    grid->chunks = grid->chunks_next;
-    grid->chunks_next = NULL;
+    *begin = worker == 0 ? 0 : ((grid->chunk_rows * worker / workers) + 1) * grid->stride;
+    *end = worker + 1 == workers ? grid->chunks_len : ((grid->chunk_rows * (worker + 1) / workers) + 1) * grid->stride;
 }
 
-int
-grid_make(grid_t** grid_ptr, size_t chunk_rows, size_t chunk_cols) {
-    assert(chunk_rows > 0);
-    assert(chunk_cols > 0);
+// cada trabajador escribe primero en las páginas de su franja para que
+// el kernel las coloque en su nodo numa, el resto se crean al usarlas
+static void
+grid_first_touch(void* arg, size_t worker, size_t workers) {
+    grid_t* grid = arg;
 
-    size_t chunks_len, alloc_size;
-    if (__builtin_mul_overflow(chunk_rows, chunk_cols, &chunks_len)) {
-        fprintf(stderr, "error: chunk dimensions too large\n");
+    size_t begin, end;
+    grid_band_span(grid, worker, workers, &begin, &end);
+
+    for (size_t i = 0; i < 2; ++i) {
+        char* bytes = grid->maps[i].ptr;
+        size_t page = grid->maps[i].page_size;
+
+        if (bytes == NULL) {
+            continue;
+        }
+
+        size_t first = ((begin * sizeof(chunk_t)) + page - 1) & ~(page - 1);
+        size_t last = end * sizeof(chunk_t);
+
+        for (size_t offset = first; offset < last; offset += page) {
+            bytes[offset] = 0;
+        }
+    }
+}
+
+// reparte el presupuesto de la caché entre los trabajadores
+static int
+grid_memo_make(grid_t* grid, size_t bytes, size_t workers) {
+    grid->memos = safe_calloc(workers, sizeof(memo_t*));
+
+    if (grid->memos == NULL) {
+        fprintf(stderr, "error: failed to allocate memory for memo caches\n");
         return -1;
     }
-    if (__builtin_mul_overflow(chunks_len, sizeof(chunk_t), &alloc_size)) {
-        fprintf(stderr, "error: chunk memory too large\n");
+
+    grid->memos_len = workers;
+
+    for (size_t i = 0; i < workers; ++i) {
+        if (memo_make(&grid->memos[i], bytes / workers) < 0) {
+            return -1;
+        }
+    }
+
+    grid->memo_on = true;
+
+    return 0;
+}
+
+static void
+grid_memo_destroy(grid_t* grid) {
+    for (size_t i = 0; i < grid->memos_len; ++i) {
+        if (grid->memos[i] != NULL) {
+            memo_destroy(&grid->memos[i]);
+        }
+    }
+
+    free(grid->memos);
+
+    grid->memos = NULL;
+    grid->memos_len = 0;
+}
+
+// planos de edad de una regla Generations, a cero como los chunks
+static int
+grid_ages_make(grid_t* grid) {
+    grid->age_planes = kernel_gen_planes(&grid->rule);
+    grid->ages = safe_calloc(grid->chunks_len * grid->age_planes, sizeof(chunk_t));
+
+    if (grid->ages == NULL) {
+        fprintf(stderr, "error: failed to allocate memory for cell ages\n");
         return -1;
     }
 
-    chunk_t* chunks = calloc(chunks_len, sizeof(chunk_t));
+    return 0;
+}
 
-    if (chunks == NULL) {
-        fprintf(stderr, "error: failed to allocate memory for chunks\n");
+static int
+grid_make_sparse(grid_t** grid_ptr, size_t chunk_rows, size_t chunk_cols, const grid_opts_t* opts) {
+    sparse_t* sparse = NULL;
+
+    if (sparse_make(&sparse, kernel_get(opts->kernel, opts->sum, &opts->rule), opts->rule) < 0) {
+        fprintf(stderr, "error: failed to make unbounded grid\n");
         return -1;
     }
 
-    *grid_ptr = malloc(sizeof(grid_t));
+    *grid_ptr = safe_malloc(sizeof(grid_t));
 
     if (*grid_ptr == NULL) {
-        free(chunks);
+        sparse_destroy(&sparse);
 
         fprintf(stderr, "error: failed to allocate memory for grid\n");
         return -1;
@@ -414,131 +529,1629 @@ grid_make(grid_t** grid_ptr, size_t chunk_rows, size_t chunk_cols) {
         .chunk_rows = chunk_rows,
         .chunk_cols = chunk_cols,
 
-        .chunks_len = chunks_len,
+        .layout = opts->layout,
+        .stride = 0,
+        .chunks_len = 0,
 
-        .chunks = chunks,
+        .sparse = sparse,
+        .bitset = NULL,
+        .list = NULL,
+
+        .chunks = NULL,
         .chunks_next = NULL,
-    };
 
-    return 0;
-}
+        .changed = NULL,
+        .changed_next = NULL,
+        .torus_last = false,
 
-void
-grid_destroy(grid_t** grid_ptr) {
-    assert((*grid_ptr)->chunks_next == NULL);
-    assert((*grid_ptr)->chunks != NULL);
+        .kernel = kernel_get(opts->kernel, opts->sum, &opts->rule),
+        .rule = opts->rule,
 
-    free((*grid_ptr)->chunks);
-    free(*grid_ptr);
+        .ages = NULL,
+        .age_planes = 0,
 
-    *grid_ptr = NULL;
-}
+        .rank = NULL,
+        .halos = NULL,
 
-int
-grid_set_alive(const grid_t* grid, size_t row, size_t col) {
-    assert(grid->chunks != NULL);
+        .chunks_computed = 0,
+        .generations = 0,
 
-    size_t chunk_idx, local_row, local_col;
-    if (grid_inner_coords(grid, row, col, &chunk_idx, &local_row, &local_col) < 0) {
-        return -1;
-    }
+        .pool = NULL,
 
-    chunk_t* chunk = &grid->chunks[chunk_idx];
-    chunk_set_alive(chunk, local_row, local_col);
+        .tile = 0,
+        .tile_rows = 0,
+        .tile_cols = 0,
+        .deques = NULL,
+
+        .time_block = 1,
+        .timeblock = NULL,
+    };
+
+    atomic_init(&(*grid_ptr)->tiles_left, 0);
+    atomic_init(&(*grid_ptr)->chunks_active, 0);
+    atomic_init(&(*grid_ptr)->chunks_periodic, 0);
 
     return 0;
 }
 
-int
-grid_set_dead(const grid_t* grid, size_t row, size_t col) {
-    assert(grid->chunks != NULL);
-
-    size_t chunk_idx, local_row, local_col;
-    if (grid_inner_coords(grid, row, col, &chunk_idx, &local_row, &local_col) < 0) {
+static int
+grid_make_bitset(grid_t** grid_ptr, size_t chunk_rows, size_t chunk_cols, const grid_opts_t* opts) {
+    if (chunk_rows > SIZE_MAX / CHUNK_SIZE || chunk_cols > SIZE_MAX / CHUNK_SIZE) {
+        fprintf(stderr, "error: chunk dimensions too large\n");
         return -1;
     }
 
-    chunk_t* chunk = &grid->chunks[chunk_idx];
-    chunk_set_dead(chunk, local_row, local_col);
-
-    return 0;
-}
+    pool_t* pool = NULL;
 
-int
-grid_randomize(const grid_t* grid) {
-    uint64_t curr;
-    if (safe_rand(&curr) < 0) {
+    if (opts->threads > 1 && pool_make(&pool, opts->threads) < 0) {
+        fprintf(stderr, "error: failed to make worker pool\n");
         return -1;
     }
 
-    for (size_t i = 0; i < grid->chunks_len; ++i) {
-        for (size_t j = 0; j < CHUNK_SIZE; ++j) {
-            grid->chunks[i].rows[j] = (uint32_t)curr;
-            splitmix64_next(&curr);
+    bitset_t* bitset = NULL;
+
+    if (bitset_make(&bitset, chunk_rows * CHUNK_SIZE, chunk_cols * CHUNK_SIZE, kernel_stream_get(opts->kernel, &opts->rule), opts->rule, pool) < 0) {
+        if (pool != NULL) {
+            pool_destroy(&pool);
         }
+
+        return -1;
     }
 
-    return 0;
-}
+    *grid_ptr = safe_malloc(sizeof(grid_t));
 
-void
-grid_clear(const grid_t* grid) {
-    memset(grid->chunks, 0, grid->chunks_len * sizeof(chunk_t));
-}
+    if (*grid_ptr == NULL) {
+        bitset_destroy(&bitset);
 
-int
-grid_cell_state(const grid_t* grid, cell_state_t* state, size_t row, size_t col) {
-    assert(grid->chunks != NULL);
+        if (pool != NULL) {
+            pool_destroy(&pool);
+        }
 
-    size_t chunk_idx, local_row, local_col;
-    if (grid_inner_coords(grid, row, col, &chunk_idx, &local_row, &local_col) < 0) {
+        fprintf(stderr, "error: failed to allocate memory for grid\n");
         return -1;
     }
 
-    chunk_t* chunk = &grid->chunks[chunk_idx];
-    *state = chunk_get(chunk, local_row, local_col);
+    **grid_ptr = (grid_t) {
+        .chunk_rows = chunk_rows,
+        .chunk_cols = chunk_cols,
+
+        .layout = opts->layout,
+        .stride = 0,
+        .chunks_len = 0,
+
+        .sparse = NULL,
+        .bitset = bitset,
+        .list = NULL,
+
+        .chunks = NULL,
+        .chunks_next = NULL,
+
+        .changed = NULL,
+        .changed_next = NULL,
+        .torus_last = false,
+
+        .kernel = NULL,
+        .rule = opts->rule,
+
+        .chunks_computed = 0,
+        .generations = 0,
+
+        .pool = pool,
+
+        .tile = 0,
+        .tile_rows = 0,
+        .tile_cols = 0,
+        .deques = NULL,
+
+        .time_block = 1,
+        .timeblock = NULL,
+    };
+
+    atomic_init(&(*grid_ptr)->tiles_left, 0);
+    atomic_init(&(*grid_ptr)->chunks_active, 0);
+    atomic_init(&(*grid_ptr)->chunks_periodic, 0);
 
     return 0;
 }
 
-void
-grid_dim(const grid_t* grid, size_t* rows, size_t* cols) {
-    *rows = grid->chunk_rows * CHUNK_SIZE;
-    *cols = grid->chunk_cols * CHUNK_SIZE;
-}
+static int
+grid_make_list(grid_t** grid_ptr, size_t chunk_rows, size_t chunk_cols, const grid_opts_t* opts) {
+    if (chunk_rows > SIZE_MAX / CHUNK_SIZE || chunk_cols > SIZE_MAX / CHUNK_SIZE) {
+        fprintf(stderr, "error: chunk dimensions too large\n");
+        return -1;
+    }
 
-int
-grid_update(grid_t* grid) {
-    if (grid_changes_init(grid)) {
-        fprintf(stderr, "error: failed to prepare double buffer in update");
+    list_t* list = NULL;
+
+    if (list_make(&list, chunk_rows * CHUNK_SIZE, chunk_cols * CHUNK_SIZE, opts->rule) < 0) {
         return -1;
     }
 
-    for (size_t row = 0; row < grid->chunk_rows; ++row) {
-        for (size_t col = 0; col < grid->chunk_cols; ++col) {
-            grid_update_chunk(grid, row, col);
-        }
+    *grid_ptr = safe_malloc(sizeof(grid_t));
+
+    if (*grid_ptr == NULL) {
+        list_destroy(&list);
+
+        fprintf(stderr, "error: failed to allocate memory for grid\n");
+        return -1;
     }
 
-    grid_changes_end(grid);
+    **grid_ptr = (grid_t) {
+        .chunk_rows = chunk_rows,
+        .chunk_cols = chunk_cols,
+
+        .layout = opts->layout,
+        .stride = 0,
+        .chunks_len = 0,
+
+        .sparse = NULL,
+        .bitset = NULL,
+        .list = list,
+        .opts = *opts,
+        .grows = true,
+
+        .chunks = NULL,
+        .chunks_next = NULL,
+
+        .changed = NULL,
+        .changed_next = NULL,
+        .torus_last = false,
+
+        .kernel = NULL,
+        .rule = opts->rule,
+
+        .chunks_computed = 0,
+        .generations = 0,
+
+        .pool = NULL,
+
+        .tile = 0,
+        .tile_rows = 0,
+        .tile_cols = 0,
+        .deques = NULL,
+
+        .time_block = 1,
+        .timeblock = NULL,
+    };
+
+    (*grid_ptr)->opts.list = false;
+
+    atomic_init(&(*grid_ptr)->tiles_left, 0);
+    atomic_init(&(*grid_ptr)->chunks_active, 0);
+    atomic_init(&(*grid_ptr)->chunks_periodic, 0);
 
     return 0;
 }
 
-int
-grid_update_toroidal(grid_t* grid) {
-    if (grid_changes_init(grid)) {
-        fprintf(stderr, "error: failed to prepare double buffer in update");
+static int
+grid_make_dense(grid_t** grid_ptr, size_t chunk_rows, size_t chunk_cols, const grid_opts_t* opts) {
+    // con el anillo fantasma se guardan (chunk_rows + 2) x (chunk_cols + 2)
+    // chunks, que en morton se redondean a bloques enteros
+    size_t padded_rows = chunk_rows + 2;
+    size_t padded_cols = chunk_cols + 2;
+    size_t stride = padded_cols;
+
+    if (chunk_rows > SIZE_MAX - GRID_MORTON_SIDE || chunk_cols > SIZE_MAX - GRID_MORTON_SIDE) {
+        fprintf(stderr, "error: chunk dimensions too large\n");
         return -1;
     }
 
-    for (size_t row = 0; row < grid->chunk_rows; ++row) {
-        for (size_t col = 0; col < grid->chunk_cols; ++col) {
-            grid_update_chunk_toroidal(grid, row, col);
+    if (opts->layout == LAYOUT_MORTON) {
+        stride = (padded_cols + GRID_MORTON_SIDE - 1) >> GRID_MORTON_POW;
+        padded_rows = ((padded_rows + GRID_MORTON_SIDE - 1) >> GRID_MORTON_POW) * GRID_MORTON_LEN;
+        padded_cols = stride;
+    }
+
+    size_t chunks_len, alloc_size;
+    if (__builtin_mul_overflow(padded_rows, padded_cols, &chunks_len)) {
+        fprintf(stderr, "error: chunk dimensions too large\n");
+        return -1;
+    }
+    if (__builtin_mul_overflow(chunks_len, sizeof(chunk_t), &alloc_size)) {
+        fprintf(stderr, "error: chunk memory too large\n");
+        return -1;
+    }
+
+    // los buffers se piden al kernel, que los entrega ya a cero y con
+    // páginas enormes si puede, y cada página se crea al escribirla.
+    // en el sitio basta con uno
+    int64_t alloc_start = safe_time();
+
+    // todo lo que se reserva empieza a NULL, así un fallo a medias libera
+    // en fail lo que ya exista, sea cual sea el paso que falló
+    safe_mapping_t maps[2] = {0};
+    uint8_t* changed = NULL;
+    uint8_t* changed_next = NULL;
+    uint64_t* occ = NULL;
+    uint64_t* occ_next = NULL;
+    pool_t* pool = NULL;
+    deque_t** deques = NULL;
+
+    if (safe_map(&maps[0], alloc_size) < 0 || (!opts->in_place && safe_map(&maps[1], alloc_size) < 0)) {
+        fprintf(stderr, "error: failed to allocate memory for chunks\n");
+        goto fail;
+    }
+
+    chunk_t* chunks = maps[0].ptr;
+    chunk_t* chunks_next = maps[1].ptr;
+
+    // los dos buffers empiezan vacíos e iguales, así que
+    // ningún chunk se considera cambiado
+    changed = safe_calloc(chunks_len, sizeof(uint8_t));
+    changed_next = safe_calloc(chunks_len, sizeof(uint8_t));
+
+    // los mapas de ocupación van por filas de chunks con anillo también en
+    // morton, y cada uno lleva detrás su nivel superior
+    size_t occ_stride = (chunk_cols + 2 + GRID_OCC_BITS - 1) >> GRID_OCC_POW;
+    size_t occ_len = (chunk_rows + 2) * occ_stride;
+
+    occ = safe_calloc(occ_len + grid_occ_top_len(occ_len), sizeof(uint64_t));
+    occ_next = safe_calloc(occ_len + grid_occ_top_len(occ_len), sizeof(uint64_t));
+
+    if (changed == NULL || changed_next == NULL || occ == NULL || occ_next == NULL) {
+        fprintf(stderr, "error: failed to allocate memory for chunk flags\n");
+        goto fail;
+    }
+
+    // el pool se crea una sola vez y se reutiliza en cada generación,
+    // con un solo hilo no tiene sentido y se actualiza en el hilo actual
+    if (opts->threads > 1 && pool_make(&pool, opts->threads) < 0) {
+        fprintf(stderr, "error: failed to make worker pool\n");
+        goto fail;
+    }
+
+    size_t tile_rows = 0;
+    size_t tile_cols = 0;
+
+    if (opts->tile > 0 && pool != NULL) {
+        tile_rows = (chunk_rows + opts->tile - 1) / opts->tile;
+        tile_cols = (chunk_cols + opts->tile - 1) / opts->tile;
+
+        if (grid_sched_make(&deques, tile_rows * tile_cols, opts->threads) < 0) {
+            fprintf(stderr, "error: failed to make work stealing scheduler\n");
+            goto fail;
+        }
+    }
+
+    *grid_ptr = safe_malloc(sizeof(grid_t));
+
+    if (*grid_ptr == NULL) {
+        fprintf(stderr, "error: failed to allocate memory for grid\n");
+        goto fail;
+    }
+
+    **grid_ptr = (grid_t) {
+        .chunk_rows = chunk_rows,
+        .chunk_cols = chunk_cols,
+
+        .layout = opts->layout,
+        .stride = stride,
+        .chunks_len = chunks_len,
+
+        .sparse = NULL,
+        .bitset = NULL,
+        .list = NULL,
+        .opts = *opts,
+
+        .chunks = chunks,
+        .chunks_next = chunks_next,
+
+        .maps = {maps[0], maps[1]},
+        .alloc_ms = 0,
+
+        .in_place = opts->in_place,
+        .inplace = NULL,
+
+        .changed = changed,
+        .changed_next = changed_next,
+        .torus_last = false,
+
+        .occ = occ,
+        .occ_next = occ_next,
+        .occ_stride = occ_stride,
+        .occ_len = occ_len,
+        .occ_skip = true,
+
+        .kernel = kernel_get(opts->kernel, opts->sum, &opts->rule),
+        .rule = opts->rule,
+
+        .ages = NULL,
+        .age_planes = 0,
+
+        .rank = NULL,
+        .halos = NULL,
+
+        .chunks_computed = 0,
+        .generations = 0,
+
+        .pool = pool,
+
+        .memos = NULL,
+        .memos_len = 0,
+        .memo_on = false,
+
+        .tile = opts->tile,
+        .tile_rows = tile_rows,
+        .tile_cols = tile_cols,
+        .deques = deques,
+
+        .time_block = opts->time_block > 1 ? opts->time_block : 1,
+        .timeblock = NULL,
+        .block_last = false,
+    };
+
+    atomic_init(&(*grid_ptr)->tiles_left, 0);
+    atomic_init(&(*grid_ptr)->chunks_active, 0);
+    atomic_init(&(*grid_ptr)->chunks_periodic, 0);
+
+    if (opts->layout == LAYOUT_MORTON) {
+        grid_morton_table(*grid_ptr, (*grid_ptr)->morton_ngb);
+    }
+
+    if (opts->memo_bytes > 0 && grid_memo_make(*grid_ptr, opts->memo_bytes, opts->threads) < 0) {
+        grid_destroy(grid_ptr);
+        return -1;
+    }
+
+    if (opts->time_block > 1 && timeblock_make(&(*grid_ptr)->timeblock, chunk_rows, chunk_cols, opts->tile, opts->time_block, opts->threads) < 0) {
+        grid_destroy(grid_ptr);
+        return -1;
+    }
+
+    if (opts->in_place && inplace_make(&(*grid_ptr)->inplace, chunk_cols, occ_stride, opts->threads) < 0) {
+        grid_destroy(grid_ptr);
+        return -1;
+    }
+
+    if (opts->rule.states > 2 && grid_ages_make(*grid_ptr) < 0) {
+        grid_destroy(grid_ptr);
+        return -1;
+    }
+
+    if (pool != NULL) {
+        pool_run(pool, grid_first_touch, *grid_ptr);
+    }
+
+    (*grid_ptr)->alloc_ms = safe_time() - alloc_start;
+
+    return 0;
+
+fail:
+    // en orden inverso al de las reservas: los deques antes que el pool
+    // cuyos trabajadores los usan
+    if (deques != NULL) {
+        grid_sched_destroy(deques, opts->threads);
+    }
+    if (pool != NULL) {
+        pool_destroy(&pool);
+    }
+
+    free(occ_next);
+    free(occ);
+    free(changed_next);
+    free(changed);
+    safe_unmap(&maps[1]);
+    safe_unmap(&maps[0]);
+
+    return -1;
+}
+
+// el proceso rank se queda con su parte de las filas de chunks, todas
+// con el ancho entero, y se conecta con los de las franjas vecinas
+static int
+grid_make_ranks(grid_t** grid_ptr, size_t chunk_rows, size_t chunk_cols, const grid_opts_t* opts) {
+    size_t rank = opts->rank;
+    size_t ranks = opts->ranks;
+
+    if (chunk_rows < ranks) {
+        fprintf(stderr, "error: %zu chunk rows can't be split among %zu ranks\n", chunk_rows, ranks);
+        return -1;
+    }
+
+    size_t first = chunk_rows * rank / ranks;
+    size_t end = chunk_rows * (rank + 1) / ranks;
+
+    if (grid_make_dense(grid_ptr, end - first, chunk_cols, opts) < 0) {
+        return -1;
+    }
+
+    if (rank_attach(*grid_ptr, first, chunk_rows, opts) < 0) {
+        grid_destroy(grid_ptr);
+        return -1;
+    }
+
+    return 0;
+}
+
+int
+grid_make(grid_t** grid_ptr, size_t chunk_rows, size_t chunk_cols, const grid_opts_t* opts) {
+    assert(chunk_rows > 0);
+    assert(chunk_cols > 0);
+    assert(opts->threads > 0);
+
+    if (!kernel_supported(opts->kernel)) {
+        fprintf(stderr, "error: requested kernel is not available for this cpu and chunk width\n");
+        return -1;
+    }
+
+    if (opts->unbounded) {
+        return grid_make_sparse(grid_ptr, chunk_rows, chunk_cols, opts);
+    }
+
+    int status;
+
+    if (opts->ranks > 1) {
+        status = grid_make_ranks(grid_ptr, chunk_rows, chunk_cols, opts);
+    } else if (opts->list) {
+        status = grid_make_list(grid_ptr, chunk_rows, chunk_cols, opts);
+    } else if (opts->layout == LAYOUT_BITSET) {
+        status = grid_make_bitset(grid_ptr, chunk_rows, chunk_cols, opts);
+    } else {
+        status = grid_make_dense(grid_ptr, chunk_rows, chunk_cols, opts);
+    }
+
+    if (status < 0) {
+        return -1;
+    }
+
+    if (opts->adaptive) {
+        if (auto_make(&(*grid_ptr)->model, opts->memo_bytes > 0) < 0) {
+            grid_destroy(grid_ptr);
+            return -1;
+        }
+
+        (*grid_ptr)->auto_ms = safe_time();
+    }
+
+    return 0;
+}
+
+void
+grid_destroy(grid_t** grid_ptr) {
+    if ((*grid_ptr)->model != NULL) {
+        auto_destroy(&(*grid_ptr)->model);
+    }
+
+    if ((*grid_ptr)->sparse != NULL) {
+        sparse_destroy(&(*grid_ptr)->sparse);
+        free(*grid_ptr);
+
+        *grid_ptr = NULL;
+        return;
+    }
+
+    if ((*grid_ptr)->list != NULL) {
+        list_destroy(&(*grid_ptr)->list);
+        free(*grid_ptr);
+
+        *grid_ptr = NULL;
+        return;
+    }
+
+    if ((*grid_ptr)->bitset != NULL) {
+        bitset_destroy(&(*grid_ptr)->bitset);
+
+        if ((*grid_ptr)->pool != NULL) {
+            pool_destroy(&(*grid_ptr)->pool);
+        }
+
+        free(*grid_ptr);
+
+        *grid_ptr = NULL;
+        return;
+    }
+
+    assert((*grid_ptr)->chunks_next != NULL || (*grid_ptr)->in_place);
+    assert((*grid_ptr)->chunks != NULL);
+
+    if ((*grid_ptr)->memos != NULL) {
+        grid_memo_destroy(*grid_ptr);
+    }
+    if ((*grid_ptr)->deques != NULL) {
+        grid_sched_destroy((*grid_ptr)->deques, pool_workers((*grid_ptr)->pool));
+    }
+    if ((*grid_ptr)->pool != NULL) {
+        pool_destroy(&(*grid_ptr)->pool);
+    }
+    if ((*grid_ptr)->rank != NULL) {
+        rank_destroy(&(*grid_ptr)->rank);
+    }
+    if ((*grid_ptr)->inplace != NULL) {
+        inplace_destroy(&(*grid_ptr)->inplace);
+    }
+    if ((*grid_ptr)->timeblock != NULL) {
+        timeblock_destroy(&(*grid_ptr)->timeblock);
+    }
+
+    safe_unmap(&(*grid_ptr)->maps[0]);
+    safe_unmap(&(*grid_ptr)->maps[1]);
+    free((*grid_ptr)->changed);
+    free((*grid_ptr)->changed_next);
+    free((*grid_ptr)->occ);
+    free((*grid_ptr)->occ_next);
+    free((*grid_ptr)->ages);
+    free((*grid_ptr)->halos);
+    free(*grid_ptr);
+
+    *grid_ptr = NULL;
+}
+
+// una célula editada deja de envejecer, viva o muerta
+static inline void
+grid_age_reset(const grid_t* grid, size_t chunk_idx, size_t local_row, size_t local_col) {
+    for (size_t i = 0; i < grid->age_planes; ++i) {
+        chunk_set_dead(&grid->ages[(chunk_idx * grid->age_planes) + i], local_row, local_col);
+    }
+}
+
+static inline bool
+grid_in_view(const grid_t* grid, size_t row, size_t col) {
+    return row < CHUNK_SIZE * grid->chunk_rows && col < CHUNK_SIZE * grid->chunk_cols;
+}
+
+// pasa row del grid entero a la franja del proceso: 0 si cae en ella,
+// 1 si cae en la de otro y -1 si queda fuera del grid
+static inline int
+grid_rank_row(const grid_t* grid, size_t* row, size_t col) {
+    if (grid->rank == NULL) {
+        return 0;
+    }
+
+    if (*row >= CHUNK_SIZE * grid->total_rows || col >= CHUNK_SIZE * grid->chunk_cols) {
+        return -1;
+    }
+
+    size_t first = CHUNK_SIZE * grid->rank_first;
+
+    if (*row < first || *row - first >= CHUNK_SIZE * grid->chunk_rows) {
+        return 1;
+    }
+
+    *row -= first;
+
+    return 0;
+}
+
+int
+grid_set_alive(const grid_t* grid, size_t row, size_t col) {
+    if (grid->sparse != NULL) {
+        return grid_in_view(grid, row, col) ? sparse_set_alive(grid->sparse, (int64_t)row, (int64_t)col) : -1;
+    }
+
+    if (grid->bitset != NULL) {
+        return bitset_set_alive(grid->bitset, row, col);
+    }
+
+    if (grid->list != NULL) {
+        return list_set_alive(grid->list, row, col);
+    }
+
+    assert(grid->chunks != NULL);
+
+    // cada proceso lee la entrada entera y se queda con lo de su franja
+    int band = grid_rank_row(grid, &row, col);
+
+    if (band != 0) {
+        return band < 0 ? -1 : 0;
+    }
+
+    size_t chunk_idx, local_row, local_col;
+    if (grid_inner_coords(grid, row, col, &chunk_idx, &local_row, &local_col) < 0) {
+        return -1;
+    }
+
+    chunk_t* chunk = &grid->chunks[chunk_idx];
+    chunk_set_alive(chunk, local_row, local_col);
+    grid_age_reset(grid, chunk_idx, local_row, local_col);
+
+    grid->changed[chunk_idx] = GRID_DIRTY;
+    grid_occ_set(grid, grid->occ, grid_occ_bit(grid, (row >> CHUNK_POW) + 1, (col >> CHUNK_POW) + 1));
+
+    return 0;
+}
+
+int
+grid_set_alive_at(const grid_t* grid, int64_t row, int64_t col) {
+    if (grid->sparse != NULL) {
+        return sparse_set_alive(grid->sparse, row, col);
+    }
+
+    if (row < 0 || col < 0) {
+        return -1;
+    }
+
+    return grid_set_alive(grid, (size_t)row, (size_t)col);
+}
+
+int
+grid_set_dead(const grid_t* grid, size_t row, size_t col) {
+    if (grid->sparse != NULL) {
+        return grid_in_view(grid, row, col) ? sparse_set_dead(grid->sparse, (int64_t)row, (int64_t)col) : -1;
+    }
+
+    if (grid->bitset != NULL) {
+        return bitset_set_dead(grid->bitset, row, col);
+    }
+
+    if (grid->list != NULL) {
+        return list_set_dead(grid->list, row, col);
+    }
+
+    assert(grid->chunks != NULL);
+
+    int band = grid_rank_row(grid, &row, col);
+
+    if (band != 0) {
+        return band < 0 ? -1 : 0;
+    }
+
+    size_t chunk_idx, local_row, local_col;
+    if (grid_inner_coords(grid, row, col, &chunk_idx, &local_row, &local_col) < 0) {
+        return -1;
+    }
+
+    // el bit de ocupación se queda encendido aunque el chunk se vacíe,
+    // lo apagará el kernel cuando vuelva a calcularlo
+    chunk_t* chunk = &grid->chunks[chunk_idx];
+    chunk_set_dead(chunk, local_row, local_col);
+    grid_age_reset(grid, chunk_idx, local_row, local_col);
+
+    grid->changed[chunk_idx] = GRID_DIRTY;
+
+    return 0;
+}
+
+// células vivas de los chunks, con las filas en el grid entero
+void
+grid_visit_chunks(const grid_t* grid, grid_visit_fn_t visit, void* ctx) {
+    // se recorre por filas de células, en el mismo orden que consultando
+    // grid_cell_state célula a célula, pero solo por las filas de chunks
+    // que tienen alguno ocupado y, dentro de ellas, por esos chunks
+    size_t stride = grid->occ_stride;
+    size_t word = grid_occ_next(grid, grid->occ, stride);
+
+    while (word < grid->occ_len && word / stride <= grid->chunk_rows) {
+        size_t ring_row = word / stride;
+        const uint64_t* occ = &grid->occ[ring_row * stride];
+
+        for (size_t local_row = 0; local_row < CHUNK_SIZE; ++local_row) {
+            size_t row = ((grid->rank_first + ring_row - 1) << CHUNK_POW) + local_row;
+
+            for (size_t i = 0; i < stride; ++i) {
+                for (uint64_t bits = occ[i]; bits != 0; bits &= bits - 1) {
+                    size_t col = (i << GRID_OCC_POW) + (size_t)__builtin_ctzll(bits);
+
+                    // el anillo del toro repite chunks del borde opuesto
+                    if (col == 0 || col > grid->chunk_cols) {
+                        continue;
+                    }
+
+                    chunk_word_t cells = grid->chunks[grid_idx(grid, ring_row, col)].rows[local_row];
+
+                    for (; cells != 0; cells &= cells - 1) {
+                        visit(ctx, (int64_t)row, (int64_t)(((col - 1) * CHUNK_SIZE) + chunk_word_ctz(cells)));
+                    }
+                }
+            }
+        }
+
+        word = grid_occ_next(grid, grid->occ, (ring_row + 1) * stride);
+    }
+}
+
+int
+grid_visit_alive(const grid_t* grid, grid_visit_fn_t visit, void* ctx) {
+    if (grid->sparse != NULL) {
+        return sparse_visit_alive(grid->sparse, visit, ctx);
+    }
+
+    if (grid->bitset != NULL) {
+        return bitset_visit_alive(grid->bitset, visit, ctx);
+    }
+
+    if (grid->list != NULL) {
+        return list_visit_alive(grid->list, visit, ctx);
+    }
+
+    if (grid->rank != NULL) {
+        return rank_gather(grid, visit, ctx);
+    }
+
+    grid_visit_chunks(grid, visit, ctx);
+
+    return 0;
+}
+
+bool
+grid_root(const grid_t* grid) {
+    return grid->rank == NULL || grid->rank_first == 0;
+}
+
+bool
+grid_unbounded(const grid_t* grid) {
+    return grid->sparse != NULL;
+}
+
+int
+grid_set_memo(grid_t* grid, bool on) {
+    if (grid->memos == NULL) {
+        return -1;
+    }
+
+    grid->memo_on = on;
+
+    return 0;
+}
+
+bool
+grid_grows(const grid_t* grid) {
+    return grid->sparse != NULL || grid->grows || grid->model != NULL;
+}
+
+// el modelo de costes pasa al grid que sustituye a este, y el periodo
+// que se mide vuelve a empezar con el motor nuevo
+static void
+grid_auto_move(grid_t* dst, grid_t* src) {
+    dst->model = src->model;
+    src->model = NULL;
+
+    dst->auto_gen = dst->generations;
+    dst->auto_ms = safe_time();
+    dst->auto_computed = dst->chunks_computed;
+}
+
+static void
+grid_promote_cell(void* ctx, int64_t row, int64_t col) {
+    grid_set_alive(ctx, (size_t)row, (size_t)col);
+}
+
+// cambia la lista de células por el grid de chunks pedido en las opciones,
+// que se construye aparte y luego se mueve a la memoria de este grid
+static int
+grid_promote(grid_t* grid) {
+    grid_t* dense = NULL;
+    grid_opts_t opts = grid->opts;
+
+    opts.list = false;
+    opts.adaptive = false;
+
+    if (grid_make(&dense, grid->chunk_rows, grid->chunk_cols, &opts) < 0) {
+        fprintf(stderr, "error: failed to promote cell list to the bitboard\n");
+        return -1;
+    }
+
+    list_visit_alive(grid->list, grid_promote_cell, dense);
+
+    dense->generations = grid->generations;
+    dense->grows = true;
+    dense->promoted = true;
+    dense->promoted_at = grid->generations;
+    dense->promoted_cells = list_population(grid->list);
+
+    // con el modelo la caché solo se enciende cuando él lo decide
+    if (grid->model != NULL) {
+        grid_auto_move(dense, grid);
+        dense->memo_on = false;
+    }
+
+    list_destroy(&grid->list);
+
+    *grid = *dense;
+    free(dense);
+
+    return 0;
+}
+
+typedef struct grid_demote_ctx {
+    list_t* list;
+    int status;
+} grid_demote_ctx_t;
+
+static void
+grid_demote_cell(void* ctx, int64_t row, int64_t col) {
+    grid_demote_ctx_t* demote = ctx;
+
+    if (list_set_alive(demote->list, (size_t)row, (size_t)col) < 0) {
+        demote->status = -1;
+    }
+}
+
+// el camino inverso de grid_promote, que solo toma el modelo de costes:
+// la lista se construye aparte con las células vivas y ocupa este grid,
+// y el de chunks queda en la memoria de la lista para destruirse
+static int
+grid_demote(grid_t* grid) {
+    grid_t* list = NULL;
+    grid_opts_t opts = grid->opts;
+
+    opts.list = true;
+    opts.adaptive = false;
+
+    if (grid_make(&list, grid->chunk_rows, grid->chunk_cols, &opts) < 0) {
+        fprintf(stderr, "error: failed to demote the bitboard to a cell list\n");
+        return -1;
+    }
+
+    grid_demote_ctx_t ctx = {.list = list->list, .status = 0};
+    grid_visit_alive(grid, grid_demote_cell, &ctx);
+
+    if (ctx.status < 0) {
+        grid_destroy(&list);
+
+        fprintf(stderr, "error: failed to demote the bitboard to a cell list\n");
+        return -1;
+    }
+
+    list->generations = grid->generations;
+    list->chunks_computed = grid->chunks_computed;
+    list->promoted = grid->promoted;
+    list->promoted_at = grid->promoted_at;
+    list->promoted_cells = grid->promoted_cells;
+    grid_auto_move(list, grid);
+
+    grid_t dense = *grid;
+    *grid = *list;
+    *list = dense;
+
+    grid_destroy(&list);
+
+    return 0;
+}
+
+static size_t
+grid_population(const grid_t* grid) {
+    if (grid->list != NULL) {
+        return list_population(grid->list);
+    }
+
+    size_t population = 0;
+
+    for (size_t word = grid_occ_next(grid, grid->occ, 0); word < grid->occ_len; word = grid_occ_next(grid, grid->occ, word + 1)) {
+        size_t row = word / grid->occ_stride;
+        size_t col = (word % grid->occ_stride) << GRID_OCC_POW;
+
+        for (uint64_t bits = grid->occ[word]; bits != 0; bits &= bits - 1) {
+            size_t ring_col = col + (size_t)__builtin_ctzll(bits);
+
+            // el anillo del toro repite chunks del borde opuesto
+            if (row == 0 || row > grid->chunk_rows || ring_col == 0 || ring_col > grid->chunk_cols) {
+                continue;
+            }
+
+            population += chunk_population(&grid->chunks[grid_idx(grid, row, ring_col)]);
+        }
+    }
+
+    return population;
+}
+
+static inline auto_engine_t
+grid_auto_engine(const grid_t* grid) {
+    if (grid->list != NULL) {
+        return AUTO_LIST;
+    }
+
+    return grid->memo_on ? AUTO_MEMO : AUTO_DENSE;
+}
+
+// la lista solo compensa mientras el patrón es muy poco denso
+static int
+grid_check_density(grid_t* grid) {
+    size_t cells = grid->chunk_rows * grid->chunk_cols * CHUNK_SIZE * CHUNK_SIZE;
+
+    if (list_population(grid->list) <= cells / GRID_LIST_SPARSITY) {
+        return 0;
+    }
+
+    if (grid->model != NULL && auto_record(grid->model, grid->generations, AUTO_LIST, AUTO_DENSE) < 0) {
+        return -1;
+    }
+
+    return grid_promote(grid);
+}
+
+// al cerrar cada periodo se le pasa al modelo lo medido y, si decide
+// otro motor, el grid se convierte antes de la siguiente generación
+static int
+grid_auto_step(grid_t* grid) {
+    size_t gens = grid->generations - grid->auto_gen;
+
+    if (gens < (auto_pending(grid->model) ? GRID_AUTO_PROBE : GRID_AUTO_PERIOD)) {
+        return 0;
+    }
+
+    int64_t now = safe_time();
+
+    if (now - grid->auto_ms < GRID_AUTO_MIN_MS) {
+        return 0;
+    }
+
+    size_t cells = grid->chunk_rows * grid->chunk_cols * CHUNK_SIZE * CHUNK_SIZE;
+    size_t population = grid_population(grid);
+    auto_engine_t from = grid_auto_engine(grid);
+
+    auto_sample_t sample = {
+        .engine = from,
+        .generation = grid->generations,
+        .generations = gens,
+        .elapsed_ms = now - grid->auto_ms,
+        .population = population,
+        .computed = grid->chunks_computed - grid->auto_computed,
+        .chunks = grid->chunk_rows * grid->chunk_cols,
+        .list_fits = population <= cells / GRID_LIST_SPARSITY,
+    };
+
+    auto_engine_t to = auto_decide(grid->model, &sample);
+
+    grid->auto_gen = grid->generations;
+    grid->auto_ms = now;
+    grid->auto_computed = grid->chunks_computed;
+
+    if (to == from) {
+        return 0;
+    }
+
+    if (from == AUTO_LIST && grid_promote(grid) < 0) {
+        return -1;
+    }
+
+    if (to == AUTO_LIST) {
+        return grid_demote(grid);
+    }
+
+    return grid_set_memo(grid, to == AUTO_MEMO);
+}
+
+size_t
+grid_switches(const grid_t* grid, const grid_switch_t** switches) {
+    if (grid->model == NULL) {
+        *switches = NULL;
+        return 0;
+    }
+
+    return auto_switches(grid->model, switches);
+}
+
+static inline chunk_word_t
+grid_random_word(uint64_t* curr) {
+    chunk_word_t word = (chunk_word_t)*curr;
+    splitmix64_next(curr);
+
+#if CHUNK_BITS > 64
+    word = (word << 64U) | *curr;
+    splitmix64_next(curr);
+#endif
+
+    return word;
+}
+
+static int
+grid_randomize_sparse(const grid_t* grid, uint64_t curr) {
+    for (size_t crow = 0; crow < grid->chunk_rows; ++crow) {
+        for (size_t ccol = 0; ccol < grid->chunk_cols; ++ccol) {
+            chunk_t* chunk = sparse_chunk_at(grid->sparse, (int64_t)crow, (int64_t)ccol);
+
+            if (chunk == NULL) {
+                return -1;
+            }
+
+            for (size_t j = 0; j < CHUNK_SIZE; ++j) {
+                chunk->rows[j] = grid_random_word(&curr);
+            }
+        }
+    }
+
+    return 0;
+}
+
+int
+grid_randomize(grid_t* grid) {
+    uint64_t curr;
+    if (safe_rand(&curr) < 0) {
+        return -1;
+    }
+
+    // la mitad de las células vivas ya pasa de sobra el umbral
+    if (grid->list != NULL) {
+        if (grid->model != NULL && auto_record(grid->model, grid->generations, AUTO_LIST, AUTO_DENSE) < 0) {
+            return -1;
+        }
+
+        if (grid_promote(grid) < 0) {
+            return -1;
         }
     }
 
-    grid_changes_end(grid);
+    if (grid->sparse != NULL) {
+        return grid_randomize_sparse(grid, curr);
+    }
+
+    if (grid->bitset != NULL) {
+        bitset_randomize(grid->bitset, curr);
+        return 0;
+    }
+
+    for (size_t crow = 0; crow < grid->chunk_rows; ++crow) {
+        for (size_t ccol = 0; ccol < grid->chunk_cols; ++ccol) {
+            chunk_t* chunk = &grid->chunks[grid_chunk_idx(grid, crow, ccol)];
+
+            for (size_t j = 0; j < CHUNK_SIZE; ++j) {
+                chunk->rows[j] = grid_random_word(&curr);
+            }
+
+            grid_occ_set(grid, grid->occ, grid_occ_bit(grid, crow + 1, ccol + 1));
+        }
+    }
+
+    // las células al azar están vivas o muertas, ninguna envejeciendo
+    if (grid->ages != NULL) {
+        memset(grid->ages, 0, grid->chunks_len * grid->age_planes * sizeof(chunk_t));
+    }
+
+    grid_mark_all(grid);
+
+    return 0;
+}
+
+void
+grid_clear(const grid_t* grid) {
+    if (grid->sparse != NULL) {
+        sparse_clear(grid->sparse);
+        return;
+    }
+
+    if (grid->bitset != NULL) {
+        bitset_clear(grid->bitset);
+        return;
+    }
+
+    if (grid->list != NULL) {
+        list_clear(grid->list);
+        return;
+    }
+
+    // al vaciar los dos buffers vuelven a ser iguales y ningún chunk
+    // necesita recalcularse. solo hace falta vaciar los que el mapa de
+    // ocupación de cada buffer da por ocupados, y quitarles la marca; en
+    // el resto una marca que siga encendida solo hará calcular un chunk
+    // que sale vacío
+    chunk_t* buffers[] = {grid->chunks, grid->chunks_next};
+    uint64_t* occs[] = {grid->occ, grid->occ_next};
+
+    for (size_t i = 0; i < 2; ++i) {
+        // en el sitio el mapa de ocupación sigue siendo doble
+        if (buffers[i] == NULL) {
+            buffers[i] = buffers[0];
+        }
+
+        for (size_t word = grid_occ_next(grid, occs[i], 0); word < grid->occ_len; word = grid_occ_next(grid, occs[i], word + 1)) {
+            size_t row = word / grid->occ_stride;
+            size_t col = (word % grid->occ_stride) << GRID_OCC_POW;
+
+            for (uint64_t bits = occs[i][word]; bits != 0; bits &= bits - 1) {
+                size_t idx = grid_idx(grid, row, col + (size_t)__builtin_ctzll(bits));
+
+                memset(&buffers[i][idx], 0, sizeof(chunk_t));
+                grid->changed[idx] = 0;
+            }
+
+            occs[i][word] = 0;
+        }
+
+        memset(occs[i] + grid->occ_len, 0, grid_occ_top_len(grid->occ_len) * sizeof(uint64_t));
+    }
+
+    if (grid->ages != NULL) {
+        memset(grid->ages, 0, grid->chunks_len * grid->age_planes * sizeof(chunk_t));
+    }
+}
+
+int
+grid_cell_state(const grid_t* grid, cell_state_t* state, size_t row, size_t col) {
+    if (grid->sparse != NULL) {
+        if (!grid_in_view(grid, row, col)) {
+            return -1;
+        }
+
+        *state = sparse_cell_state(grid->sparse, (int64_t)row, (int64_t)col);
+        return 0;
+    }
+
+    if (grid->bitset != NULL) {
+        return bitset_cell_state(grid->bitset, state, row, col);
+    }
+
+    if (grid->list != NULL) {
+        return list_cell_state(grid->list, state, row, col);
+    }
+
+    assert(grid->chunks != NULL);
+
+    // las células de otra franja no se conocen aquí
+    if (grid_rank_row(grid, &row, col) != 0) {
+        return -1;
+    }
+
+    size_t chunk_idx, local_row, local_col;
+    if (grid_inner_coords(grid, row, col, &chunk_idx, &local_row, &local_col) < 0) {
+        return -1;
+    }
+
+    chunk_t* chunk = &grid->chunks[chunk_idx];
+    *state = chunk_get(chunk, local_row, local_col);
+
+    unsigned age = 0;
+
+    for (size_t i = 0; i < grid->age_planes; ++i) {
+        age |= (unsigned)chunk_get(&grid->ages[(chunk_idx * grid->age_planes) + i], local_row, local_col) << i;
+    }
+
+    if (age != 0) {
+        *state = (cell_state_t)(age + 1);
+    }
+
+    return 0;
+}
+
+size_t
+grid_dead_run(const grid_t* grid, size_t row, size_t col) {
+    if (grid->sparse != NULL || grid->bitset != NULL || grid->list != NULL || grid->rank != NULL || !grid_in_view(grid, row, col)) {
+        return 0;
+    }
+
+    size_t ring_row = (row >> CHUNK_POW) + 1;
+    size_t first = (col >> CHUNK_POW) + 1;
+    size_t next = first;
+
+    // primer chunk ocupado de la fila a partir del de la célula
+    while (next <= grid->chunk_cols) {
+        uint64_t bits = grid_occ_window(grid, grid->occ, ring_row, next);
+
+        if (bits != 0) {
+            next += (size_t)__builtin_ctzll(bits);
+            break;
+        }
+
+        next += GRID_OCC_BITS;
+    }
+
+    if (next > grid->chunk_cols + 1) {
+        next = grid->chunk_cols + 1;
+    }
+
+    return next == first ? 0 : ((next - 1) << CHUNK_POW) - col;
+}
+
+void
+grid_memory(const grid_t* grid, grid_memory_t* memory) {
+    if (grid->sparse != NULL || grid->list != NULL) {
+        *memory = (grid_memory_t) {0};
+        return;
+    }
+
+    if (grid->bitset != NULL) {
+        bitset_memory(grid->bitset, memory);
+        return;
+    }
+
+    *memory = (grid_memory_t) {
+        .bytes = grid->maps[0].len + grid->maps[1].len + (grid->chunks_len * grid->age_planes * sizeof(chunk_t)),
+        .page_size = grid->maps[0].page_size,
+        .transparent = grid->maps[0].transparent,
+        .alloc_ms = grid->alloc_ms,
+    };
+}
+
+void
+grid_dim(const grid_t* grid, size_t* rows, size_t* cols) {
+    *rows = (grid->rank != NULL ? grid->total_rows : grid->chunk_rows) * CHUNK_SIZE;
+    *cols = grid->chunk_cols * CHUNK_SIZE;
+}
+
+void
+grid_stats(const grid_t* grid, grid_stats_t* stats) {
+    size_t chunks = grid->chunk_rows * grid->chunk_cols;
+
+    const char* unit = "chunks";
+
+    if (grid->sparse != NULL) {
+        chunks = sparse_chunks(grid->sparse);
+    } else if (grid->bitset != NULL) {
+        chunks = bitset_rows(grid->bitset);
+        unit = "rows";
+    } else if (grid->list != NULL) {
+        chunks *= CHUNK_SIZE * CHUNK_SIZE;
+        unit = "cells";
+    }
+
+    *stats = (grid_stats_t) {
+        .unit = unit,
+        .generations = grid->generations,
+        .chunks = chunks,
+        .chunks_active = atomic_load(&grid->chunks_active),
+        .chunks_computed = grid->chunks_computed,
+        .chunks_periodic = atomic_load(&grid->chunks_periodic),
+        .chunks_periodic_total = grid->chunks_periodic_total,
+        .promoted = grid->promoted,
+        .promoted_at = grid->promoted_at,
+        .promoted_cells = grid->promoted_cells,
+        .memo_on = grid->memo_on,
+    };
+
+    for (size_t i = 0; i < grid->memos_len; ++i) {
+        stats->memo_hits += memo_hits(grid->memos[i]);
+        stats->memo_misses += memo_misses(grid->memos[i]);
+        stats->memo_bytes += memo_bytes(grid->memos[i]);
+    }
+}
+
+// actualiza los chunks [begin, end) de una fila de chunks de 64 en 64,
+// llamando al kernel solo para los que el mapa de ocupación no descarta,
+// que se recorren con ctz. los descartados siguen vacíos y sin cambios
+void
+grid_update_row(const grid_t* grid, size_t row, size_t begin, size_t end, grid_worker_t* worker) {
+    for (size_t col = begin; col < end; col += GRID_OCC_BITS) {
+        size_t len = end - col < GRID_OCC_BITS ? end - col : GRID_OCC_BITS;
+        uint64_t span = len == GRID_OCC_BITS ? ~(uint64_t)0 : ((uint64_t)1 << len) - 1;
+        uint64_t need = grid->occ_skip ? grid_occ_need(grid, row + 1, col + 1) & span : span;
+
+        // por filas las marcas de los 64 chunks están seguidas y basta
+        // con borrarlas todas antes de calcular los que hacen falta
+        if (need != span && grid->layout == LAYOUT_ROWS) {
+            memset(&grid->changed_next[grid_chunk_idx(grid, row, col)], 0, len);
+        } else {
+            for (uint64_t skip = span & ~need; skip != 0; skip &= skip - 1) {
+                grid->changed_next[grid_chunk_idx(grid, row, col + (size_t)__builtin_ctzll(skip))] = 0;
+            }
+        }
+
+        for (; need != 0; need &= need - 1) {
+            size_t at = col + (size_t)__builtin_ctzll(need);
+
+            grid_update_chunk(grid, grid_chunk_idx(grid, row, at), grid_occ_bit(grid, row + 1, at + 1), worker);
+        }
+    }
+}
+
+// recorre los bloques de una franja en el orden de la memoria, saltando
+// los chunks del anillo y los que solo rellenan el último bloque. de cada
+// bloque se miran antes las 8 filas del mapa de ocupación, y si no queda
+// ningún chunk por calcular sus 64 marcas seguidas se borran de una vez
+static void
+grid_update_morton(const grid_t* grid, size_t begin, size_t end, grid_worker_t* worker) {
+    for (size_t block = begin * grid->stride; block < end * grid->stride; ++block) {
+        size_t row_base = (block / grid->stride) << GRID_MORTON_POW;
+        size_t col_base = (block % grid->stride) << GRID_MORTON_POW;
+
+        uint64_t need[GRID_MORTON_SIDE];
+        uint64_t any = 0;
+
+        for (size_t i = 0; i < GRID_MORTON_SIDE; ++i) {
+            size_t row = row_base + i;
+
+            if (row - 1 >= grid->chunk_rows) {
+                need[i] = 0;
+            } else if (!grid->occ_skip) {
+                need[i] = ~(uint64_t)0;
+            } else if (col_base == 0) {
+                need[i] = grid_occ_need(grid, row, 1) << 1U;
+            } else {
+                need[i] = grid_occ_need(grid, row, col_base);
+            }
+
+            need[i] &= (1U << GRID_MORTON_SIDE) - 1;
+            any |= need[i];
+        }
+
+        if (any == 0) {
+            memset(&grid->changed_next[block << (2 * GRID_MORTON_POW)], 0, GRID_MORTON_LEN);
+            continue;
+        }
+
+        for (size_t inner = 0; inner < GRID_MORTON_LEN; ++inner) {
+            size_t row = row_base + grid_morton_compact(inner >> 1U);
+            size_t col = col_base + grid_morton_compact(inner);
+            size_t idx = (block << (2 * GRID_MORTON_POW)) | inner;
+
+            if (row - 1 >= grid->chunk_rows || col - 1 >= grid->chunk_cols) {
+                continue;
+            }
+
+            if (((need[row - row_base] >> (col - col_base)) & 1U) != 0) {
+                grid_update_chunk(grid, idx, grid_occ_bit(grid, row, col), worker);
+            } else {
+                grid->changed_next[idx] = 0;
+            }
+        }
+    }
+}
+
+static void
+grid_update_band(void* arg, size_t worker, size_t workers) {
+    grid_t* grid = arg;
+
+    grid_worker_t work = {
+        .memo = grid->memo_on ? grid->memos[worker] : NULL,
+    };
+
+    // cada trabajador se queda con una franja contigua de filas de chunks,
+    // como chunks y chunks_next no se solapan, las franjas son independientes
+    if (grid->layout == LAYOUT_MORTON) {
+        size_t blocks = grid->chunks_len / (grid->stride * GRID_MORTON_LEN);
+
+        grid_update_morton(grid, blocks * worker / workers, blocks * (worker + 1) / workers, &work);
+    } else {
+        size_t begin = grid->chunk_rows * worker / workers;
+        size_t end = grid->chunk_rows * (worker + 1) / workers;
+
+        for (size_t row = begin; row < end; ++row) {
+            grid_update_row(grid, row, 0, grid->chunk_cols, &work);
+        }
+    }
+
+    atomic_fetch_add_explicit(&grid->chunks_active, work.active, memory_order_relaxed);
+    atomic_fetch_add_explicit(&grid->chunks_periodic, work.periodic, memory_order_relaxed);
+}
+
+static void
+grid_update_tile(const grid_t* grid, size_t tile, grid_worker_t* worker) {
+    size_t row_begin = (tile / grid->tile_cols) * grid->tile;
+    size_t col_begin = (tile % grid->tile_cols) * grid->tile;
+
+    size_t row_end = row_begin + grid->tile;
+    size_t col_end = col_begin + grid->tile;
+
+    if (row_end > grid->chunk_rows) {
+        row_end = grid->chunk_rows;
+    }
+    if (col_end > grid->chunk_cols) {
+        col_end = grid->chunk_cols;
+    }
+
+    for (size_t row = row_begin; row < row_end; ++row) {
+        grid_update_row(grid, row, col_begin, col_end, worker);
+    }
+}
+
+static void
+grid_update_steal(void* arg, size_t worker, size_t workers) {
+    grid_t* grid = arg;
+
+    size_t tiles = grid->tile_rows * grid->tile_cols;
+    size_t begin = tiles * worker / workers;
+    size_t end = tiles * (worker + 1) / workers;
+
+    deque_t* own = grid->deques[worker];
+
+    // se insertan al revés para que el dueño recorra sus tiles en orden
+    // de memoria y los ladrones se lleven los del extremo opuesto
+    for (size_t tile = end; tile > begin; --tile) {
+        deque_push(own, tile - 1);
+    }
+
+    uint64_t seed = worker;
+
+    grid_worker_t work = {
+        .memo = grid->memo_on ? grid->memos[worker] : NULL,
+    };
+
+    while (atomic_load_explicit(&grid->tiles_left, memory_order_acquire) > 0) {
+        size_t tile = deque_take(own);
+
+        if (tile == DEQUE_EMPTY) {
+            splitmix64_next(&seed);
+            size_t victim = seed % workers;
+
+            if (victim == worker) {
+                continue;
+            }
+
+            tile = deque_steal(grid->deques[victim]);
+
+            if (tile == DEQUE_EMPTY) {
+                continue;
+            }
+        }
+
+        grid_update_tile(grid, tile, &work);
+
+        atomic_fetch_sub_explicit(&grid->tiles_left, 1, memory_order_acq_rel);
+    }
+
+    atomic_fetch_add_explicit(&grid->chunks_active, work.active, memory_order_relaxed);
+    atomic_fetch_add_explicit(&grid->chunks_periodic, work.periodic, memory_order_relaxed);
+}
+
+void
+grid_topology(grid_t* grid, bool torus) {
+    // al cambiar de topología los vecinos de los bordes son otros,
+    // así que las marcas de la generación anterior no sirven
+    if (torus != grid->torus_last) {
+        grid_mark_all(grid);
+        grid->torus_last = torus;
+
+        if (!torus) {
+            grid_halo_clear(grid);
+        }
+    }
+}
+
+static void
+grid_run(grid_t* grid, bool torus) {
+    grid_topology(grid, torus);
+
+    // tras una pasada por bloques chunks_next guarda el estado de hace
+    // varias generaciones y no el anterior, así que nada puede saltarse,
+    // ni siquiera por ocupación, que daría por iguales a esos dos estados
+    grid->occ_skip = !grid->block_last;
+
+    if (grid->block_last) {
+        grid_mark_all(grid);
+        grid->block_last = false;
+    }
+
+    if (torus) {
+        grid_halo_wrap(grid);
+    }
+
+    atomic_store(&grid->chunks_active, 0);
+    atomic_store(&grid->chunks_periodic, 0);
+
+    if (grid->in_place) {
+        inplace_run(grid);
+    } else if (grid->pool == NULL) {
+        grid_update_band(grid, 0, 1);
+    } else if (grid->deques == NULL) {
+        pool_run(grid->pool, grid_update_band, grid);
+    } else {
+        atomic_store(&grid->tiles_left, grid->tile_rows * grid->tile_cols);
+        pool_run(grid->pool, grid_update_steal, grid);
+    }
+
+    grid->chunks_computed += atomic_load(&grid->chunks_active);
+    grid->chunks_periodic_total += atomic_load(&grid->chunks_periodic);
+    grid->generations += 1;
+}
+
+static int
+grid_run_list(grid_t* grid, bool torus) {
+    if (list_update(grid->list, torus) < 0) {
+        return -1;
+    }
+
+    atomic_store(&grid->chunks_active, list_computed(grid->list));
+
+    grid->chunks_computed += list_computed(grid->list);
+    grid->generations += 1;
+
+    return 0;
+}
+
+static void
+grid_run_bitset(grid_t* grid, bool torus) {
+    bitset_update(grid->bitset, torus);
+
+    atomic_store(&grid->chunks_active, bitset_computed(grid->bitset));
+
+    grid->chunks_computed += bitset_computed(grid->bitset);
+    grid->generations += 1;
+}
+
+int
+grid_update(grid_t* grid) {
+    if (grid->model != NULL && grid_auto_step(grid) < 0) {
+        return -1;
+    }
+
+    if (grid->list != NULL && grid_check_density(grid) < 0) {
+        return -1;
+    }
+
+    if (grid->list != NULL) {
+        return grid_run_list(grid, false);
+    }
+
+    if (grid->sparse != NULL) {
+        if (sparse_update(grid->sparse) < 0) {
+            return -1;
+        }
+
+        atomic_store(&grid->chunks_active, sparse_computed(grid->sparse));
+
+        grid->chunks_computed += sparse_computed(grid->sparse);
+        grid->generations += 1;
+
+        return 0;
+    }
+
+    if (grid->bitset != NULL) {
+        grid_run_bitset(grid, false);
+        return 0;
+    }
+
+    if (grid->rank != NULL) {
+        if (rank_step(grid, false) < 0) {
+            return -1;
+        }
+    } else {
+        grid_run(grid, false);
+    }
+
+    grid_changes_swap(grid);
+
+    return 0;
+}
+
+int
+grid_update_toroidal(grid_t* grid) {
+    if (grid->sparse != NULL) {
+        fprintf(stderr, "error: an unbounded grid has no toroidal topology\n");
+        return -1;
+    }
+
+    if (grid->model != NULL && grid_auto_step(grid) < 0) {
+        return -1;
+    }
+
+    if (grid->list != NULL && grid_check_density(grid) < 0) {
+        return -1;
+    }
+
+    if (grid->list != NULL) {
+        return grid_run_list(grid, true);
+    }
+
+    if (grid->bitset != NULL) {
+        grid_run_bitset(grid, true);
+        return 0;
+    }
+
+    if (grid->rank != NULL) {
+        if (rank_step(grid, true) < 0) {
+            return -1;
+        }
+    } else {
+        grid_run(grid, true);
+    }
+
+    grid_changes_swap(grid);
+
+    return 0;
+}
+
+int
+grid_advance(grid_t* grid, uint64_t generations, bool torus) {
+    // la lista avanza de una en una hasta que pasa al bitboard
+    while (grid->list != NULL && generations > 0) {
+        if ((torus ? grid_update_toroidal(grid) : grid_update(grid)) < 0) {
+            return -1;
+        }
+
+        generations -= 1;
+    }
+
+    if (grid->time_block <= 1) {
+        for (uint64_t gen = 0; gen < generations; ++gen) {
+            if ((torus ? grid_update_toroidal(grid) : grid_update(grid)) < 0) {
+                return -1;
+            }
+        }
+
+        return 0;
+    }
+
+    assert(grid->sparse == NULL);
+    assert(grid->timeblock != NULL);
+
+    while (generations > 0) {
+        size_t gens = generations < grid->time_block ? (size_t)generations : grid->time_block;
+
+        grid_topology(grid, torus);
+        timeblock_run(grid, gens, torus);
+        grid_changes_swap(grid);
+
+        generations -= gens;
+    }
 
     return 0;
 }
@@ -1,20 +1,149 @@
 #ifndef INCLUDE_GRID_GRID_H_
 #define INCLUDE_GRID_GRID_H_
 
+#include <stdbool.h>
 #include <stddef.h>
+#include <stdint.h>
 
 
-#define CHUNK_SIZE 32
+// ancho de un chunk en células, se elige al compilar con -DCHUNK_BITS=32|64|128
+#ifndef CHUNK_BITS
+#define CHUNK_BITS 32
+#endif
 
+#define CHUNK_SIZE CHUNK_BITS
+
+// con una regla Generations las células que dejan de estar vivas pasan
+// por los estados 2, 3... hasta rule.states - 1 antes de morir
 typedef enum cell_state {
     CELL_DEAD,
     CELL_ALIVE,
 } cell_state_t;
 
+typedef enum grid_kernel {
+    KERNEL_AUTO,
+    KERNEL_SCALAR,
+    KERNEL_SSE2,
+    KERNEL_AVX2,
+    KERNEL_AVX512,
+    KERNEL_LUT,
+    KERNEL_LEN,
+} grid_kernel_t;
+
+// orden de los chunks en memoria: por filas o siguiendo la curva z, o
+// sin chunks, con cada fila del grid como una tira de bits de lado a lado
+typedef enum grid_layout {
+    LAYOUT_ROWS,
+    LAYOUT_MORTON,
+    LAYOUT_BITSET,
+    LAYOUT_LEN,
+} grid_layout_t;
+
+// cómo suman los kernels los vecinos: acumulando los 8 uno a uno o
+// reutilizando la suma de tres células de cada fila en las filas vecinas
+typedef enum grid_sum {
+    SUM_AUTO,
+    SUM_ADDER,
+    SUM_ROWSUM,
+    SUM_LEN,
+} grid_sum_t;
+
+// regla B/S: el bit n de birth hace nacer una célula muerta con n
+// vecinos vivos y el de survive mantiene viva a una con n vecinos
+//
+// con range mayor que 1 es una regla Larger than Life: se cuentan las
+// células del cuadrado de lado 2 * range + 1, la propia solo si middle,
+// y las máscaras dejan paso a los intervalos cerrados de cuentas
+//
+// con más de 2 states es una regla Generations: las máscaras dicen qué
+// hacen las células vivas y las muertas, solo las vivas cuentan como
+// vecinas, y una viva que no sobrevive envejece un estado por generación
+// hasta morir en vez de morir de golpe
+typedef struct grid_rule {
+    uint16_t birth;
+    uint16_t survive;
+    uint8_t states;
+
+    uint8_t range;
+    bool middle;
+    uint8_t birth_min;
+    uint8_t birth_max;
+    uint8_t survive_min;
+    uint8_t survive_max;
+} grid_rule_t;
+
+// el vecindario de un chunk son los 3x3 chunks de alrededor, así que el
+// rango tiene que quedarse dentro de un chunk de los más pequeños
+#define RULE_MAX_RANGE 7
+
+#define RULE_MAX_STATES 8
+
+#define RULE_LIFE ((grid_rule_t) { .birth = 1U << 3U, .survive = (1U << 2U) | (1U << 3U), .states = 2, .range = 1 })
+
 typedef struct grid grid_t;
 
+typedef void (*grid_visit_fn_t)(void* ctx, int64_t row, int64_t col);
+
+// con LAYOUT_BITSET las unidades que se calculan son filas y no chunks,
+// y mientras el grid es una lista de células son células
+typedef struct grid_stats {
+    const char* unit;
+    size_t generations;
+    size_t chunks;
+    size_t chunks_active;
+    size_t chunks_computed;
+    size_t chunks_periodic;
+    size_t chunks_periodic_total;
+    bool promoted;
+    size_t promoted_at;
+    size_t promoted_cells;
+    bool memo_on;
+    size_t memo_hits;
+    size_t memo_misses;
+    size_t memo_bytes;
+} grid_stats_t;
+
+// cambio de motor con --engine auto, con las generaciones por segundo
+// del periodo anterior y del primero con el motor nuevo, o 0 si no llegó
+typedef struct grid_switch {
+    size_t generation;
+    const char* from;
+    const char* to;
+    double before;
+    double after;
+} grid_switch_t;
+
+// memoria de los dos buffers de chunks, vacía con un plano infinito
+typedef struct grid_memory {
+    size_t bytes;
+    size_t page_size;
+    bool transparent;
+    int64_t alloc_ms;
+} grid_memory_t;
+
+typedef struct grid_opts {
+    size_t threads;
+    size_t tile;
+    grid_kernel_t kernel;
+    grid_sum_t sum;
+    grid_layout_t layout;
+    grid_rule_t rule;
+    size_t time_block;
+    bool unbounded;
+    bool list;
+    size_t memo_bytes;
+    bool adaptive;
+    bool in_place;
+
+    // con ranks > 1 el grid es la franja del proceso rank, que se une a
+    // los demás por los sockets <socket>.<rank>
+    size_t rank;
+    size_t ranks;
+    const char* socket;
+} grid_opts_t;
+
 extern int
-grid_make(grid_t** grid_ptr, size_t chunk_rows, size_t chunk_cols);
+grid_make(grid_t** grid_ptr, size_t chunk_rows, size_t chunk_cols, const grid_opts_t* opts);
 
 extern void
 grid_destroy(grid_t** grid_ptr);
@@ -22,14 +151,47 @@ grid_destroy(grid_t** grid_ptr);
 extern int
 grid_set_alive(const grid_t* grid, size_t row, size_t col);
 
+extern int
+grid_set_alive_at(const grid_t* grid, int64_t row, int64_t col);
+
 extern int
 grid_set_dead(const grid_t* grid, size_t row, size_t col);
 
+// con una regla Generations state puede ser también uno de los
+// estados de envejecimiento, de 2 a rule.states - 1
 extern int
 grid_cell_state(const grid_t* grid, cell_state_t* state, size_t row, size_t col);
 
 extern int
-grid_randomize(const grid_t* grid);
+grid_visit_alive(const grid_t* grid, grid_visit_fn_t visit, void* ctx);
+
+// células muertas seguidas en la fila row desde la columna col que se
+// saben sin consultarlas una a una, 0 si no se sabe nada de la primera
+extern size_t
+grid_dead_run(const grid_t* grid, size_t row, size_t col);
+
+extern bool
+grid_unbounded(const grid_t* grid);
+
+// con varios procesos solo el primero escribe el grid entero, que
+// grid_visit_alive le entrega recogiendo las células del resto
+extern bool
+grid_root(const grid_t* grid);
+
+// activa o desactiva la caché de vecindarios, falla si el grid no tiene
+extern int
+grid_set_memo(grid_t* grid, bool on);
+
+// cambios de motor hechos con --engine auto, en orden
+extern size_t
+grid_switches(const grid_t* grid, const grid_switch_t** switches);
+
+// si avanzar puede reservar memoria porque el almacenamiento crece con el patrón
+extern bool
+grid_grows(const grid_t* grid);
+
+extern int
+grid_randomize(grid_t* grid);
 
 extern void
 grid_clear(const grid_t* grid);
@@ -37,11 +199,21 @@ grid_clear(const grid_t* grid);
 extern void
 grid_dim(const grid_t* grid, size_t* chunk_rows, size_t* chunk_cols);
 
+extern void
+grid_stats(const grid_t* grid, grid_stats_t* stats);
+
+extern void
+grid_memory(const grid_t* grid, grid_memory_t* memory);
+
 extern int
 grid_update(grid_t* grid);
 
 extern int
 grid_update_toroidal(grid_t* grid);
 
+// avanza varias generaciones, de time_block en time_block si se pidió
+extern int
+grid_advance(grid_t* grid, uint64_t generations, bool torus);
+
 
 #endif  // INCLUDE_GRID_GRID_H_
@@ -0,0 +1,342 @@
+#ifndef INCLUDE_GRID_GRID_IMPL_H_
+#define INCLUDE_GRID_GRID_IMPL_H_
+
+#include <stdatomic.h>
+#include <stdbool.h>
+#include <stddef.h>
+#include <stdint.h>
+
+#include "chunk.h"
+#include "grid.h"
+#include "auto/auto.h"
+#include "bitset/bitset.h"
+#include "inplace/inplace.h"
+#include "kernel/kernel.h"
+#include "list/list.h"
+#include "memo/memo.h"
+#include "pool/deque.h"
+#include "pool/pool.h"
+#include "rank/rank.h"
+#include "sparse/sparse.h"
+#include "timeblock/timeblock.h"
+
+#include "../syscalls/syscalls.h"
+
+
+// el grid por dentro, para grid.c y los motores que avanzan sus chunks
+// desde su propio módulo. fuera de ellos el grid sigue siendo opaco
+
+// en morton los chunks se agrupan en bloques de 8x8 guardados por filas
+// y dentro de cada bloque los bits de fila y columna se entrelazan, la
+// columna en los bits pares y la fila en los impares
+#define GRID_MORTON_POW 3U
+#define GRID_MORTON_SIDE ((size_t)1 << GRID_MORTON_POW)
+#define GRID_MORTON_LEN (GRID_MORTON_SIDE * GRID_MORTON_SIDE)
+#define GRID_MORTON_COLS ((size_t)0x55 & (GRID_MORTON_LEN - 1))
+#define GRID_MORTON_ROWS ((size_t)0xAA & (GRID_MORTON_LEN - 1))
+
+// bits de las marcas de cambio de cada chunk: si difiere de la generación
+// anterior, si difiere de la de hace dos, y si se editó desde fuera, así
+// que su estado no sale de aplicar la regla a la generación anterior
+#define GRID_CHANGED ((uint8_t)1U)
+#define GRID_CHANGED2 ((uint8_t)2U)
+#define GRID_EDITED ((uint8_t)4U)
+#define GRID_DIRTY ((uint8_t)(GRID_CHANGED | GRID_CHANGED2 | GRID_EDITED))
+
+// chunks por palabra de los mapas de ocupación
+#define GRID_OCC_POW 6U
+#define GRID_OCC_BITS ((size_t)1 << GRID_OCC_POW)
+
+struct grid {
+    size_t chunk_rows;
+    size_t chunk_cols;
+
+    // los chunks se guardan con un anillo de chunks fantasma alrededor,
+    // así todo chunk del grid tiene sus 8 vecinos en memoria. en el modo
+    // acotado el anillo está a cero y en el toroidal es una copia del
+    // borde opuesto que se refresca antes de cada generación
+    //
+    // por filas stride es el ancho con el anillo y en morton el número de
+    // bloques por fila, ya que cada bloque sigue la curva z por dentro
+    grid_layout_t layout;
+    size_t stride;
+    size_t chunks_len;
+    ptrdiff_t morton_ngb[GRID_MORTON_LEN * 9];
+
+    // con un plano infinito solo existe sparse, y chunk_rows x chunk_cols
+    // es la ventana anclada en el origen que ven la interfaz y la entrada
+    sparse_t* sparse;
+
+    // con LAYOUT_BITSET las células viven en bitset y no hay chunks
+    bitset_t* bitset;
+
+    // con una lista de células no hay chunks hasta que la densidad pasa
+    // del umbral, entonces se crea el grid con opts y ocupa el lugar de
+    // este, conservando el número de generaciones
+    list_t* list;
+    grid_opts_t opts;
+    bool grows;
+    bool promoted;
+    size_t promoted_at;
+    size_t promoted_cells;
+
+    // con --engine auto el modelo de costes mide el periodo que empieza en
+    // la generación auto_gen y decide en qué motor sigue el grid, que al
+    // cambiar se construye de nuevo y se queda con el modelo
+    auto_model_t* model;
+    size_t auto_gen;
+    int64_t auto_ms;
+    size_t auto_computed;
+
+    chunk_t* chunks;
+    chunk_t* chunks_next;
+
+    // chunks y chunks_next se intercambian, pero cada mapeo sigue
+    // perteneciendo al grid y se libera en grid_destroy
+    safe_mapping_t maps[2];
+    int64_t alloc_ms;
+
+    // con in_place no hay chunks_next ni su mapeo: cada generación se
+    // escribe sobre chunks fila de chunks a fila de chunks, e inplace
+    // guarda los bordes originales que aún hacen falta
+    bool in_place;
+    inplace_t* inplace;
+
+    // changed[i] indica si el chunk i cambió en la última generación, si
+    // está a 0 chunks[i] y chunks_next[i] son iguales y, si ningún vecino
+    // cambió tampoco, el chunk puede saltarse sin tocar ninguno de los dos
+    //
+    // con GRID_CHANGED2 a 0 en todo el vecindario éste es igual que hace
+    // dos generaciones, así que la siguiente es la anterior, que es justo
+    // lo que guarda chunks_next[i], y también puede saltarse
+    uint8_t* changed;
+    uint8_t* changed_next;
+    bool torus_last;
+
+    // mapas de ocupación de chunks y chunks_next, que se intercambian con
+    // ellos: un bit por chunk, anillo incluido, que a 0 asegura que el
+    // chunk está vacío. cada fila de chunks ocupa occ_stride palabras y
+    // tras las occ_len palabras de cada mapa va su nivel superior, con un
+    // bit por palabra que puede no ser cero, así los recorridos saltan con
+    // ctz tramos vacíos de 64 chunks y de 64 palabras
+    //
+    // sin occ_skip la generación no puede saltarse chunks por ocupación
+    uint64_t* occ;
+    uint64_t* occ_next;
+    size_t occ_stride;
+    size_t occ_len;
+    bool occ_skip;
+
+    kernel_fn_t kernel;
+    grid_rule_t rule;
+
+    // con una regla Generations chunks solo guarda las células vivas, que
+    // son las que cuentan como vecinas, y la edad de las que envejecen va
+    // en age_planes planos por chunk, seguidos a partir de idx * age_planes.
+    // la edad de la siguiente generación solo depende de la de la propia
+    // célula, así que no hace falta un segundo buffer
+    chunk_t* ages;
+    size_t age_planes;
+
+    // con varios procesos el grid es solo la franja de chunk_rows filas de
+    // chunks que empieza en la fila rank_first de las total_rows del grid
+    // entero, y las filas del anillo de arriba y abajo son las de las
+    // franjas vecinas. halos tiene los cuatro buffers del intercambio, lo
+    // que se manda y lo que se recibe por cada lado, de halo_len bytes:
+    // una fila de chunks con anillo seguida de sus marcas de cambio
+    rank_t* rank;
+    size_t rank_first;
+    size_t total_rows;
+    char* halos;
+    size_t halo_len;
+
+    pool_t* pool;
+
+    // caché de resultados por vecindario, una por trabajador para que
+    // no haya que sincronizarlas, que se consulta solo si memo_on
+    memo_t** memos;
+    size_t memos_len;
+    bool memo_on;
+
+    // planificador con robo de trabajo, solo existe si se pide
+    // un tamaño de tile y hay más de un hilo
+    size_t tile;
+    size_t tile_rows;
+    size_t tile_cols;
+    deque_t** deques;
+    _Atomic size_t tiles_left;
+
+    // bloqueo temporal: timeblock avanza varias generaciones seguidas
+    // tile a tile, y block_last dice si la última pasada fue suya
+    size_t time_block;
+    timeblock_t* timeblock;
+    bool block_last;
+
+    _Atomic size_t chunks_active;
+    _Atomic size_t chunks_periodic;
+    size_t chunks_computed;
+    size_t chunks_periodic_total;
+    size_t generations;
+};
+
+static inline size_t
+grid_morton_spread(size_t bits) {
+    bits = (bits | (bits << 2U)) & 0x33U;
+    bits = (bits | (bits << 1U)) & 0x55U;
+
+    return bits;
+}
+
+static inline size_t
+grid_morton_compact(size_t bits) {
+    bits &= GRID_MORTON_COLS;
+    bits = (bits | (bits >> 1U)) & 0x33U;
+    bits = (bits | (bits >> 2U)) & 0x0FU;
+
+    return bits;
+}
+
+// índice de un chunk en coordenadas con anillo, donde el
+// interior empieza en la fila 1 y la columna 1
+static inline size_t
+grid_idx(const grid_t* grid, size_t row, size_t col) {
+    if (grid->layout == LAYOUT_ROWS) {
+        return (row * grid->stride) + col;
+    }
+
+    size_t block = ((row >> GRID_MORTON_POW) * grid->stride) + (col >> GRID_MORTON_POW);
+    size_t inner = grid_morton_spread(col & (GRID_MORTON_SIDE - 1))
+                 | (grid_morton_spread(row & (GRID_MORTON_SIDE - 1)) << 1U);
+
+    return (block << (2 * GRID_MORTON_POW)) | inner;
+}
+
+static inline size_t
+grid_chunk_idx(const grid_t* grid, size_t chunk_row, size_t chunk_col) {
+    return grid_idx(grid, chunk_row + 1, chunk_col + 1);
+}
+
+// índices de los 9 chunks alrededor de idx, de noroeste a sureste
+static inline void
+grid_neighbourhood(const grid_t* grid, size_t idx, size_t ngb[9]) {
+    if (grid->layout == LAYOUT_ROWS) {
+        size_t up = idx - grid->stride;
+        size_t down = idx + grid->stride;
+
+        ngb[0] = up - 1;   ngb[1] = up;   ngb[2] = up + 1;
+        ngb[3] = idx - 1;  ngb[4] = idx;  ngb[5] = idx + 1;
+        ngb[6] = down - 1; ngb[7] = down; ngb[8] = down + 1;
+
+        return;
+    }
+
+    const ptrdiff_t* delta = &grid->morton_ngb[(idx & (GRID_MORTON_LEN - 1)) * 9];
+
+    for (size_t i = 0; i < 9; ++i) {
+        ngb[i] = idx + (size_t)delta[i];
+    }
+}
+
+// palabras del nivel superior de un mapa de ocupación de len palabras
+static inline size_t
+grid_occ_top_len(size_t len) {
+    return (len + GRID_OCC_BITS - 1) >> GRID_OCC_POW;
+}
+
+// bit del chunk en coordenadas con anillo, sea cual sea la disposición
+static inline size_t
+grid_occ_bit(const grid_t* grid, size_t row, size_t col) {
+    return ((row * grid->occ_stride) << GRID_OCC_POW) + col;
+}
+
+static inline bool
+grid_occ_get(const uint64_t* occ, size_t bit) {
+    return ((__atomic_load_n(&occ[bit >> GRID_OCC_POW], __ATOMIC_RELAXED) >> (bit & (GRID_OCC_BITS - 1))) & 1U) != 0;
+}
+
+// los bits se cambian con operaciones atómicas porque una misma palabra
+// puede tener chunks de tiles de trabajadores distintos. el nivel
+// superior solo se enciende aquí y se apaga al recorrerlo
+static inline void
+grid_occ_set(const grid_t* grid, uint64_t* occ, size_t bit) {
+    size_t word = bit >> GRID_OCC_POW;
+    uint64_t old = __atomic_fetch_or(&occ[word], (uint64_t)1 << (bit & (GRID_OCC_BITS - 1)), __ATOMIC_RELAXED);
+
+    if (old == 0) {
+        uint64_t* top = occ + grid->occ_len;
+
+        __atomic_fetch_or(&top[word >> GRID_OCC_POW], (uint64_t)1 << (word & (GRID_OCC_BITS - 1)), __ATOMIC_RELAXED);
+    }
+}
+
+static inline void
+grid_occ_put(const grid_t* grid, uint64_t* occ, size_t bit, bool alive) {
+    if (alive) {
+        grid_occ_set(grid, occ, bit);
+    } else {
+        __atomic_fetch_and(&occ[bit >> GRID_OCC_POW], ~((uint64_t)1 << (bit & (GRID_OCC_BITS - 1))), __ATOMIC_RELAXED);
+    }
+}
+
+// 64 bits de la fila row de occ a partir de la columna col
+static inline uint64_t
+grid_occ_window(const grid_t* grid, const uint64_t* occ, size_t row, size_t col) {
+    const uint64_t* words = &occ[row * grid->occ_stride];
+
+    size_t word = col >> GRID_OCC_POW;
+    size_t shift = col & (GRID_OCC_BITS - 1);
+
+    uint64_t low = word < grid->occ_stride ? __atomic_load_n(&words[word], __ATOMIC_RELAXED) : 0;
+
+    if (shift == 0) {
+        return low;
+    }
+
+    uint64_t high = word + 1 < grid->occ_stride ? __atomic_load_n(&words[word + 1], __ATOMIC_RELAXED) : 0;
+
+    return (low >> shift) | (high << (GRID_OCC_BITS - shift));
+}
+
+// de los 64 chunks de la fila row desde la columna col, en coordenadas con
+// anillo y col > 0, los que no pueden saltarse: los que tienen algún chunk
+// ocupado en su vecindario y los que lo están en chunks_next. el resto
+// está vacío con todo su vecindario y en los dos buffers, así que la
+// siguiente generación también está vacía y ya es lo que guarda chunks_next
+static inline uint64_t
+grid_occ_need(const grid_t* grid, size_t row, size_t col) {
+    uint64_t near = 0;
+
+    for (size_t i = row - 1; i <= row + 1; ++i) {
+        near |= grid_occ_window(grid, grid->occ, i, col - 1)
+              | grid_occ_window(grid, grid->occ, i, col)
+              | grid_occ_window(grid, grid->occ, i, col + 1);
+    }
+
+    return near | grid_occ_window(grid, grid->occ_next, row, col);
+}
+
+// estado de un trabajador durante una generación
+typedef struct grid_worker {
+    memo_t* memo;
+    size_t active;
+    size_t periodic;
+} grid_worker_t;
+
+// partes de grid.c que usan también los módulos que avanzan el grid denso
+
+extern void
+grid_update_row(const grid_t* grid, size_t row, size_t begin, size_t end, grid_worker_t* worker);
+
+extern void
+grid_topology(grid_t* grid, bool torus);
+
+// copia en las columnas del anillo las del borde opuesto
+extern void
+grid_halo_wrap_cols(const grid_t* grid);
+
+// células vivas de los chunks, con las filas en el grid entero
+extern void
+grid_visit_chunks(const grid_t* grid, grid_visit_fn_t visit, void* ctx);
+
+
+#endif  // INCLUDE_GRID_GRID_IMPL_H_
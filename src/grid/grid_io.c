@@ -1,6 +1,7 @@
 #include "grid_io.h"
 #include "grid.h"
 
+#include <inttypes.h>
 #include <stddef.h>
 #include <stdlib.h>
 #include <stdio.h>
@@ -106,7 +107,7 @@ grid_io_load(grid_t** grid_ptr, const config_t* config) {
         return grid_io_init_error(input_file);
     }
 
-    if (grid_make(grid_ptr, (size_t)chunk_rows, (size_t)chunk_cols) < 0) {
+    if (grid_make(grid_ptr, (size_t)chunk_rows, (size_t)chunk_cols, &config->grid_opts) < 0) {
         fprintf(stderr, "error: failed to make grid\n");
         return -1;
     }
@@ -115,8 +116,7 @@ grid_io_load(grid_t** grid_ptr, const config_t* config) {
         status = read_line(buf, input_file, &file_row);
 
         if (status == -1) {
-            free(*grid_ptr);
-            *grid_ptr = NULL;
+            grid_destroy(grid_ptr);
 
             return grid_io_init_error(input_file);
         } 
@@ -127,26 +127,22 @@ grid_io_load(grid_t** grid_ptr, const config_t* config) {
         int64_t row, col;
 
         if (parse_line(buf, &row, &col, &file_row) < 0) {
-            free(*grid_ptr);
-            *grid_ptr = NULL;
+            grid_destroy(grid_ptr);
 
             return grid_io_init_error(input_file);
         }
 
-        if (row < 0 || col < 0 || row >= chunk_rows * CHUNK_SIZE || col >= chunk_cols * CHUNK_SIZE) {
+        // un grid infinito acepta cualquier coordenada, también negativa
+        if (grid_set_alive_at(*grid_ptr, row, col) < 0) {
             fprintf(stderr, "error: coordinates on row %zu: '%s' outside user defined bounds\n", file_row, buf);
-            free(*grid_ptr);
-            *grid_ptr = NULL;
+            grid_destroy(grid_ptr);
 
-            return -1;
+            return grid_io_init_error(input_file);
         }
-
-        grid_set_alive(*grid_ptr, (size_t)row, (size_t)col);
     }
 
     if (fclose(input_file) < 0) {
-        free(*grid_ptr);
-        *grid_ptr = NULL;
+        grid_destroy(grid_ptr);
 
         fprintf(stderr, "error: closing input file: %s\n", strerror(errno));
         return -1;
@@ -155,8 +151,19 @@ grid_io_load(grid_t** grid_ptr, const config_t* config) {
     return 0;
 }
 
+static void
+grid_io_save_cell(void* ctx, int64_t row, int64_t col) {
+    fprintf(ctx, "\n%" PRId64 " %" PRId64, row, col);
+}
+
 int
 grid_io_save(grid_t* grid, const config_t* config) {
+    // con varios procesos solo escribe el primero, el resto le manda
+    // sus células al recorrerlas
+    if (!grid_root(grid)) {
+        return grid_visit_alive(grid, NULL, NULL);
+    }
+
     FILE* output_file = fopen(config->output_file, "w");
 
     if (output_file == NULL) {
@@ -169,15 +176,9 @@ grid_io_save(grid_t* grid, const config_t* config) {
 
     fprintf(output_file, "%zu %zu", rows, cols);
 
-    cell_state_t state;
-    for (size_t row = 0; row < rows; ++row) {
-        for (size_t col = 0; col < cols; ++col) {
-            (void)grid_cell_state(grid, &state, row, col);
-
-            if (state == CELL_ALIVE) {
-                fprintf(output_file, "\n%zu %zu", row, col);
-            }
-        }
+    if (grid_visit_alive(grid, grid_io_save_cell, output_file) < 0) {
+        fclose(output_file);
+        return -1;
     }
 
     if (fclose(output_file) < 0) {
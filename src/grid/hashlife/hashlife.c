@@ -0,0 +1,917 @@
+#include "hashlife.h"
+
+#include <assert.h>
+#include <stdbool.h>
+#include <stddef.h>
+#include <stdint.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#include "../../syscalls/syscalls.h"
+
+
+#define HL_NONE UINT32_MAX
+
+// las hojas son bloques de 8x8 células guardados en un uint64_t,
+// fila r en los bits 8r..8r+7 y la columna 0 en el bit más bajo
+#define HL_LEAF_LEVEL 3
+#define HL_LEAF_SIZE 8
+#define HL_LEAF_MASK 0xFFU
+
+// por encima de este nivel las coordenadas del plano desbordarían
+#define HL_MAX_LEVEL 60
+#define HL_MIN_ROOT 5
+
+#define HL_FREE UINT8_MAX
+
+// hl_step falla con -1 si se llena la memoria y con esto si el
+// patrón ya no cabe en el plano, que no se arregla recolectando
+#define HL_TOO_FAR (-2)
+
+#define HL_NODES_INIT 4096
+
+enum {
+    HL_NW,
+    HL_NE,
+    HL_SW,
+    HL_SE,
+    HL_QUADS,
+};
+
+// un nodo de nivel k cubre 2^k x 2^k células. los nodos son únicos: dos
+// regiones iguales comparten nodo, así el resultado memoizado de uno
+// sirve para todas las apariciones de la región en el plano y el tiempo
+typedef struct hl_node {
+    uint32_t quad[HL_QUADS];
+    uint64_t leaf;
+
+    // células vivas de la región, que se suman al crear el nodo y así la
+    // población sale de la raíz sin recorrer el árbol
+    uint64_t population;
+
+    uint32_t next;
+    uint32_t result;
+
+    uint8_t level;
+    uint8_t result_j;
+    bool mark;
+} hl_node_t;
+
+struct hashlife {
+    hl_node_t* nodes;
+    size_t nodes_len;
+    size_t nodes_cap;
+    size_t nodes_live;
+    uint32_t free_head;
+
+    uint32_t* buckets;
+    size_t buckets_mask;
+
+    uint32_t empty[HL_MAX_LEVEL + 2];
+
+    // la raíz cubre 2^level células a partir de (row, col)
+    uint32_t root;
+    int64_t row;
+    int64_t col;
+
+    grid_rule_t rule;
+
+    size_t mem_cap;
+    size_t collections;
+};
+
+static inline uint64_t
+hl_mix(uint64_t hash) {
+    hash ^= hash >> 31U;
+    hash *= 0xBF58476D1CE4E5B9ULL;
+    hash ^= hash >> 29U;
+    hash *= 0x94D049BB133111EBULL;
+    hash ^= hash >> 32U;
+
+    return hash;
+}
+
+static inline size_t
+hl_hash(const uint32_t* quad, uint64_t leaf) {
+    uint64_t hash = hl_mix(leaf ^ 0x9E3779B97F4A7C15ULL);
+
+    hash ^= hl_mix(((uint64_t)quad[HL_NW] << 32U) | quad[HL_NE]);
+    hash ^= hl_mix(((uint64_t)quad[HL_SW] << 32U) | quad[HL_SE]) * 0x9E3779B97F4A7C15ULL;
+
+    return (size_t)hash;
+}
+
+static inline size_t
+hl_node_hash(const hl_node_t* node) {
+    return hl_hash(node->quad, node->leaf);
+}
+
+static inline size_t
+hl_mem(size_t nodes, size_t buckets) {
+    return (nodes * sizeof(hl_node_t)) + (buckets * sizeof(uint32_t));
+}
+
+static void
+hl_rehash(hashlife_t* hl) {
+    for (size_t i = 0; i <= hl->buckets_mask; ++i) {
+        hl->buckets[i] = HL_NONE;
+    }
+
+    for (size_t i = 0; i < hl->nodes_len; ++i) {
+        hl_node_t* node = &hl->nodes[i];
+
+        if (node->level == HL_FREE) {
+            continue;
+        }
+
+        size_t bucket = hl_node_hash(node) & hl->buckets_mask;
+
+        node->next = hl->buckets[bucket];
+        hl->buckets[bucket] = (uint32_t)i;
+    }
+}
+
+static int
+hl_grow_buckets(hashlife_t* hl) {
+    size_t len = (hl->buckets_mask + 1) * 2;
+
+    if (hl_mem(hl->nodes_cap, len) > hl->mem_cap) {
+        return -1;
+    }
+
+    uint32_t* buckets = safe_realloc(hl->buckets, len * sizeof(uint32_t));
+
+    if (buckets == NULL) {
+        return -1;
+    }
+
+    hl->buckets = buckets;
+    hl->buckets_mask = len - 1;
+
+    hl_rehash(hl);
+
+    return 0;
+}
+
+static uint32_t
+hl_alloc(hashlife_t* hl) {
+    if (hl->free_head != HL_NONE) {
+        uint32_t idx = hl->free_head;
+        hl->free_head = hl->nodes[idx].next;
+
+        return idx;
+    }
+
+    if (hl->nodes_len == hl->nodes_cap) {
+        size_t cap = hl->nodes_cap * 2;
+
+        // al llegar al tope se avisa al llamador, que recolecta y reintenta
+        if (cap >= HL_NONE || hl_mem(cap, hl->buckets_mask + 1) > hl->mem_cap) {
+            return HL_NONE;
+        }
+
+        hl_node_t* nodes = safe_realloc(hl->nodes, cap * sizeof(hl_node_t));
+
+        if (nodes == NULL) {
+            return HL_NONE;
+        }
+
+        hl->nodes = nodes;
+        hl->nodes_cap = cap;
+    }
+
+    return (uint32_t)hl->nodes_len++;
+}
+
+// devuelve el nodo único con estos hijos u hoja, creándolo si no existe.
+// los fallos se propagan como HL_NONE, así que cualquier hijo HL_NONE
+// produce HL_NONE y los llamadores solo comprueban el resultado final
+static uint32_t
+hl_intern(hashlife_t* hl, const uint32_t* quad, uint64_t leaf, uint8_t level) {
+    for (size_t i = 0; i < HL_QUADS; ++i) {
+        if (quad[i] == HL_NONE) {
+            return HL_NONE;
+        }
+    }
+
+    size_t bucket = hl_hash(quad, leaf) & hl->buckets_mask;
+
+    for (uint32_t idx = hl->buckets[bucket]; idx != HL_NONE; idx = hl->nodes[idx].next) {
+        const hl_node_t* node = &hl->nodes[idx];
+
+        if (node->level == level && node->leaf == leaf && memcmp(node->quad, quad, sizeof(node->quad)) == 0) {
+            return idx;
+        }
+    }
+
+    if (hl->nodes_live + 1 > hl->buckets_mask + 1) {
+        if (hl_grow_buckets(hl) < 0) {
+            return HL_NONE;
+        }
+
+        bucket = hl_hash(quad, leaf) & hl->buckets_mask;
+    }
+
+    uint64_t population = (uint64_t)__builtin_popcountll(leaf);
+
+    if (level > HL_LEAF_LEVEL) {
+        population = hl->nodes[quad[HL_NW]].population + hl->nodes[quad[HL_NE]].population
+                   + hl->nodes[quad[HL_SW]].population + hl->nodes[quad[HL_SE]].population;
+    }
+
+    uint32_t idx = hl_alloc(hl);
+
+    if (idx == HL_NONE) {
+        return HL_NONE;
+    }
+
+    hl->nodes[idx] = (hl_node_t) {
+        .quad = {quad[HL_NW], quad[HL_NE], quad[HL_SW], quad[HL_SE]},
+        .leaf = leaf,
+        .population = population,
+        .next = hl->buckets[bucket],
+        .result = HL_NONE,
+        .level = level,
+        .result_j = 0,
+        .mark = false,
+    };
+
+    hl->buckets[bucket] = idx;
+    hl->nodes_live += 1;
+
+    return idx;
+}
+
+static inline uint32_t
+hl_leaf(hashlife_t* hl, uint64_t leaf) {
+    static const uint32_t none[HL_QUADS] = {0, 0, 0, 0};
+
+    return hl_intern(hl, none, leaf, HL_LEAF_LEVEL);
+}
+
+static inline uint32_t
+hl_node(hashlife_t* hl, uint32_t nw, uint32_t ne, uint32_t sw, uint32_t se) {
+    uint32_t quad[HL_QUADS] = {nw, ne, sw, se};
+
+    if (nw == HL_NONE) {
+        return HL_NONE;
+    }
+
+    return hl_intern(hl, quad, 0, (uint8_t)(hl->nodes[nw].level + 1));
+}
+
+static inline uint32_t
+hl_quad(const hashlife_t* hl, uint32_t idx, size_t quad) {
+    return idx == HL_NONE ? HL_NONE : hl->nodes[idx].quad[quad];
+}
+
+static inline uint32_t
+hl_leaf_row(uint64_t leaf, size_t row) {
+    return (uint32_t)(leaf >> (row * HL_LEAF_SIZE)) & HL_LEAF_MASK;
+}
+
+// junta las cuatro hojas de un nodo de nivel 4 en 16 filas de 16 bits
+static void
+hl_rows16(const hashlife_t* hl, uint32_t idx, uint32_t* rows) {
+    const hl_node_t* node = &hl->nodes[idx];
+
+    uint64_t nw = hl->nodes[node->quad[HL_NW]].leaf;
+    uint64_t ne = hl->nodes[node->quad[HL_NE]].leaf;
+    uint64_t sw = hl->nodes[node->quad[HL_SW]].leaf;
+    uint64_t se = hl->nodes[node->quad[HL_SE]].leaf;
+
+    for (size_t row = 0; row < HL_LEAF_SIZE; ++row) {
+        rows[row] = hl_leaf_row(nw, row) | (hl_leaf_row(ne, row) << HL_LEAF_SIZE);
+        rows[row + HL_LEAF_SIZE] = hl_leaf_row(sw, row) | (hl_leaf_row(se, row) << HL_LEAF_SIZE);
+    }
+}
+
+static uint64_t
+hl_centre16(const uint32_t* rows) {
+    uint64_t leaf = 0;
+
+    for (size_t row = 0; row < HL_LEAF_SIZE; ++row) {
+        uint64_t bits = (rows[row + (HL_LEAF_SIZE / 2)] >> (HL_LEAF_SIZE / 2)) & HL_LEAF_MASK;
+        leaf |= bits << (row * HL_LEAF_SIZE);
+    }
+
+    return leaf;
+}
+
+// una generación de la regla sobre 16x16 células, lo que queda fuera se
+// toma como muerto, que solo estropea un anillo más del borde por paso.
+// los resultados se memoizan, así que aquí basta con la regla genérica
+static void
+hl_life16(uint32_t* rows, const grid_rule_t* rule) {
+    uint32_t next[2 * HL_LEAF_SIZE];
+
+    for (size_t row = 0; row < 2 * HL_LEAF_SIZE; ++row) {
+        uint32_t up = row > 0 ? rows[row - 1] : 0;
+        uint32_t down = row < (2 * HL_LEAF_SIZE) - 1 ? rows[row + 1] : 0;
+        uint32_t curr = rows[row];
+
+        uint32_t ngb[8] = {
+            up << 1U, up, up >> 1U,
+            curr << 1U, curr >> 1U,
+            down << 1U, down, down >> 1U,
+        };
+
+        // contador de 4 bits por célula
+        uint32_t sum[4] = {0, 0, 0, 0};
+
+        for (size_t i = 0; i < 8; ++i) {
+            uint32_t carry = ngb[i];
+
+            for (size_t bit = 0; bit < 4; ++bit) {
+                uint32_t out = sum[bit] & carry;
+                sum[bit] ^= carry;
+                carry = out;
+            }
+        }
+
+        uint32_t keep = 0;
+        uint32_t born = 0;
+
+        for (unsigned count = 0; count <= 8; ++count) {
+            uint32_t eq = ~0U;
+
+            for (size_t bit = 0; bit < 4; ++bit) {
+                eq &= ((count >> bit) & 1U) != 0 ? sum[bit] : ~sum[bit];
+            }
+
+            keep |= ((rule->survive >> count) & 1U) != 0 ? eq : 0;
+            born |= ((rule->birth >> count) & 1U) != 0 ? eq : 0;
+        }
+
+        next[row] = ((curr & keep) | (~curr & born)) & 0xFFFFU;
+    }
+
+    memcpy(rows, next, sizeof(next));
+}
+
+// el nodo de nivel k-1 centrado dentro de uno de nivel k, sin avanzar
+static uint32_t
+hl_centre(hashlife_t* hl, uint32_t idx) {
+    if (idx == HL_NONE) {
+        return HL_NONE;
+    }
+
+    if (hl->nodes[idx].level == HL_LEAF_LEVEL + 1) {
+        uint32_t rows[2 * HL_LEAF_SIZE];
+        hl_rows16(hl, idx, rows);
+
+        return hl_leaf(hl, hl_centre16(rows));
+    }
+
+    const hl_node_t* node = &hl->nodes[idx];
+
+    return hl_node(hl,
+                   hl->nodes[node->quad[HL_NW]].quad[HL_SE],
+                   hl->nodes[node->quad[HL_NE]].quad[HL_SW],
+                   hl->nodes[node->quad[HL_SW]].quad[HL_NE],
+                   hl->nodes[node->quad[HL_SE]].quad[HL_NW]);
+}
+
+// el centro de nivel k-1 de un nodo de nivel k avanzado 2^min(j, k-2)
+// generaciones, el resultado se guarda en el propio nodo junto con j
+static uint32_t
+hl_result(hashlife_t* hl, uint32_t idx, unsigned j) {
+    if (idx == HL_NONE) {
+        return HL_NONE;
+    }
+
+    unsigned level = hl->nodes[idx].level;
+
+    assert(level > HL_LEAF_LEVEL);
+
+    if (j > level - 2) {
+        j = level - 2;
+    }
+
+    if (hl->nodes[idx].result != HL_NONE && hl->nodes[idx].result_j == j) {
+        return hl->nodes[idx].result;
+    }
+
+    if (idx == hl->empty[level]) {
+        return hl->empty[level - 1];
+    }
+
+    uint32_t result;
+
+    if (level == HL_LEAF_LEVEL + 1) {
+        uint32_t rows[2 * HL_LEAF_SIZE];
+        hl_rows16(hl, idx, rows);
+
+        for (size_t gen = 0; gen < ((size_t)1 << j); ++gen) {
+            hl_life16(rows, &hl->rule);
+        }
+
+        result = hl_leaf(hl, hl_centre16(rows));
+    } else {
+        uint32_t nw = hl->nodes[idx].quad[HL_NW];
+        uint32_t ne = hl->nodes[idx].quad[HL_NE];
+        uint32_t sw = hl->nodes[idx].quad[HL_SW];
+        uint32_t se = hl->nodes[idx].quad[HL_SE];
+
+        // los 9 subnodos de nivel k-1 que se solapan a medias
+        uint32_t sub[9] = {
+            nw,
+            hl_node(hl, hl_quad(hl, nw, HL_NE), hl_quad(hl, ne, HL_NW), hl_quad(hl, nw, HL_SE), hl_quad(hl, ne, HL_SW)),
+            ne,
+            hl_node(hl, hl_quad(hl, nw, HL_SW), hl_quad(hl, nw, HL_SE), hl_quad(hl, sw, HL_NW), hl_quad(hl, sw, HL_NE)),
+            hl_node(hl, hl_quad(hl, nw, HL_SE), hl_quad(hl, ne, HL_SW), hl_quad(hl, sw, HL_NE), hl_quad(hl, se, HL_NW)),
+            hl_node(hl, hl_quad(hl, ne, HL_SW), hl_quad(hl, ne, HL_SE), hl_quad(hl, se, HL_NW), hl_quad(hl, se, HL_NE)),
+            sw,
+            hl_node(hl, hl_quad(hl, sw, HL_NE), hl_quad(hl, se, HL_NW), hl_quad(hl, sw, HL_SE), hl_quad(hl, se, HL_SW)),
+            se,
+        };
+
+        // a toda velocidad cada mitad del salto se hace con un resultado,
+        // si el paso pedido es menor la primera mitad solo recorta el centro
+        for (size_t i = 0; i < 9; ++i) {
+            sub[i] = j == level - 2 ? hl_result(hl, sub[i], j) : hl_centre(hl, sub[i]);
+        }
+
+        result = hl_node(hl,
+                         hl_result(hl, hl_node(hl, sub[0], sub[1], sub[3], sub[4]), j),
+                         hl_result(hl, hl_node(hl, sub[1], sub[2], sub[4], sub[5]), j),
+                         hl_result(hl, hl_node(hl, sub[3], sub[4], sub[6], sub[7]), j),
+                         hl_result(hl, hl_node(hl, sub[4], sub[5], sub[7], sub[8]), j));
+    }
+
+    if (result != HL_NONE) {
+        hl->nodes[idx].result = result;
+        hl->nodes[idx].result_j = (uint8_t)j;
+    }
+
+    return result;
+}
+
+static void
+hl_mark(hashlife_t* hl, uint32_t idx) {
+    if (hl->nodes[idx].mark) {
+        return;
+    }
+
+    hl->nodes[idx].mark = true;
+
+    if (hl->nodes[idx].level > HL_LEAF_LEVEL) {
+        for (size_t i = 0; i < HL_QUADS; ++i) {
+            hl_mark(hl, hl->nodes[idx].quad[i]);
+        }
+    }
+}
+
+// solo sobreviven la raíz y los nodos vacíos, los resultados memoizados
+// que apuntan a nodos recolectados se olvidan y se recalculan si hacen falta
+static void
+hl_collect(hashlife_t* hl) {
+    hl_mark(hl, hl->root);
+
+    for (size_t level = HL_LEAF_LEVEL; level <= HL_MAX_LEVEL + 1; ++level) {
+        if (hl->empty[level] != HL_NONE) {
+            hl_mark(hl, hl->empty[level]);
+        }
+    }
+
+    hl->free_head = HL_NONE;
+    hl->nodes_live = 0;
+
+    for (size_t i = hl->nodes_len; i > 0; --i) {
+        hl_node_t* node = &hl->nodes[i - 1];
+
+        if (node->level != HL_FREE && node->mark) {
+            hl->nodes_live += 1;
+            continue;
+        }
+
+        node->level = HL_FREE;
+        node->next = hl->free_head;
+        hl->free_head = (uint32_t)(i - 1);
+    }
+
+    for (size_t i = 0; i < hl->nodes_len; ++i) {
+        hl_node_t* node = &hl->nodes[i];
+
+        if (node->level == HL_FREE) {
+            continue;
+        }
+
+        if (node->result != HL_NONE && !hl->nodes[node->result].mark) {
+            node->result = HL_NONE;
+        }
+    }
+
+    for (size_t i = 0; i < hl->nodes_len; ++i) {
+        hl->nodes[i].mark = false;
+    }
+
+    hl_rehash(hl);
+
+    hl->collections += 1;
+}
+
+static int
+hl_empties(hashlife_t* hl) {
+    hl->empty[HL_LEAF_LEVEL] = hl_leaf(hl, 0);
+
+    for (size_t level = HL_LEAF_LEVEL + 1; level <= HL_MAX_LEVEL + 1; ++level) {
+        uint32_t sub = hl->empty[level - 1];
+        hl->empty[level] = hl_node(hl, sub, sub, sub, sub);
+    }
+
+    return hl->empty[HL_MAX_LEVEL + 1] == HL_NONE ? -1 : 0;
+}
+
+int
+hashlife_make(hashlife_t** hashlife_ptr, size_t mem_cap, grid_rule_t rule) {
+    hl_node_t* nodes = safe_malloc(HL_NODES_INIT * sizeof(hl_node_t));
+    uint32_t* buckets = safe_malloc(HL_NODES_INIT * sizeof(uint32_t));
+
+    if (nodes == NULL || buckets == NULL) {
+        free(nodes);
+        free(buckets);
+
+        fprintf(stderr, "error: failed to allocate memory for hashlife nodes\n");
+        return -1;
+    }
+
+    *hashlife_ptr = safe_malloc(sizeof(hashlife_t));
+
+    if (*hashlife_ptr == NULL) {
+        free(nodes);
+        free(buckets);
+
+        fprintf(stderr, "error: failed to allocate memory for hashlife\n");
+        return -1;
+    }
+
+    **hashlife_ptr = (hashlife_t) {
+        .nodes = nodes,
+        .nodes_len = 0,
+        .nodes_cap = HL_NODES_INIT,
+        .nodes_live = 0,
+        .free_head = HL_NONE,
+
+        .buckets = buckets,
+        .buckets_mask = HL_NODES_INIT - 1,
+
+        .root = HL_NONE,
+        .row = 0,
+        .col = 0,
+
+        .rule = rule,
+
+        .mem_cap = mem_cap,
+        .collections = 0,
+    };
+
+    for (size_t i = 0; i < HL_NODES_INIT; ++i) {
+        buckets[i] = HL_NONE;
+    }
+
+    if (hl_empties(*hashlife_ptr) < 0) {
+        hashlife_destroy(hashlife_ptr);
+
+        fprintf(stderr, "error: hashlife memory cap too small\n");
+        return -1;
+    }
+
+    (*hashlife_ptr)->root = (*hashlife_ptr)->empty[HL_MIN_ROOT];
+
+    return 0;
+}
+
+void
+hashlife_destroy(hashlife_t** hashlife_ptr) {
+    free((*hashlife_ptr)->nodes);
+    free((*hashlife_ptr)->buckets);
+    free(*hashlife_ptr);
+
+    *hashlife_ptr = NULL;
+}
+
+static uint32_t
+hl_set(hashlife_t* hl, uint32_t idx, uint64_t row, uint64_t col) {
+    unsigned level = hl->nodes[idx].level;
+
+    if (level == HL_LEAF_LEVEL) {
+        return hl_leaf(hl, hl->nodes[idx].leaf | ((uint64_t)1 << ((row * HL_LEAF_SIZE) + col)));
+    }
+
+    uint64_t half = (uint64_t)1 << (level - 1);
+    size_t quad = (row >= half ? HL_SW : HL_NW) + (col >= half ? 1 : 0);
+
+    uint32_t sub[HL_QUADS];
+    memcpy(sub, hl->nodes[idx].quad, sizeof(sub));
+
+    sub[quad] = hl_set(hl, sub[quad], row & (half - 1), col & (half - 1));
+
+    return hl_node(hl, sub[HL_NW], sub[HL_NE], sub[HL_SW], sub[HL_SE]);
+}
+
+typedef struct hl_import {
+    hashlife_t* hl;
+
+    bool empty;
+    int64_t min_row;
+    int64_t min_col;
+    int64_t max_row;
+    int64_t max_col;
+
+    bool failed;
+} hl_import_t;
+
+static void
+hl_import_bounds(void* ctx, int64_t row, int64_t col) {
+    hl_import_t* import = ctx;
+
+    if (import->empty) {
+        import->min_row = import->max_row = row;
+        import->min_col = import->max_col = col;
+        import->empty = false;
+        return;
+    }
+
+    import->min_row = row < import->min_row ? row : import->min_row;
+    import->min_col = col < import->min_col ? col : import->min_col;
+    import->max_row = row > import->max_row ? row : import->max_row;
+    import->max_col = col > import->max_col ? col : import->max_col;
+}
+
+static void
+hl_import_cell(void* ctx, int64_t row, int64_t col) {
+    hl_import_t* import = ctx;
+    hashlife_t* hl = import->hl;
+
+    if (import->failed) {
+        return;
+    }
+
+    uint64_t local_row = (uint64_t)(row - hl->row);
+    uint64_t local_col = (uint64_t)(col - hl->col);
+
+    uint32_t root = hl_set(hl, hl->root, local_row, local_col);
+
+    // cada célula deja atrás el camino anterior hasta la raíz, al
+    // llenarse la memoria se recolecta y se vuelve a intentar
+    if (root == HL_NONE) {
+        hl_collect(hl);
+        root = hl_set(hl, hl->root, local_row, local_col);
+    }
+
+    if (root == HL_NONE) {
+        import->failed = true;
+        return;
+    }
+
+    hl->root = root;
+}
+
+int
+hashlife_import(hashlife_t* hashlife, const grid_t* grid) {
+    hl_import_t import = {
+        .hl = hashlife,
+        .empty = true,
+        .failed = false,
+    };
+
+    if (grid_visit_alive(grid, hl_import_bounds, &import) < 0) {
+        return -1;
+    }
+
+    hashlife->root = hashlife->empty[HL_MIN_ROOT];
+    hashlife->row = 0;
+    hashlife->col = 0;
+
+    if (import.empty) {
+        return 0;
+    }
+
+    uint64_t extent = (uint64_t)(import.max_row - import.min_row);
+    uint64_t width = (uint64_t)(import.max_col - import.min_col);
+
+    extent = width > extent ? width : extent;
+
+    size_t level = HL_MIN_ROOT;
+    while (level <= HL_MAX_LEVEL && ((uint64_t)1 << level) <= extent) {
+        ++level;
+    }
+
+    if (level > HL_MAX_LEVEL) {
+        fprintf(stderr, "error: pattern too large for hashlife\n");
+        return -1;
+    }
+
+    hashlife->root = hashlife->empty[level];
+    hashlife->row = import.min_row;
+    hashlife->col = import.min_col;
+
+    if (grid_visit_alive(grid, hl_import_cell, &import) < 0 || import.failed) {
+        fprintf(stderr, "error: hashlife memory cap reached while importing\n");
+        return -1;
+    }
+
+    return 0;
+}
+
+static int
+hl_export(const hashlife_t* hl, const grid_t* grid, uint32_t idx, int64_t row, int64_t col) {
+    const hl_node_t* node = &hl->nodes[idx];
+
+    if (idx == hl->empty[node->level]) {
+        return 0;
+    }
+
+    if (node->level == HL_LEAF_LEVEL) {
+        for (uint64_t leaf = node->leaf; leaf != 0; leaf &= leaf - 1) {
+            int64_t bit = __builtin_ctzll(leaf);
+
+            if (grid_set_alive_at(grid, row + (bit / HL_LEAF_SIZE), col + (bit % HL_LEAF_SIZE)) < 0) {
+                return -1;
+            }
+        }
+
+        return 0;
+    }
+
+    int64_t half = (int64_t)1 << (node->level - 1);
+
+    if (hl_export(hl, grid, node->quad[HL_NW], row, col) < 0 ||
+        hl_export(hl, grid, node->quad[HL_NE], row, col + half) < 0 ||
+        hl_export(hl, grid, node->quad[HL_SW], row + half, col) < 0 ||
+        hl_export(hl, grid, node->quad[HL_SE], row + half, col + half) < 0) {
+        return -1;
+    }
+
+    return 0;
+}
+
+int
+hashlife_export(const hashlife_t* hashlife, const grid_t* grid) {
+    grid_clear(grid);
+
+    if (hl_export(hashlife, grid, hashlife->root, hashlife->row, hashlife->col) < 0) {
+        fprintf(stderr, "error: hashlife pattern does not fit in the grid\n");
+        return -1;
+    }
+
+    return 0;
+}
+
+// la raíz tiene a su alrededor un anillo vacío de un cuarto de su lado
+static bool
+hl_centred(const hashlife_t* hl, uint32_t idx) {
+    const hl_node_t* node = &hl->nodes[idx];
+    uint32_t empty = hl->empty[node->level - 2];
+
+    const hl_node_t* nw = &hl->nodes[node->quad[HL_NW]];
+    const hl_node_t* ne = &hl->nodes[node->quad[HL_NE]];
+    const hl_node_t* sw = &hl->nodes[node->quad[HL_SW]];
+    const hl_node_t* se = &hl->nodes[node->quad[HL_SE]];
+
+    return nw->quad[HL_NW] == empty && nw->quad[HL_NE] == empty && nw->quad[HL_SW] == empty
+        && ne->quad[HL_NW] == empty && ne->quad[HL_NE] == empty && ne->quad[HL_SE] == empty
+        && sw->quad[HL_NW] == empty && sw->quad[HL_SW] == empty && sw->quad[HL_SE] == empty
+        && se->quad[HL_NE] == empty && se->quad[HL_SW] == empty && se->quad[HL_SE] == empty;
+}
+
+static int
+hl_expand(hashlife_t* hl) {
+    unsigned level = hl->nodes[hl->root].level;
+
+    if (level >= HL_MAX_LEVEL) {
+        return HL_TOO_FAR;
+    }
+
+    uint32_t root = hl->root;
+    uint32_t border = hl->empty[level - 1];
+
+    uint32_t expanded = hl_node(hl,
+                                hl_node(hl, border, border, border, hl_quad(hl, root, HL_NW)),
+                                hl_node(hl, border, border, hl_quad(hl, root, HL_NE), border),
+                                hl_node(hl, border, hl_quad(hl, root, HL_SW), border, border),
+                                hl_node(hl, hl_quad(hl, root, HL_SE), border, border, border));
+
+    if (expanded == HL_NONE) {
+        return -1;
+    }
+
+    int64_t shift = (int64_t)1 << (level - 1);
+
+    hl->root = expanded;
+    hl->row -= shift;
+    hl->col -= shift;
+
+    return 0;
+}
+
+static int
+hl_step(hashlife_t* hl, unsigned j) {
+    int status;
+
+    // primero se deja la raíz con margen suficiente para que el patrón no
+    // pueda salirse del centro en 2^j generaciones, luego se avanza
+    while (hl->nodes[hl->root].level < j + 2 || !hl_centred(hl, hl->root)) {
+        if ((status = hl_expand(hl)) < 0) {
+            return status;
+        }
+    }
+
+    if ((status = hl_expand(hl)) < 0) {
+        return status;
+    }
+
+    unsigned level = hl->nodes[hl->root].level;
+    uint32_t result = hl_result(hl, hl->root, j);
+
+    if (result == HL_NONE) {
+        return -1;
+    }
+
+    int64_t shift = (int64_t)1 << (level - 2);
+
+    hl->root = result;
+    hl->row += shift;
+    hl->col += shift;
+
+    return 0;
+}
+
+// avanza 2^j generaciones. si se llena la memoria a mitad del salto se
+// recolecta todo lo que no cuelga de la raíz y se repite, y si ni así
+// cabe se parte en dos saltos de 2^(j-1), que necesitan menos nodos
+static int
+hl_advance_pow(hashlife_t* hl, unsigned j) {
+    uint32_t root = hl->root;
+    int64_t row = hl->row;
+    int64_t col = hl->col;
+
+    if (hl_mem(hl->nodes_live, hl->buckets_mask + 1) > hl->mem_cap / 2) {
+        hl_collect(hl);
+    }
+
+    int status = hl_step(hl, j);
+
+    if (status != -1) {
+        return status;
+    }
+
+    hl->root = root;
+    hl->row = row;
+    hl->col = col;
+
+    hl_collect(hl);
+
+    if (hl_step(hl, j) == 0) {
+        return 0;
+    }
+
+    hl->root = root;
+    hl->row = row;
+    hl->col = col;
+
+    if (j == 0) {
+        return -1;
+    }
+
+    if ((status = hl_advance_pow(hl, j - 1)) < 0) {
+        return status;
+    }
+
+    return hl_advance_pow(hl, j - 1);
+}
+
+int
+hashlife_advance(hashlife_t* hashlife, uint64_t steps) {
+    // cada bit del número de pasos es un salto de 2^j generaciones
+    for (unsigned j = 0; j < 64 && (steps >> j) != 0; ++j) {
+        if (((steps >> j) & 1U) == 0) {
+            continue;
+        }
+
+        int status = hl_advance_pow(hashlife, j);
+
+        if (status == HL_TOO_FAR) {
+            fprintf(stderr, "error: pattern grew beyond the hashlife plane\n");
+            return -1;
+        }
+        if (status < 0) {
+            fprintf(stderr, "error: hashlife memory cap reached\n");
+            return -1;
+        }
+    }
+
+    return 0;
+}
+
+void
+hashlife_stats(const hashlife_t* hashlife, hashlife_stats_t* stats) {
+    *stats = (hashlife_stats_t) {
+        .nodes = hashlife->nodes_live,
+        .collections = hashlife->collections,
+        .level = hashlife->nodes[hashlife->root].level,
+        .population = hashlife->nodes[hashlife->root].population,
+    };
+}
@@ -0,0 +1,41 @@
+#ifndef INCLUDE_HASHLIFE_HASHLIFE_H_
+#define INCLUDE_HASHLIFE_HASHLIFE_H_
+
+#include <stddef.h>
+#include <stdint.h>
+
+#include "../grid.h"
+
+
+// memoria máxima de la tabla de nodos antes de recolectar
+#define HASHLIFE_MEM_DEFAULT ((size_t)1 << 30)
+
+typedef struct hashlife hashlife_t;
+
+typedef struct hashlife_stats {
+    size_t nodes;
+    size_t collections;
+    size_t level;
+    uint64_t population;
+} hashlife_stats_t;
+
+extern int
+hashlife_make(hashlife_t** hashlife_ptr, size_t mem_cap, grid_rule_t rule);
+
+extern void
+hashlife_destroy(hashlife_t** hashlife_ptr);
+
+extern int
+hashlife_import(hashlife_t* hashlife, const grid_t* grid);
+
+extern int
+hashlife_export(const hashlife_t* hashlife, const grid_t* grid);
+
+extern int
+hashlife_advance(hashlife_t* hashlife, uint64_t steps);
+
+extern void
+hashlife_stats(const hashlife_t* hashlife, hashlife_stats_t* stats);
+
+
+#endif  // INCLUDE_HASHLIFE_HASHLIFE_H_
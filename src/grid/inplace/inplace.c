@@ -0,0 +1,289 @@
+#include "inplace.h"
+
+#include <stdatomic.h>
+#include <stdbool.h>
+#include <stddef.h>
+#include <stdint.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#include "../grid_impl.h"
+#include "../kernel/kernel.h"
+#include "../memo/memo.h"
+#include "../pool/pool.h"
+
+#include "../../syscalls/syscalls.h"
+
+
+struct inplace {
+    chunk_word_t* edges;
+    uint64_t* saved;
+};
+
+// tres filas de bordes por trabajador, la de arriba, la que se va
+// guardando y la de abajo de su franja, con dos mapas de cuáles valen
+int
+inplace_make(inplace_t** inplace_ptr, size_t chunk_cols, size_t occ_stride, size_t workers) {
+    *inplace_ptr = safe_malloc(sizeof(inplace_t));
+
+    if (*inplace_ptr == NULL) {
+        fprintf(stderr, "error: failed to allocate memory for in-place edges\n");
+        return -1;
+    }
+
+    size_t width = chunk_cols + 2;
+
+    **inplace_ptr = (inplace_t) {
+        .edges = safe_calloc(3 * width * workers, sizeof(chunk_word_t)),
+        .saved = safe_calloc(2 * occ_stride * workers, sizeof(uint64_t)),
+    };
+
+    if ((*inplace_ptr)->edges == NULL || (*inplace_ptr)->saved == NULL) {
+        inplace_destroy(inplace_ptr);
+
+        fprintf(stderr, "error: failed to allocate memory for in-place edges\n");
+        return -1;
+    }
+
+    return 0;
+}
+
+void
+inplace_destroy(inplace_t** inplace_ptr) {
+    free((*inplace_ptr)->edges);
+    free((*inplace_ptr)->saved);
+    free(*inplace_ptr);
+
+    *inplace_ptr = NULL;
+}
+
+// estado de un trabajador en la actualización en el sitio. de la fila de
+// chunks anterior, ya escrita, guarda la palabra de abajo que tenía cada
+// chunk escrito, marcado en saved, y de la fila que sigue a su franja,
+// que puede estar escribiendo otro trabajador, la palabra de arriba. el
+// último chunk calculado se queda en pending hasta calcular el siguiente,
+// que aún lo necesita como vecino tal y como estaba
+typedef struct inplace_worker {
+    chunk_word_t* north;
+    chunk_word_t* north_next;
+    chunk_word_t* south;
+    uint64_t* saved;
+    uint64_t* saved_next;
+    bool last;
+
+    chunk_t pending;
+    size_t pending_idx;
+    size_t pending_col;
+    bool has_pending;
+} inplace_worker_t;
+
+static inline inplace_worker_t
+inplace_state(const grid_t* grid, size_t worker) {
+    size_t width = grid->chunk_cols + 2;
+    chunk_word_t* edges = &grid->inplace->edges[3 * width * worker];
+    uint64_t* saved = &grid->inplace->saved[2 * grid->occ_stride * worker];
+
+    return (inplace_worker_t) {
+        .north = edges,
+        .north_next = edges + width,
+        .south = edges + (2 * width),
+        .saved = saved,
+        .saved_next = saved + grid->occ_stride,
+        .last = false,
+        .has_pending = false,
+    };
+}
+
+static inline void
+inplace_band_span(const grid_t* grid, size_t worker, size_t workers, size_t* begin, size_t* end) {
+    *begin = grid->chunk_rows * worker / workers;
+    *end = grid->chunk_rows * (worker + 1) / workers;
+}
+
+// escribe el chunk pendiente, guardando antes su borde de abajo para la
+// fila siguiente
+static inline void
+inplace_flush(const grid_t* grid, inplace_worker_t* state) {
+    if (!state->has_pending) {
+        return;
+    }
+
+    chunk_t* chunk = &grid->chunks[state->pending_idx];
+    size_t col = state->pending_col;
+
+    state->north_next[col] = chunk->rows[CHUNK_LAST];
+    state->saved_next[col >> GRID_OCC_POW] |= (uint64_t)1 << (col & (GRID_OCC_BITS - 1));
+
+    *chunk = state->pending;
+    state->has_pending = false;
+}
+
+// como grid_update_chunk, pero los vecinos de arriba ya están escritos y
+// su borde sale de lo guardado, y sin chunks_next no hay generación
+// anterior con la que ver si el vecindario se repite cada dos
+static void
+inplace_chunk(const grid_t* grid, size_t idx, size_t row, size_t col, inplace_worker_t* state, grid_worker_t* worker) {
+    size_t ngb[9];
+    grid_neighbourhood(grid, idx, ngb);
+
+    const uint8_t* changed = grid->changed;
+
+    uint8_t active = changed[ngb[0]] | changed[ngb[1]] | changed[ngb[2]]
+                   | changed[ngb[3]] | changed[ngb[4]] | changed[ngb[5]]
+                   | changed[ngb[6]] | changed[ngb[7]] | changed[ngb[8]];
+
+    // nada ha cambiado alrededor y el chunk ya es su siguiente estado
+    if (!active) {
+        grid->changed_next[idx] = 0;
+        return;
+    }
+
+    const chunk_t* chunks = grid->chunks;
+
+    chunk_word_t west[CHUNK_PADDED];
+    chunk_word_t centre[CHUNK_PADDED];
+    chunk_word_t east[CHUNK_PADDED];
+    chunk_word_t* columns[] = {west, centre, east};
+
+    for (size_t i = 0; i < 3; ++i) {
+        size_t at = col - 1 + i;
+        bool saved = ((state->saved[at >> GRID_OCC_POW] >> (at & (GRID_OCC_BITS - 1))) & 1U) != 0;
+
+        columns[i][0] = saved ? state->north[at] : chunks[ngb[i]].rows[CHUNK_LAST];
+        columns[i][CHUNK_PADDED - 1] = state->last ? state->south[at] : chunks[ngb[6 + i]].rows[0];
+
+        memcpy(columns[i] + 1, chunks[ngb[3 + i]].rows, sizeof(chunks->rows));
+    }
+
+    chunk_t next;
+    unsigned flags;
+
+    if (worker->memo == NULL || !memo_lookup(worker->memo, west, centre, east, next.rows, &flags)) {
+        flags = grid->kernel(west, centre, east, next.rows, &grid->rule);
+
+        if (worker->memo != NULL) {
+            memo_store(worker->memo, next.rows, flags);
+        }
+    }
+
+    bool flag = (flags & KERNEL_CHANGED) != 0;
+    bool alive = (flags & KERNEL_ALIVE) != 0;
+
+    size_t bit = grid_occ_bit(grid, row, col);
+
+    if (alive != grid_occ_get(grid->occ_next, bit)) {
+        grid_occ_put(grid, grid->occ_next, bit, alive);
+    }
+
+    // un chunk que cambia siempre se da por distinto al de hace dos, así
+    // ningún vecindario se salta como periódico
+    grid->changed_next[idx] = flag ? (uint8_t)(GRID_CHANGED | GRID_CHANGED2) : 0;
+    worker->active += 1;
+
+    // el que no cambia no hace falta escribirlo
+    if (flag) {
+        inplace_flush(grid, state);
+
+        state->pending = next;
+        state->pending_idx = idx;
+        state->pending_col = col;
+        state->has_pending = true;
+    }
+}
+
+static void
+inplace_row(const grid_t* grid, size_t row, inplace_worker_t* state, grid_worker_t* worker) {
+    memset(state->saved_next, 0, grid->occ_stride * sizeof(uint64_t));
+
+    for (size_t col = 0; col < grid->chunk_cols; col += GRID_OCC_BITS) {
+        size_t len = grid->chunk_cols - col < GRID_OCC_BITS ? grid->chunk_cols - col : GRID_OCC_BITS;
+        uint64_t span = len == GRID_OCC_BITS ? ~(uint64_t)0 : ((uint64_t)1 << len) - 1;
+        uint64_t need = grid->occ_skip ? grid_occ_need(grid, row + 1, col + 1) & span : span;
+
+        if (need != span && grid->layout == LAYOUT_ROWS) {
+            memset(&grid->changed_next[grid_chunk_idx(grid, row, col)], 0, len);
+        } else {
+            for (uint64_t skip = span & ~need; skip != 0; skip &= skip - 1) {
+                grid->changed_next[grid_chunk_idx(grid, row, col + (size_t)__builtin_ctzll(skip))] = 0;
+            }
+        }
+
+        for (; need != 0; need &= need - 1) {
+            size_t at = col + (size_t)__builtin_ctzll(need);
+
+            inplace_chunk(grid, grid_chunk_idx(grid, row, at), row + 1, at + 1, state, worker);
+        }
+    }
+
+    inplace_flush(grid, state);
+
+    chunk_word_t* north = state->north;
+    state->north = state->north_next;
+    state->north_next = north;
+
+    uint64_t* saved = state->saved;
+    state->saved = state->saved_next;
+    state->saved_next = saved;
+}
+
+// antes de escribir nada cada trabajador guarda los bordes de las filas
+// vecinas de su franja, que pertenecen a otros, y los da todos por buenos
+static void
+inplace_save(void* arg, size_t worker, size_t workers) {
+    const grid_t* grid = arg;
+
+    size_t begin, end;
+    inplace_band_span(grid, worker, workers, &begin, &end);
+
+    if (begin == end) {
+        return;
+    }
+
+    inplace_worker_t state = inplace_state(grid, worker);
+
+    for (size_t col = 0; col < grid->chunk_cols + 2; ++col) {
+        state.north[col] = grid->chunks[grid_idx(grid, begin, col)].rows[CHUNK_LAST];
+        state.south[col] = grid->chunks[grid_idx(grid, end + 1, col)].rows[0];
+    }
+
+    memset(state.saved, 0xff, grid->occ_stride * sizeof(uint64_t));
+}
+
+static void
+inplace_band(void* arg, size_t worker, size_t workers) {
+    grid_t* grid = arg;
+
+    size_t begin, end;
+    inplace_band_span(grid, worker, workers, &begin, &end);
+
+    inplace_worker_t state = inplace_state(grid, worker);
+
+    grid_worker_t work = {
+        .memo = grid->memo_on ? grid->memos[worker] : NULL,
+    };
+
+    for (size_t row = begin; row < end; ++row) {
+        state.last = row + 1 == end;
+        inplace_row(grid, row, &state, &work);
+    }
+
+    atomic_fetch_add_explicit(&grid->chunks_active, work.active, memory_order_relaxed);
+}
+
+// una generación sobre el propio chunks. los bordes de las franjas se
+// guardan en una pasada aparte para que ningún trabajador los pise antes.
+// el mapa de ocupación sigue siendo doble, pero parte de una copia del
+// actual, porque los chunks que no se calculan no cambian
+void
+inplace_run(grid_t* grid) {
+    memcpy(grid->occ_next, grid->occ, (grid->occ_len + grid_occ_top_len(grid->occ_len)) * sizeof(uint64_t));
+
+    if (grid->pool == NULL) {
+        inplace_save(grid, 0, 1);
+        inplace_band(grid, 0, 1);
+    } else {
+        pool_run(grid->pool, inplace_save, grid);
+        pool_run(grid->pool, inplace_band, grid);
+    }
+}
@@ -0,0 +1,24 @@
+#ifndef INCLUDE_INPLACE_INPLACE_H_
+#define INCLUDE_INPLACE_INPLACE_H_
+
+#include <stddef.h>
+
+#include "../grid.h"
+
+
+// bordes que cada trabajador guarda mientras el grid se actualiza sobre
+// sus propios chunks, sin chunks_next
+typedef struct inplace inplace_t;
+
+extern int
+inplace_make(inplace_t** inplace_ptr, size_t chunk_cols, size_t occ_stride, size_t workers);
+
+extern void
+inplace_destroy(inplace_t** inplace_ptr);
+
+// avanza una generación del grid fila de chunks a fila de chunks
+extern void
+inplace_run(grid_t* grid);
+
+
+#endif  // INCLUDE_INPLACE_INPLACE_H_
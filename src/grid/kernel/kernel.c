@@ -0,0 +1,216 @@
+#include "kernel.h"
+
+#include <stdbool.h>
+#include <stddef.h>
+#include <stdint.h>
+#include <string.h>
+
+#include "kernel_lut.h"
+
+
+// reglas con kernel propio en cada conjunto de instrucciones,
+// X(nombre, birth, survive) con el bit n puesto para n vecinos
+#define KERNEL_RULES(X)             \
+    X(life,     0x008, 0x00C)       \
+    X(highlife, 0x048, 0x00C)       \
+    X(seeds,    0x004, 0x000)       \
+    X(daynight, 0x1C8, 0x1D8)
+
+#define KERNEL_RULE_ID(name, birth, survive) KERNEL_RULE_##name,
+
+typedef enum kernel_rule {
+    KERNEL_RULES(KERNEL_RULE_ID)
+    KERNEL_RULE_GENERIC,
+    KERNEL_RULE_LEN,
+} kernel_rule_t;
+
+#undef KERNEL_RULE_ID
+
+// filas de la tabla de cada kernel, una por cada grid_sum_t salvo auto
+#define KERNEL_SUM_LEN (SUM_LEN - SUM_ADDER)
+
+#define KERNEL_CAT_(a, b) a##b
+#define KERNEL_CAT(a, b) KERNEL_CAT_(a, b)
+
+// recuentos pares 0, 2, 4, 6 e impares 1, 3, 5, 7 de una máscara de
+// la regla, compactados en 4 bits para indexar por (p1, p2)
+static inline unsigned
+kernel_rule_even(uint16_t mask) {
+    return (mask & 1U) | ((mask >> 1U) & 2U) | ((mask >> 2U) & 4U) | ((mask >> 3U) & 8U);
+}
+
+static inline unsigned
+kernel_rule_odd(uint16_t mask) {
+    return ((mask >> 1U) & 1U) | ((mask >> 2U) & 2U) | ((mask >> 3U) & 4U) | ((mask >> 4U) & 8U);
+}
+
+#define KERNEL_NAME kernel_scalar
+#define KERNEL_VEC_NAME kernel_vec_scalar_t
+#define KERNEL_STREAM_VEC_NAME kernel_stream_scalar_t
+#define KERNEL_BYTES 0
+#define KERNEL_TARGET
+#include "kernel_impl.h"
+
+// los kernels vectoriales se compilan siempre en x86, cada uno con su
+// propio atributo target, y se elige cuál usar en tiempo de ejecución.
+// gcc no admite vectores de enteros de 128 bits, con esos chunks solo
+// queda el kernel escalar
+#if (defined(__x86_64__) || defined(__i386__)) && CHUNK_BITS <= 64
+
+#define KERNEL_X86
+
+#define KERNEL_NAME kernel_sse2
+#define KERNEL_VEC_NAME kernel_vec_sse2_t
+#define KERNEL_STREAM_VEC_NAME kernel_stream_sse2_t
+#define KERNEL_BYTES 16
+#define KERNEL_TARGET __attribute__((target("sse2")))
+#include "kernel_impl.h"
+
+#define KERNEL_NAME kernel_avx2
+#define KERNEL_VEC_NAME kernel_vec_avx2_t
+#define KERNEL_STREAM_VEC_NAME kernel_stream_avx2_t
+#define KERNEL_BYTES 32
+#define KERNEL_TARGET __attribute__((target("avx2")))
+#include "kernel_impl.h"
+
+#define KERNEL_NAME kernel_avx512
+#define KERNEL_VEC_NAME kernel_vec_avx512_t
+#define KERNEL_STREAM_VEC_NAME kernel_stream_avx512_t
+#define KERNEL_BYTES 64
+#define KERNEL_TARGET __attribute__((target("avx512f")))
+#include "kernel_impl.h"
+
+#endif
+
+bool
+kernel_supported(grid_kernel_t kind) {
+    switch (kind) {
+    case KERNEL_AUTO:
+    case KERNEL_SCALAR:
+    case KERNEL_LUT:
+        return true;
+#ifdef KERNEL_X86
+    case KERNEL_SSE2:
+        return __builtin_cpu_supports("sse2");
+    case KERNEL_AVX2:
+        return __builtin_cpu_supports("avx2");
+    case KERNEL_AVX512:
+        return __builtin_cpu_supports("avx512f");
+#endif
+    default:
+        return false;
+    }
+}
+
+grid_kernel_t
+kernel_best(void) {
+    if (kernel_supported(KERNEL_AVX512)) {
+        return KERNEL_AVX512;
+    }
+    if (kernel_supported(KERNEL_AVX2)) {
+        return KERNEL_AVX2;
+    }
+    if (kernel_supported(KERNEL_SSE2)) {
+        return KERNEL_SSE2;
+    }
+
+    return KERNEL_SCALAR;
+}
+
+static kernel_rule_t
+kernel_rule(const grid_rule_t* rule) {
+    #define KERNEL_RULE_MATCH(name, b, s)                  \
+        if (rule->birth == (b) && rule->survive == (s)) { \
+            return KERNEL_RULE_##name;                     \
+        }
+
+    KERNEL_RULES(KERNEL_RULE_MATCH)
+
+    #undef KERNEL_RULE_MATCH
+
+    return KERNEL_RULE_GENERIC;
+}
+
+// guardar la suma de cada fila sale más barato que recalcularla hasta que
+// el registro lleva más de 4 filas, desde ahí las cargas desalineadas de
+// esas sumas cuestan lo que las puertas que se ahorran
+#define KERNEL_ROWSUM_MAX_LANES 4
+
+grid_sum_t
+kernel_best_sum(grid_kernel_t kind) {
+    if (kind == KERNEL_AUTO) {
+        kind = kernel_best();
+    }
+
+    size_t bytes = CHUNK_BITS / 8;
+
+    switch (kind) {
+    case KERNEL_SSE2:
+        bytes = 16;
+        break;
+    case KERNEL_AVX2:
+        bytes = 32;
+        break;
+    case KERNEL_AVX512:
+        bytes = 64;
+        break;
+    default:
+        break;
+    }
+
+    return bytes * 8 / CHUNK_BITS > KERNEL_ROWSUM_MAX_LANES ? SUM_ADDER : SUM_ROWSUM;
+}
+
+kernel_stream_fn_t
+kernel_stream_get(grid_kernel_t kind, const grid_rule_t* rule) {
+    if (kind == KERNEL_AUTO) {
+        kind = kernel_best();
+    }
+
+    kernel_rule_t id = kernel_rule(rule);
+
+    switch (kind) {
+#ifdef KERNEL_X86
+    case KERNEL_SSE2:
+        return kernel_sse2_stream[id];
+    case KERNEL_AVX2:
+        return kernel_avx2_stream[id];
+    case KERNEL_AVX512:
+        return kernel_avx512_stream[id];
+#endif
+    default:
+        return kernel_scalar_stream[id];
+    }
+}
+
+kernel_fn_t
+kernel_get(grid_kernel_t kind, grid_sum_t sum, const grid_rule_t* rule) {
+    if (kind == KERNEL_AUTO) {
+        kind = kernel_best();
+    }
+    if (sum == SUM_AUTO) {
+        sum = kernel_best_sum(kind);
+    }
+
+    // la tabla no depende del procesador, se construye aquí para la regla
+    if (kind == KERNEL_LUT) {
+        kernel_lut_build(rule);
+        return kernel_lut;
+    }
+
+    kernel_rule_t id = kernel_rule(rule);
+    size_t row = (size_t)(sum - SUM_ADDER);
+
+    switch (kind) {
+#ifdef KERNEL_X86
+    case KERNEL_SSE2:
+        return kernel_sse2[row][id];
+    case KERNEL_AVX2:
+        return kernel_avx2[row][id];
+    case KERNEL_AVX512:
+        return kernel_avx512[row][id];
+#endif
+    default:
+        return kernel_scalar[row][id];
+    }
+}
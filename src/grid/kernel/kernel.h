@@ -0,0 +1,61 @@
+#ifndef INCLUDE_KERNEL_KERNEL_H_
+#define INCLUDE_KERNEL_KERNEL_H_
+
+#include <stdbool.h>
+#include <stddef.h>
+#include <stdint.h>
+
+#include "../chunk.h"
+#include "../grid.h"
+
+
+// calcula la siguiente generación de un chunk a partir de tres columnas
+// con CHUNK_PADDED filas cada una: la del propio chunk y las de sus
+// vecinos de la izquierda y la derecha. devuelve KERNEL_CHANGED si el
+// chunk ha cambiado y KERNEL_ALIVE si le queda alguna célula viva.
+// los kernels especializados en una regla ignoran el último argumento
+typedef unsigned (*kernel_fn_t)(
+    const chunk_word_t* west,
+    const chunk_word_t* centre,
+    const chunk_word_t* east,
+    chunk_word_t* next,
+    const grid_rule_t* rule);
+
+#define KERNEL_CHANGED 1U
+#define KERNEL_ALIVE 2U
+
+// palabras que los kernels de flujo procesan por iteración como mucho,
+// las filas que reciben tienen siempre un múltiplo de esta cantidad
+#define KERNEL_STREAM_WORDS 8
+
+// calcula la siguiente generación de una fila entera del grid a partir de
+// ella y de las filas de arriba y abajo, todas de words palabras de 64 bits
+// con otra palabra legible a cada lado. los bits a cero en mask no son del
+// grid, salen siempre muertos y no cuentan como cambio. devuelve si la
+// fila ha cambiado
+typedef bool (*kernel_stream_fn_t)(
+    const uint64_t* north,
+    const uint64_t* row,
+    const uint64_t* south,
+    const uint64_t* mask,
+    uint64_t* next,
+    size_t words,
+    const grid_rule_t* rule);
+
+extern bool
+kernel_supported(grid_kernel_t kind);
+
+extern grid_kernel_t
+kernel_best(void);
+
+extern grid_sum_t
+kernel_best_sum(grid_kernel_t kind);
+
+extern kernel_stream_fn_t
+kernel_stream_get(grid_kernel_t kind, const grid_rule_t* rule);
+
+extern kernel_fn_t
+kernel_get(grid_kernel_t kind, grid_sum_t sum, const grid_rule_t* rule);
+
+
+#endif  // INCLUDE_KERNEL_KERNEL_H_
@@ -0,0 +1,144 @@
+// plantilla del circuito que suma los vecinos y aplica la regla sobre
+// palabras de bits, kernel_impl.h la incluye una vez por cada tipo con el
+// que trabaja definiendo antes:
+//   KERNEL_COUNT_NAME prefijo de las funciones generadas
+//   KERNEL_COUNT_VEC  tipo escalar o vectorial de las palabras
+//   KERNEL_TARGET     atributo target de gcc, vacío para el kernel escalar
+//
+// en todas las funciones el bit i de cada palabra es la célula i, y los
+// vecinos de una fila se pasan ya desplazados a la posición de la célula
+//
+// no lleva guarda de inclusión a propósito
+
+#define KERNEL_COUNT_FN(suffix) KERNEL_CAT(KERNEL_COUNT_NAME, suffix)
+
+// la expresión más corta para una tabla de verdad sobre (p1, p2),
+// el bit j de la tabla es el valor para p1 + 2 * p2 == j
+KERNEL_TARGET static inline __attribute__((always_inline)) KERNEL_COUNT_VEC
+KERNEL_COUNT_FN(_pairs)(unsigned table, KERNEL_COUNT_VEC p1, KERNEL_COUNT_VEC p2) {
+    KERNEL_COUNT_VEC zero = p1 ^ p1;
+
+    switch (table) {
+    case 0x0: return zero;
+    case 0x1: return ~(p1 | p2);
+    case 0x2: return p1 & ~p2;
+    case 0x3: return ~p2;
+    case 0x4: return p2 & ~p1;
+    case 0x5: return ~p1;
+    case 0x6: return p1 ^ p2;
+    case 0x7: return ~(p1 & p2);
+    case 0x8: return p1 & p2;
+    case 0x9: return ~(p1 ^ p2);
+    case 0xA: return p1;
+    case 0xB: return p1 | ~p2;
+    case 0xC: return p2;
+    case 0xD: return p2 | ~p1;
+    case 0xE: return p1 | p2;
+    default:  return ~zero;
+    }
+}
+
+// células cuyo número de vecinos está en mask. se separan los recuentos
+// pares de los impares por p0 y cada mitad es una función de (p1, p2).
+// p3 solo distingue 8 de 0, así que solo aparece si la regla los separa
+KERNEL_TARGET static inline __attribute__((always_inline)) KERNEL_COUNT_VEC
+KERNEL_COUNT_FN(_count)(
+    uint16_t mask,
+    KERNEL_COUNT_VEC p0,
+    KERNEL_COUNT_VEC p1,
+    KERNEL_COUNT_VEC p2,
+    KERNEL_COUNT_VEC p3)
+{
+    bool has_0 = (mask & 1U) != 0;
+    bool has_8 = ((mask >> 8U) & 1U) != 0;
+
+    unsigned even = kernel_rule_even(mask);
+    unsigned odd = kernel_rule_odd(mask);
+
+    if (has_0 != has_8) {
+        even &= ~1U;
+    }
+
+    KERNEL_COUNT_VEC res;
+
+    if (even == odd) {
+        res = KERNEL_COUNT_FN(_pairs)(even, p1, p2);
+    } else if (odd == 0) {
+        res = ~p0 & KERNEL_COUNT_FN(_pairs)(even, p1, p2);
+    } else if (even == 0) {
+        res = p0 & KERNEL_COUNT_FN(_pairs)(odd, p1, p2);
+    } else {
+        res = (p0 & KERNEL_COUNT_FN(_pairs)(odd, p1, p2)) | (~p0 & KERNEL_COUNT_FN(_pairs)(even, p1, p2));
+    }
+
+    if (has_0 != has_8) {
+        res |= (has_8 ? p3 : ~p3) & ~(p0 | p1 | p2);
+    }
+
+    return res;
+}
+
+// suma de tres células seguidas de una fila en dos planos de bits
+KERNEL_TARGET static inline __attribute__((always_inline)) void
+KERNEL_COUNT_FN(_hsum)(
+    KERNEL_COUNT_VEC west,
+    KERNEL_COUNT_VEC centre,
+    KERNEL_COUNT_VEC east,
+    KERNEL_COUNT_VEC* s0,
+    KERNEL_COUNT_VEC* s1)
+{
+    KERNEL_COUNT_VEC half = west ^ centre;
+
+    *s0 = half ^ east;
+    *s1 = (west & centre) | (half & east);
+}
+
+// recuento de los 8 vecinos a partir de las sumas de tres células de la
+// fila de arriba (a) y la de abajo (b) y los dos vecinos de la propia
+// fila, juntados con sumadores completos
+KERNEL_TARGET static inline __attribute__((always_inline)) void
+KERNEL_COUNT_FN(_combine)(
+    KERNEL_COUNT_VEC a0,
+    KERNEL_COUNT_VEC a1,
+    KERNEL_COUNT_VEC b0,
+    KERNEL_COUNT_VEC b1,
+    KERNEL_COUNT_VEC west,
+    KERNEL_COUNT_VEC east,
+    KERNEL_COUNT_VEC p[4])
+{
+    // vecinos de la propia fila, de 0 a 2
+    KERNEL_COUNT_VEC c0 = west ^ east;
+    KERNEL_COUNT_VEC c1 = west & east;
+
+    // bit de peso 1: suma completa de los tres bits bajos
+    KERNEL_COUNT_VEC half0 = a0 ^ b0;
+    KERNEL_COUNT_VEC k0 = (a0 & b0) | (half0 & c0);
+
+    p[0] = half0 ^ c0;
+
+    // bits de peso 2: a1 + b1 + c1 + k0, de 0 a 4
+    KERNEL_COUNT_VEC half1 = a1 ^ b1;
+    KERNEL_COUNT_VEC s1 = half1 ^ c1;
+    KERNEL_COUNT_VEC k1 = (a1 & b1) | (half1 & c1);
+    KERNEL_COUNT_VEC k2 = s1 & k0;
+
+    p[1] = s1 ^ k0;
+
+    // bits de peso 4: k1 + k2, un 8 deja solo p3
+    p[2] = k1 ^ k2;
+    p[3] = k1 & k2;
+}
+
+// las vivas siguen si su recuento está en survive
+// y las muertas nacen si está en birth
+KERNEL_TARGET static inline __attribute__((always_inline)) KERNEL_COUNT_VEC
+KERNEL_COUNT_FN(_apply)(KERNEL_COUNT_VEC curr, const KERNEL_COUNT_VEC p[4], uint16_t birth, uint16_t survive) {
+    KERNEL_COUNT_VEC keep = KERNEL_COUNT_FN(_count)(survive, p[0], p[1], p[2], p[3]);
+    KERNEL_COUNT_VEC born = KERNEL_COUNT_FN(_count)(birth, p[0], p[1], p[2], p[3]);
+
+    return (curr & keep) | (~curr & born);
+}
+
+#undef KERNEL_COUNT_FN
+#undef KERNEL_COUNT_NAME
+#undef KERNEL_COUNT_VEC
@@ -0,0 +1,93 @@
+#include "kernel_gen.h"
+
+#include <assert.h>
+#include <stddef.h>
+#include <stdint.h>
+
+#include "kernel.h"
+
+
+// como mucho RULE_MAX_STATES - 2 = 6 edades, que caben en 3 planos
+#define KERNEL_GEN_MAX_PLANES 3
+
+size_t
+kernel_gen_planes(const grid_rule_t* rule) {
+    size_t planes = 0;
+
+    for (unsigned oldest = rule->states - 2U; oldest != 0; oldest >>= 1U) {
+        planes += 1;
+    }
+
+    assert(planes <= KERNEL_GEN_MAX_PLANES);
+
+    return planes;
+}
+
+// la edad de la célula es la de los planos leídos como un número en
+// binario, con el plano 0 como bit bajo, y el estado es la edad más uno
+static inline __attribute__((always_inline)) unsigned
+kernel_gen_decay_planes(const chunk_word_t* curr, chunk_word_t* next, chunk_t* ages, unsigned states, const size_t planes) {
+    // al cumplir states - 1 la célula muere. si es justo 1 << planes el
+    // acarreo sale de los planos y la edad vuelve sola a 0
+    const unsigned dead = states - 1U;
+
+    chunk_word_t diff = 0;
+    chunk_word_t alive = 0;
+
+    for (size_t row = 0; row < CHUNK_SIZE; ++row) {
+        chunk_word_t aging = 0;
+
+        for (size_t i = 0; i < planes; ++i) {
+            aging |= ages[i].rows[row];
+        }
+
+        chunk_word_t fire = next[row] & ~aging;
+
+        // las vivas que no siguen vivas empiezan a envejecer con edad 0,
+        // así que sumar 1 a la edad de todas las que envejecen basta
+        chunk_word_t carry = aging | (curr[row] & ~fire);
+        chunk_word_t changed = carry | (curr[row] ^ fire);
+
+        chunk_word_t old = ~(chunk_word_t)0;
+
+        for (size_t i = 0; i < planes; ++i) {
+            chunk_word_t next_carry = ages[i].rows[row] & carry;
+
+            ages[i].rows[row] ^= carry;
+            carry = next_carry;
+
+            old &= ((dead >> i) & 1U) != 0 ? ages[i].rows[row] : ~ages[i].rows[row];
+        }
+
+        if ((dead >> planes) == 0) {
+            for (size_t i = 0; i < planes; ++i) {
+                ages[i].rows[row] &= ~old;
+            }
+        }
+
+        chunk_word_t left = fire;
+
+        for (size_t i = 0; i < planes; ++i) {
+            left |= ages[i].rows[row];
+        }
+
+        next[row] = fire;
+        diff |= changed;
+        alive |= left;
+    }
+
+    return (diff != 0 ? KERNEL_CHANGED : 0U) | (alive != 0 ? KERNEL_ALIVE : 0U);
+}
+
+unsigned
+kernel_gen_decay(const chunk_word_t* curr, chunk_word_t* next, chunk_t* ages, const grid_rule_t* rule) {
+    // con el número de planos constante gcc desenrolla los bucles de edad
+    switch (kernel_gen_planes(rule)) {
+    case 1:
+        return kernel_gen_decay_planes(curr, next, ages, rule->states, 1);
+    case 2:
+        return kernel_gen_decay_planes(curr, next, ages, rule->states, 2);
+    default:
+        return kernel_gen_decay_planes(curr, next, ages, rule->states, KERNEL_GEN_MAX_PLANES);
+    }
+}
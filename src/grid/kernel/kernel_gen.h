@@ -0,0 +1,27 @@
+#ifndef INCLUDE_KERNEL_KERNEL_GEN_H_
+#define INCLUDE_KERNEL_KERNEL_GEN_H_
+
+#include <stddef.h>
+#include <stdint.h>
+
+#include "../chunk.h"
+#include "../grid.h"
+
+
+// planos de edad que necesita una regla de states estados: la edad de
+// una célula que envejece va de 1 a states - 2, y 0 es que no envejece
+extern size_t
+kernel_gen_planes(const grid_rule_t* rule);
+
+// completa la generación de un chunk con una regla Generations. next
+// llega con lo que da el kernel B/S de siempre sobre las células vivas
+// de curr, y sale sin las que están envejeciendo, que no pueden nacer
+// ni volver a vivir. ages son los kernel_gen_planes planos de edad del
+// chunk, que se avanzan en el sitio porque solo dependen de la propia
+// célula. devuelve las marcas de los kernels contando la edad: cambia
+// si cambia cualquier estado y está vivo si alguna célula no está muerta
+extern unsigned
+kernel_gen_decay(const chunk_word_t* curr, chunk_word_t* next, chunk_t* ages, const grid_rule_t* rule);
+
+
+#endif  // INCLUDE_KERNEL_KERNEL_GEN_H_
@@ -0,0 +1,457 @@
+// plantilla del kernel, se incluye una vez por cada conjunto de instrucciones
+// definiendo antes:
+//   KERNEL_NAME     nombre de la función generada
+//   KERNEL_VEC_NAME nombre del tipo vectorial que se declara
+//   KERNEL_STREAM_VEC_NAME el mismo registro en palabras de 64 bits
+//   KERNEL_BYTES    ancho del registro vectorial, 0 para el kernel escalar
+//   KERNEL_TARGET   atributo target de gcc, vacío para el kernel escalar
+//
+// el mismo código sirve para cualquier chunk_word_t, el tamaño del
+// chunk solo cambia cuántas filas caben en cada registro
+//
+// KERNEL_NAME acaba siendo una tabla con un kernel por cada regla de
+// KERNEL_RULES, en los que la regla es constante y gcc reduce el circuito
+// a las puertas que necesita, y al final uno genérico que la lee al vuelo.
+// la tabla se repite para cada forma de sumar los vecinos, _rule y _rowsum,
+// y KERNEL_NAME_stream es la misma tabla para filas enteras del grid
+//
+// no lleva guarda de inclusión a propósito
+
+#if KERNEL_BYTES == 0
+#define KERNEL_LANES 1
+typedef chunk_word_t KERNEL_VEC_NAME;
+#else
+#define KERNEL_LANES (KERNEL_BYTES * 8 / CHUNK_BITS)
+typedef chunk_word_t KERNEL_VEC_NAME __attribute__((vector_size(KERNEL_BYTES)));
+#endif
+
+#if CHUNK_SIZE % KERNEL_LANES != 0
+#error "KERNEL_LANES must divide CHUNK_SIZE"
+#endif
+
+#define KERNEL_FN(suffix) KERNEL_CAT(KERNEL_NAME, suffix)
+
+#define KERNEL_COUNT_NAME KERNEL_NAME
+#define KERNEL_COUNT_VEC KERNEL_VEC_NAME
+#include "kernel_count.h"
+
+// junta las diferencias y las células vivas de todas las filas del chunk
+// en las marcas KERNEL_CHANGED y KERNEL_ALIVE que devuelve el kernel
+KERNEL_TARGET static inline __attribute__((always_inline)) unsigned
+KERNEL_FN(_flags)(KERNEL_VEC_NAME diff, KERNEL_VEC_NAME alive) {
+#if KERNEL_BYTES == 0
+    chunk_word_t any_diff = diff;
+    chunk_word_t any_alive = alive;
+#else
+    chunk_word_t any_diff = 0;
+    chunk_word_t any_alive = 0;
+
+    for (size_t lane = 0; lane < KERNEL_LANES; ++lane) {
+        any_diff |= diff[lane];
+        any_alive |= alive[lane];
+    }
+#endif
+
+    return (any_diff != 0 ? KERNEL_CHANGED : 0U) | (any_alive != 0 ? KERNEL_ALIVE : 0U);
+}
+
+KERNEL_TARGET static inline __attribute__((always_inline)) unsigned
+KERNEL_FN(_rule)(
+    const chunk_word_t* west,
+    const chunk_word_t* centre,
+    const chunk_word_t* east,
+    chunk_word_t* next,
+    uint16_t birth,
+    uint16_t survive)
+{
+    typedef KERNEL_VEC_NAME vec_t;
+
+    // acumula las diferencias con la generación actual y las células que
+    // quedan vivas, así el propio kernel dice si el chunk ha cambiado y si
+    // está vacío sin tener que volver a leerlo
+    vec_t diff, alive;
+    memset(&diff, 0, sizeof(vec_t));
+    memset(&alive, 0, sizeof(vec_t));
+
+    // ahora cada fila de CHUNK_SIZE células, gracias al uso de máscaras de bits,
+    // se va a poder realizar en paralelo, y además se procesan KERNEL_LANES
+    // filas consecutivas a la vez en un mismo registro vectorial
+    for (size_t row = 0; row < CHUNK_SIZE; row += KERNEL_LANES) {
+        vec_t top, curr, bot;
+        vec_t top_left, left, bot_left;
+        vec_t top_right, right, bot_right;
+
+        // las columnas llevan una fila extra arriba, así que la fila
+        // actual está en row + 1 y sus vecinas en row y row + 2
+        memcpy(&top,  centre + row,     sizeof(vec_t));
+        memcpy(&curr, centre + row + 1, sizeof(vec_t));
+        memcpy(&bot,  centre + row + 2, sizeof(vec_t));
+
+        memcpy(&top_left, west + row,     sizeof(vec_t));
+        memcpy(&left,     west + row + 1, sizeof(vec_t));
+        memcpy(&bot_left, west + row + 2, sizeof(vec_t));
+
+        memcpy(&top_right, east + row,     sizeof(vec_t));
+        memcpy(&right,     east + row + 1, sizeof(vec_t));
+        memcpy(&bot_right, east + row + 2, sizeof(vec_t));
+
+        // se quiere obtener 8 palabras de CHUNK_SIZE bits, una con todos los vecinos a la izqda de la palabras
+        // actual, de forma que el vecino izquierdo del bit i esté también en la posición i de la palabra,
+        // otra con los vecinos de la dcha, y así para los 8 vecinos.
+        vec_t ngb_n = top;
+        vec_t ngb_s = bot;
+
+        vec_t ngb_w  =  curr << 1U | (left     >> CHUNK_LAST);
+        vec_t ngb_nw = ngb_n << 1U | (top_left >> CHUNK_LAST);
+        vec_t ngb_sw = ngb_s << 1U | (bot_left >> CHUNK_LAST);
+
+        vec_t ngb_e  =  curr >> 1U | (right     << CHUNK_LAST);
+        vec_t ngb_ne = ngb_n >> 1U | (top_right << CHUNK_LAST);
+        vec_t ngb_se = ngb_s >> 1U | (bot_right << CHUNK_LAST);
+
+        // ahora se suman los bits de los 8 vecinos en paralelo
+        // en 4 paralabras de CHUNK_SIZE bits. p0 contiene el primer bit de la
+        // suma, p1 el segundo etc. se necesitan 4 palabras ya que los vecinos
+        // pueden sumar 8 como máximo, con representacion b1000
+        vec_t p0 = ngb_n ^ ngb_n;
+        vec_t p1 = p0;
+        vec_t p2 = p0;
+        vec_t p3 = p0;
+
+        #define SUM_NEIGHBOR_ROW(ngb) do {      \
+            vec_t carry1 = p0 & (ngb);          \
+            p0 ^= (ngb);                        \
+                                                \
+            vec_t carry2 = p1 & (carry1);       \
+            p1 ^= (carry1);                     \
+                                                \
+            vec_t carry3 = p2 & (carry2);       \
+            p2 ^= (carry2);                     \
+                                                \
+            p3 ^= (carry3);                     \
+        } while(0)                              \
+
+        SUM_NEIGHBOR_ROW(ngb_n);
+        SUM_NEIGHBOR_ROW(ngb_s);
+        SUM_NEIGHBOR_ROW(ngb_e);
+        SUM_NEIGHBOR_ROW(ngb_w);
+        SUM_NEIGHBOR_ROW(ngb_nw);
+        SUM_NEIGHBOR_ROW(ngb_ne);
+        SUM_NEIGHBOR_ROW(ngb_sw);
+        SUM_NEIGHBOR_ROW(ngb_se);
+
+        #undef SUM_NEIGHBOR_ROW
+
+        vec_t p[4] = {p0, p1, p2, p3};
+        vec_t res = KERNEL_FN(_apply)(curr, p, birth, survive);
+
+        diff |= res ^ curr;
+        alive |= res;
+
+        memcpy(next + row, &res, sizeof(vec_t));
+    }
+
+    return KERNEL_FN(_flags)(diff, alive);
+}
+
+// sumas de tres células de las filas [row, row + KERNEL_LANES) de la columna
+KERNEL_TARGET static inline __attribute__((always_inline)) void
+KERNEL_FN(_hsum_rows)(
+    const chunk_word_t* west,
+    const chunk_word_t* centre,
+    const chunk_word_t* east,
+    size_t row,
+    chunk_word_t* s0,
+    chunk_word_t* s1)
+{
+    typedef KERNEL_VEC_NAME vec_t;
+
+    vec_t w, c, e;
+
+    memcpy(&w, west + row,   sizeof(vec_t));
+    memcpy(&c, centre + row, sizeof(vec_t));
+    memcpy(&e, east + row,   sizeof(vec_t));
+
+    vec_t sum, carry;
+
+    KERNEL_FN(_hsum)(c << 1U | (w >> CHUNK_LAST), c, c >> 1U | (e << CHUNK_LAST), &sum, &carry);
+
+    memcpy(s0 + row, &sum,   sizeof(vec_t));
+    memcpy(s1 + row, &carry, sizeof(vec_t));
+}
+
+// mismo resultado que _rule, pero la suma de tres células de cada fila se
+// calcula una sola vez y la usan las filas de arriba y de abajo. la fila
+// del centro suma solo sus dos vecinos, y las tres se juntan con sumadores
+// completos en lugar de ir acumulando los 8 vecinos uno a uno
+KERNEL_TARGET static inline __attribute__((always_inline)) unsigned
+KERNEL_FN(_rowsum)(
+    const chunk_word_t* west,
+    const chunk_word_t* centre,
+    const chunk_word_t* east,
+    chunk_word_t* next,
+    uint16_t birth,
+    uint16_t survive)
+{
+    typedef KERNEL_VEC_NAME vec_t;
+
+    chunk_word_t sums0[CHUNK_PADDED];
+    chunk_word_t sums1[CHUNK_PADDED];
+
+    // las dos últimas filas no caben en un paso entero, se rehace el
+    // último registro alineado al final de la columna
+    for (size_t row = 0; row + KERNEL_LANES <= CHUNK_PADDED; row += KERNEL_LANES) {
+        KERNEL_FN(_hsum_rows)(west, centre, east, row, sums0, sums1);
+    }
+    KERNEL_FN(_hsum_rows)(west, centre, east, CHUNK_PADDED - KERNEL_LANES, sums0, sums1);
+
+    vec_t diff, alive;
+    memset(&diff, 0, sizeof(vec_t));
+    memset(&alive, 0, sizeof(vec_t));
+
+    for (size_t row = 0; row < CHUNK_SIZE; row += KERNEL_LANES) {
+        vec_t a0, a1, b0, b1;
+        vec_t curr, left, right;
+
+        memcpy(&a0, sums0 + row,     sizeof(vec_t));
+        memcpy(&a1, sums1 + row,     sizeof(vec_t));
+        memcpy(&b0, sums0 + row + 2, sizeof(vec_t));
+        memcpy(&b1, sums1 + row + 2, sizeof(vec_t));
+
+        memcpy(&curr,  centre + row + 1, sizeof(vec_t));
+        memcpy(&left,  west + row + 1,   sizeof(vec_t));
+        memcpy(&right, east + row + 1,   sizeof(vec_t));
+
+        vec_t p[4];
+
+        KERNEL_FN(_combine)(a0, a1, b0, b1,
+                            curr << 1U | (left  >> CHUNK_LAST),
+                            curr >> 1U | (right << CHUNK_LAST), p);
+
+        vec_t res = KERNEL_FN(_apply)(curr, p, birth, survive);
+
+        diff |= res ^ curr;
+        alive |= res;
+
+        memcpy(next + row, &res, sizeof(vec_t));
+    }
+
+    return KERNEL_FN(_flags)(diff, alive);
+}
+
+#define KERNEL_RULE_FN(name, birth, survive)                                \
+    KERNEL_TARGET static unsigned                                           \
+    KERNEL_FN(_##name)(                                                     \
+        const chunk_word_t* west,                                           \
+        const chunk_word_t* centre,                                         \
+        const chunk_word_t* east,                                           \
+        chunk_word_t* next,                                                 \
+        const grid_rule_t* rule)                                            \
+    {                                                                       \
+        (void)rule;                                                         \
+        return KERNEL_FN(_rule)(west, centre, east, next, birth, survive);   \
+    }                                                                       \
+                                                                            \
+    KERNEL_TARGET static unsigned                                           \
+    KERNEL_FN(_##name##_rowsum)(                                            \
+        const chunk_word_t* west,                                           \
+        const chunk_word_t* centre,                                         \
+        const chunk_word_t* east,                                           \
+        chunk_word_t* next,                                                 \
+        const grid_rule_t* rule)                                            \
+    {                                                                       \
+        (void)rule;                                                         \
+        return KERNEL_FN(_rowsum)(west, centre, east, next, birth, survive); \
+    }
+
+KERNEL_RULES(KERNEL_RULE_FN)
+
+#undef KERNEL_RULE_FN
+
+KERNEL_TARGET static unsigned
+KERNEL_FN(_generic)(
+    const chunk_word_t* west,
+    const chunk_word_t* centre,
+    const chunk_word_t* east,
+    chunk_word_t* next,
+    const grid_rule_t* rule)
+{
+    return KERNEL_FN(_rule)(west, centre, east, next, rule->birth, rule->survive);
+}
+
+KERNEL_TARGET static unsigned
+KERNEL_FN(_generic_rowsum)(
+    const chunk_word_t* west,
+    const chunk_word_t* centre,
+    const chunk_word_t* east,
+    chunk_word_t* next,
+    const grid_rule_t* rule)
+{
+    return KERNEL_FN(_rowsum)(west, centre, east, next, rule->birth, rule->survive);
+}
+
+#define KERNEL_RULE_ENTRY(name, birth, survive) KERNEL_FN(_##name),
+#define KERNEL_RULE_ENTRY_ROWSUM(name, birth, survive) KERNEL_FN(_##name##_rowsum),
+
+// una fila por cada forma de sumar los vecinos, en el orden de grid_sum_t
+static const kernel_fn_t KERNEL_NAME[KERNEL_SUM_LEN][KERNEL_RULE_LEN] = {
+    {
+        KERNEL_RULES(KERNEL_RULE_ENTRY)
+        KERNEL_FN(_generic),
+    },
+    {
+        KERNEL_RULES(KERNEL_RULE_ENTRY_ROWSUM)
+        KERNEL_FN(_generic_rowsum),
+    },
+};
+
+#undef KERNEL_RULE_ENTRY_ROWSUM
+
+// kernels de flujo para el grid de filas enteras, que trabajan sobre
+// palabras de 64 bits sea cual sea el ancho de los chunks
+#define KERNEL_STREAM_NAME KERNEL_CAT(KERNEL_NAME, _stream)
+#define KERNEL_STREAM_FN(suffix) KERNEL_CAT(KERNEL_STREAM_NAME, suffix)
+
+#if KERNEL_BYTES == 0
+#define KERNEL_STREAM_LANES 1
+typedef uint64_t KERNEL_STREAM_VEC_NAME;
+#else
+#define KERNEL_STREAM_LANES (KERNEL_BYTES / 8)
+typedef uint64_t KERNEL_STREAM_VEC_NAME __attribute__((vector_size(KERNEL_BYTES)));
+#endif
+
+#if KERNEL_STREAM_WORDS % KERNEL_STREAM_LANES != 0
+#error "KERNEL_STREAM_LANES must divide KERNEL_STREAM_WORDS"
+#endif
+
+#define KERNEL_COUNT_NAME KERNEL_STREAM_NAME
+#define KERNEL_COUNT_VEC KERNEL_STREAM_VEC_NAME
+#include "kernel_count.h"
+
+// una palabra de la fila y sus vecinas del oeste y el este, que toman de
+// la palabra de al lado el bit que les falta con un desplazamiento doble
+KERNEL_TARGET static inline __attribute__((always_inline)) void
+KERNEL_STREAM_FN(_shifts)(
+    const uint64_t* words,
+    KERNEL_STREAM_VEC_NAME* west,
+    KERNEL_STREAM_VEC_NAME* centre,
+    KERNEL_STREAM_VEC_NAME* east)
+{
+    KERNEL_STREAM_VEC_NAME prev, next;
+
+    memcpy(&prev,  words - 1, sizeof(KERNEL_STREAM_VEC_NAME));
+    memcpy(centre, words,     sizeof(KERNEL_STREAM_VEC_NAME));
+    memcpy(&next,  words + 1, sizeof(KERNEL_STREAM_VEC_NAME));
+
+    *west = *centre << 1U | (prev >> 63U);
+    *east = *centre >> 1U | (next << 63U);
+}
+
+// la fila se recorre de corrido sin distinguir dónde acaba cada palabra,
+// las sumas de tres células de las filas de arriba y abajo se juntan con
+// los dos vecinos de la propia fila como en _rowsum
+KERNEL_TARGET static inline __attribute__((always_inline)) bool
+KERNEL_STREAM_FN(_rule)(
+    const uint64_t* north,
+    const uint64_t* row,
+    const uint64_t* south,
+    const uint64_t* mask,
+    uint64_t* next,
+    size_t words,
+    uint16_t birth,
+    uint16_t survive)
+{
+    typedef KERNEL_STREAM_VEC_NAME vec_t;
+
+    vec_t diff;
+    memset(&diff, 0, sizeof(vec_t));
+
+    for (size_t i = 0; i < words; i += KERNEL_STREAM_LANES) {
+        vec_t west, centre, east;
+        vec_t a0, a1, b0, b1;
+
+        KERNEL_STREAM_FN(_shifts)(north + i, &west, &centre, &east);
+        KERNEL_STREAM_FN(_hsum)(west, centre, east, &a0, &a1);
+
+        KERNEL_STREAM_FN(_shifts)(south + i, &west, &centre, &east);
+        KERNEL_STREAM_FN(_hsum)(west, centre, east, &b0, &b1);
+
+        KERNEL_STREAM_FN(_shifts)(row + i, &west, &centre, &east);
+
+        vec_t p[4];
+        KERNEL_STREAM_FN(_combine)(a0, a1, b0, b1, west, east, p);
+
+        vec_t keep;
+        memcpy(&keep, mask + i, sizeof(vec_t));
+
+        vec_t res = KERNEL_STREAM_FN(_apply)(centre, p, birth, survive) & keep;
+
+        diff |= (res ^ centre) & keep;
+
+        memcpy(next + i, &res, sizeof(vec_t));
+    }
+
+#if KERNEL_BYTES == 0
+    return diff != 0;
+#else
+    uint64_t any = 0;
+
+    for (size_t lane = 0; lane < KERNEL_STREAM_LANES; ++lane) {
+        any |= diff[lane];
+    }
+
+    return any != 0;
+#endif
+}
+
+#define KERNEL_STREAM_RULE_FN(name, birth, survive)                                    \
+    KERNEL_TARGET static bool                                                          \
+    KERNEL_STREAM_FN(_##name)(                                                         \
+        const uint64_t* north,                                                         \
+        const uint64_t* row,                                                           \
+        const uint64_t* south,                                                         \
+        const uint64_t* mask,                                                          \
+        uint64_t* next,                                                                \
+        size_t words,                                                                  \
+        const grid_rule_t* rule)                                                       \
+    {                                                                                  \
+        (void)rule;                                                                    \
+        return KERNEL_STREAM_FN(_rule)(north, row, south, mask, next, words, birth, survive); \
+    }
+
+KERNEL_RULES(KERNEL_STREAM_RULE_FN)
+
+#undef KERNEL_STREAM_RULE_FN
+
+KERNEL_TARGET static bool
+KERNEL_STREAM_FN(_generic)(
+    const uint64_t* north,
+    const uint64_t* row,
+    const uint64_t* south,
+    const uint64_t* mask,
+    uint64_t* next,
+    size_t words,
+    const grid_rule_t* rule)
+{
+    return KERNEL_STREAM_FN(_rule)(north, row, south, mask, next, words, rule->birth, rule->survive);
+}
+
+#define KERNEL_STREAM_ENTRY(name, birth, survive) KERNEL_STREAM_FN(_##name),
+
+static const kernel_stream_fn_t KERNEL_STREAM_NAME[KERNEL_RULE_LEN] = {
+    KERNEL_RULES(KERNEL_STREAM_ENTRY)
+    KERNEL_STREAM_FN(_generic),
+};
+
+#undef KERNEL_STREAM_ENTRY
+#undef KERNEL_STREAM_FN
+#undef KERNEL_STREAM_NAME
+#undef KERNEL_STREAM_VEC_NAME
+#undef KERNEL_STREAM_LANES
+#undef KERNEL_RULE_ENTRY
+#undef KERNEL_FN
+#undef KERNEL_NAME
+#undef KERNEL_VEC_NAME
+#undef KERNEL_BYTES
+#undef KERNEL_LANES
+#undef KERNEL_TARGET
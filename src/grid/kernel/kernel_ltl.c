@@ -0,0 +1,212 @@
+#include "kernel_ltl.h"
+
+#include <assert.h>
+#include <stddef.h>
+#include <stdint.h>
+
+#include "kernel.h"
+
+
+// la suma de una fila del cuadrado llega a 2 * 7 + 1 = 15 y cabe en 4
+// bits, la del cuadrado entero llega a 225 y cabe en 8
+#define KERNEL_LTL_ROW_BITS 4
+#define KERNEL_LTL_BITS 8
+
+#define KERNEL_LTL_ROWS (CHUNK_SIZE + (2 * RULE_MAX_RANGE))
+
+// suma dos palabras de bits a un contador de KERNEL_LTL_ROW_BITS planos,
+// bit a bit y en paralelo para todas las columnas: un sumador completo
+// para el plano bajo y el acarreo que sube por el resto
+static inline __attribute__((always_inline)) void
+kernel_ltl_add_pair(chunk_word_t sum[KERNEL_LTL_ROW_BITS], chunk_word_t a, chunk_word_t b) {
+    chunk_word_t half = a ^ b;
+    chunk_word_t carry = (a & b) | (sum[0] & half);
+
+    sum[0] ^= half;
+
+    for (size_t i = 1; i < KERNEL_LTL_ROW_BITS; ++i) {
+        chunk_word_t next = sum[i] & carry;
+
+        sum[i] ^= carry;
+        carry = next;
+    }
+}
+
+// suma horizontal de la fila: cada columna cuenta las células vivas que
+// tiene a range columnas o menos, ella incluida. como en los kernels de
+// rango 1 el bit i es la columna i, y los vecinos de la izquierda salen
+// de los bits altos de west y los de la derecha de los bajos de east
+static inline __attribute__((always_inline)) void
+kernel_ltl_row(
+    chunk_word_t west,
+    chunk_word_t centre,
+    chunk_word_t east,
+    size_t range,
+    chunk_word_t sum[KERNEL_LTL_ROW_BITS])
+{
+    sum[0] = centre;
+
+    for (size_t i = 1; i < KERNEL_LTL_ROW_BITS; ++i) {
+        sum[i] = 0;
+    }
+
+    for (size_t shift = 1; shift <= range; ++shift) {
+        kernel_ltl_add_pair(sum,
+                            (centre << shift) | (west >> (CHUNK_SIZE - shift)),
+                            (centre >> shift) | (east << (CHUNK_SIZE - shift)));
+    }
+}
+
+// suma a la ventana vertical la suma de la fila que entra por abajo
+static inline __attribute__((always_inline)) void
+kernel_ltl_add(chunk_word_t count[KERNEL_LTL_BITS], const chunk_word_t sum[KERNEL_LTL_ROW_BITS], size_t bits) {
+    chunk_word_t carry = 0;
+
+    for (size_t i = 0; i < KERNEL_LTL_ROW_BITS; ++i) {
+        chunk_word_t half = count[i] ^ sum[i];
+        chunk_word_t both = count[i] & sum[i];
+
+        count[i] = half ^ carry;
+        carry = both | (carry & half);
+    }
+
+    for (size_t i = KERNEL_LTL_ROW_BITS; i < bits; ++i) {
+        chunk_word_t next = count[i] & carry;
+
+        count[i] ^= carry;
+        carry = next;
+    }
+}
+
+// y le resta la de la fila que sale por arriba, que siempre contiene,
+// así que nunca queda negativa
+static inline __attribute__((always_inline)) void
+kernel_ltl_sub(chunk_word_t count[KERNEL_LTL_BITS], const chunk_word_t sum[KERNEL_LTL_ROW_BITS], size_t bits) {
+    chunk_word_t borrow = 0;
+
+    for (size_t i = 0; i < KERNEL_LTL_ROW_BITS; ++i) {
+        chunk_word_t half = count[i] ^ sum[i];
+        chunk_word_t under = ~count[i] & sum[i];
+
+        count[i] = half ^ borrow;
+        borrow = under | (borrow & ~half);
+    }
+
+    for (size_t i = KERNEL_LTL_ROW_BITS; i < bits; ++i) {
+        chunk_word_t next = ~count[i] & borrow;
+
+        count[i] ^= borrow;
+        borrow = next;
+    }
+}
+
+// columnas cuya cuenta es al menos value, comparando los planos desde el
+// más alto mientras la cuenta y value siguen siendo iguales
+static inline __attribute__((always_inline)) chunk_word_t
+kernel_ltl_at_least(const chunk_word_t count[KERNEL_LTL_BITS], unsigned value, size_t bits) {
+    if (value >= (1U << bits)) {
+        return 0;
+    }
+
+    chunk_word_t greater = 0;
+    chunk_word_t equal = ~(chunk_word_t)0;
+
+    for (size_t i = bits; i-- > 0;) {
+        if (((value >> i) & 1U) != 0) {
+            equal &= count[i];
+        } else {
+            greater |= equal & count[i];
+            equal &= ~count[i];
+        }
+    }
+
+    return greater | equal;
+}
+
+static inline __attribute__((always_inline)) chunk_word_t
+kernel_ltl_between(const chunk_word_t count[KERNEL_LTL_BITS], unsigned min, unsigned max, size_t bits) {
+    return kernel_ltl_at_least(count, min, bits) & ~kernel_ltl_at_least(count, max + 1, bits);
+}
+
+// las sumas son separables: primero la horizontal de cada una de las
+// CHUNK_SIZE + 2 * range filas que ve el chunk, y luego una ventana de
+// 2 * range + 1 de ellas que baja fila a fila sumando la que entra y
+// restando la que sale, así el coste por fila no crece con el área del
+// cuadrado sino con su lado
+static inline __attribute__((always_inline)) unsigned
+kernel_ltl_range(const chunk_t* const ngb[9], chunk_word_t* next, const grid_rule_t* rule, const size_t range) {
+    chunk_word_t sums[KERNEL_LTL_ROWS][KERNEL_LTL_ROW_BITS];
+
+    // la fila y de sums es la y - range del chunk, que por arriba y por
+    // abajo cae en las últimas o las primeras de la fila de vecinos
+    for (size_t y = 0; y < CHUNK_SIZE + (2 * range); ++y) {
+        size_t band = 1;
+        size_t row = y - range;
+
+        if (y < range) {
+            band = 0;
+            row = CHUNK_SIZE - range + y;
+        } else if (y >= CHUNK_SIZE + range) {
+            band = 2;
+            row = y - range - CHUNK_SIZE;
+        }
+
+        kernel_ltl_row(ngb[3 * band]->rows[row], ngb[(3 * band) + 1]->rows[row], ngb[(3 * band) + 2]->rows[row], range, sums[y]);
+    }
+
+    // planos que hacen falta para el cuadrado de este rango
+    const size_t side = (2 * range) + 1;
+    const size_t bits = side * side < 32 ? 5 : (side * side < 128 ? 7 : KERNEL_LTL_BITS);
+
+    chunk_word_t count[KERNEL_LTL_BITS] = {0};
+
+    for (size_t y = 0; y < 2 * range; ++y) {
+        kernel_ltl_add(count, sums[y], bits);
+    }
+
+    // la cuenta incluye la propia célula, que sin middle no cuenta para
+    // sobrevivir, y una célula muerta nunca se cuenta a sí misma
+    unsigned self = rule->middle ? 0 : 1;
+
+    chunk_word_t diff = 0;
+    chunk_word_t alive = 0;
+
+    for (size_t row = 0; row < CHUNK_SIZE; ++row) {
+        kernel_ltl_add(count, sums[row + (2 * range)], bits);
+
+        if (row > 0) {
+            kernel_ltl_sub(count, sums[row - 1], bits);
+        }
+
+        chunk_word_t curr = ngb[4]->rows[row];
+        chunk_word_t survive = kernel_ltl_between(count, rule->survive_min + self, rule->survive_max + self, bits);
+        chunk_word_t birth = kernel_ltl_between(count, rule->birth_min, rule->birth_max, bits);
+        chunk_word_t cell = (curr & survive) | (~curr & birth);
+
+        diff |= cell ^ curr;
+        alive |= cell;
+        next[row] = cell;
+    }
+
+    return (diff != 0 ? KERNEL_CHANGED : 0U) | (alive != 0 ? KERNEL_ALIVE : 0U);
+}
+
+unsigned
+kernel_ltl(const chunk_t* const ngb[9], chunk_word_t* next, const grid_rule_t* rule) {
+    // con el rango constante gcc desenrolla las sumas de cada fila
+    switch (rule->range) {
+    case 2:
+        return kernel_ltl_range(ngb, next, rule, 2);
+    case 3:
+        return kernel_ltl_range(ngb, next, rule, 3);
+    case 4:
+        return kernel_ltl_range(ngb, next, rule, 4);
+    case 5:
+        return kernel_ltl_range(ngb, next, rule, 5);
+    case 6:
+        return kernel_ltl_range(ngb, next, rule, 6);
+    default:
+        assert(rule->range == RULE_MAX_RANGE);
+        return kernel_ltl_range(ngb, next, rule, RULE_MAX_RANGE);
+    }
+}
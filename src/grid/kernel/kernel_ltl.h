@@ -0,0 +1,18 @@
+#ifndef INCLUDE_KERNEL_KERNEL_LTL_H_
+#define INCLUDE_KERNEL_KERNEL_LTL_H_
+
+#include <stdint.h>
+
+#include "../chunk.h"
+#include "../grid.h"
+
+
+// calcula la siguiente generación de un chunk con una regla de rango
+// entre 2 y RULE_MAX_RANGE a partir de los 3x3 chunks de su vecindario,
+// en el orden de filas de arriba abajo. devuelve las mismas marcas que
+// los kernels de rango 1
+extern unsigned
+kernel_ltl(const chunk_t* const ngb[9], chunk_word_t* next, const grid_rule_t* rule);
+
+
+#endif  // INCLUDE_KERNEL_KERNEL_LTL_H_
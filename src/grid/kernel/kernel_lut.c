@@ -0,0 +1,109 @@
+#include "kernel_lut.h"
+
+#include <stdbool.h>
+#include <stddef.h>
+#include <stdint.h>
+
+#include "kernel.h"
+
+
+// 64 KiB, cabe entera en L2 y la mayoría de accesos caen en L1
+static uint8_t kernel_lut_table[KERNEL_LUT_LEN];  /* NOLINT */
+
+static inline unsigned
+kernel_lut_cell(uint16_t block, unsigned row, unsigned col, const grid_rule_t* rule) {
+    unsigned alive = (block >> ((4 * row) + col)) & 1U;
+    unsigned count = 0;
+
+    for (unsigned i = row - 1; i <= row + 1; ++i) {
+        for (unsigned j = col - 1; j <= col + 1; ++j) {
+            count += (block >> ((4 * i) + j)) & 1U;
+        }
+    }
+
+    count -= alive;
+
+    uint16_t mask = alive ? rule->survive : rule->birth;
+
+    return (mask >> count) & 1U;
+}
+
+void
+kernel_lut_build(const grid_rule_t* rule) {
+    for (size_t block = 0; block < KERNEL_LUT_LEN; ++block) {
+        uint16_t cells = (uint16_t)block;
+
+        kernel_lut_table[block] = (uint8_t)(
+            kernel_lut_cell(cells, 1, 1, rule)
+            | (kernel_lut_cell(cells, 1, 2, rule) << 1U)
+            | (kernel_lut_cell(cells, 2, 1, rule) << 2U)
+            | (kernel_lut_cell(cells, 2, 2, rule) << 3U));
+    }
+}
+
+// los 4 nibbles de las filas [row, row + 3] puestos uno encima de otro
+// para el par de columnas interior que empieza en col
+static inline unsigned
+kernel_lut_block(const chunk_word_t* words, size_t shift) {
+    return ((unsigned)(words[0] >> shift) & 0xFU)
+        | (((unsigned)(words[1] >> shift) & 0xFU) << 4U)
+        | (((unsigned)(words[2] >> shift) & 0xFU) << 8U)
+        | (((unsigned)(words[3] >> shift) & 0xFU) << 12U);
+}
+
+unsigned
+kernel_lut(
+    const chunk_word_t* west,
+    const chunk_word_t* centre,
+    const chunk_word_t* east,
+    chunk_word_t* next,
+    const grid_rule_t* rule)
+{
+    (void)rule;
+
+    chunk_word_t diff = 0;
+    chunk_word_t alive = 0;
+
+    // cada consulta avanza un bloque de 2x2, así que se recorren las filas
+    // de dos en dos leyendo de las columnas la de arriba y la de abajo
+    for (size_t row = 0; row < CHUNK_SIZE; row += 2) {
+        const chunk_word_t* words = centre + row;
+
+        // los pares de los bordes toman una columna del chunk vecino
+        unsigned first = 0;
+        unsigned last = 0;
+
+        for (size_t i = 0; i < 4; ++i) {
+            first |= ((unsigned)(west[row + i] >> CHUNK_LAST) & 1U) << (4 * i);
+            first |= ((unsigned)(words[i] << 1U) & 0xEU) << (4 * i);
+
+            last |= ((unsigned)(words[i] >> (CHUNK_SIZE - 3)) & 0x7U) << (4 * i);
+            last |= ((unsigned)east[row + i] & 1U) << ((4 * i) + 3);
+        }
+
+        unsigned res = kernel_lut_table[first];
+
+        chunk_word_t upper = res & 3U;
+        chunk_word_t lower = res >> 2U;
+
+        for (size_t col = 2; col < CHUNK_SIZE - 2; col += 2) {
+            res = kernel_lut_table[kernel_lut_block(words, col - 1)];
+
+            upper |= (chunk_word_t)(res & 3U) << col;
+            lower |= (chunk_word_t)(res >> 2U) << col;
+        }
+
+        res = kernel_lut_table[last];
+
+        upper |= (chunk_word_t)(res & 3U) << (CHUNK_SIZE - 2);
+        lower |= (chunk_word_t)(res >> 2U) << (CHUNK_SIZE - 2);
+
+        diff |= (upper ^ centre[row + 1]) | (lower ^ centre[row + 2]);
+        alive |= upper | lower;
+
+        next[row] = upper;
+        next[row + 1] = lower;
+    }
+
+    return (diff != 0 ? KERNEL_CHANGED : 0U) | (alive != 0 ? KERNEL_ALIVE : 0U);
+}
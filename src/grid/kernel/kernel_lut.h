@@ -0,0 +1,30 @@
+#ifndef INCLUDE_KERNEL_KERNEL_LUT_H_
+#define INCLUDE_KERNEL_KERNEL_LUT_H_
+
+#include <stdbool.h>
+#include <stdint.h>
+
+#include "../chunk.h"
+#include "../grid.h"
+
+
+// la tabla lleva un bloque de 4x4 células, una fila por cada 4 bits con
+// la columna de más a la izquierda en el bit bajo, a los 2x2 del centro
+// en la siguiente generación, fila a fila también desde el bit bajo
+#define KERNEL_LUT_LEN ((size_t)1 << 16)
+
+// rellena la tabla del proceso para la regla, hay que llamarla
+// antes de usar kernel_lut y no es segura entre hilos
+extern void
+kernel_lut_build(const grid_rule_t* rule);
+
+extern unsigned
+kernel_lut(
+    const chunk_word_t* west,
+    const chunk_word_t* centre,
+    const chunk_word_t* east,
+    chunk_word_t* next,
+    const grid_rule_t* rule);
+
+
+#endif  // INCLUDE_KERNEL_KERNEL_LUT_H_
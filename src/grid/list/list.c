@@ -0,0 +1,392 @@
+#include "list.h"
+
+#include <stdbool.h>
+#include <stddef.h>
+#include <stdint.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#include "../../syscalls/syscalls.h"
+
+
+#define LIST_EMPTY UINT64_MAX
+
+#define LIST_CELLS_INIT 256
+#define LIST_SLOTS_INIT 4096
+
+// en cada casilla de la tabla de conteo los 4 bits bajos
+// son los vecinos vivos y este bit indica si la célula vive
+#define LIST_ALIVE 0x10U
+#define LIST_COUNT 0x0FU
+
+#define LIST_COORD_POW 32U
+#define LIST_COORD_MASK UINT32_MAX
+
+// lista de células vivas para patrones muy poco densos: cada célula es
+// una clave fila << 32 | columna y la lista se mantiene ordenada, así
+// que consultar es una búsqueda binaria y recorrerla va por filas
+//
+// cada generación se vuelca la lista en una tabla hash de direccionamiento
+// abierto que acumula cuántos vecinos vivos tiene cada célula tocada, y
+// de ahí salen los nacimientos y supervivencias de la siguiente lista
+struct list {
+    size_t rows;
+    size_t cols;
+
+    uint64_t* cells;
+    size_t cells_len;
+    size_t cells_cap;
+
+    uint64_t* cells_next;
+    size_t cells_next_cap;
+
+    uint64_t* slot_keys;
+    uint8_t* slot_counts;
+    size_t slots_mask;
+    size_t slots_used;
+
+    grid_rule_t rule;
+};
+
+static inline uint64_t
+list_key(size_t row, size_t col) {
+    return ((uint64_t)row << LIST_COORD_POW) | (uint64_t)col;
+}
+
+// solo se mezcla la fila, así las vecinas de una misma fila caen en
+// casillas seguidas y recorrer la lista ordenada no salta por la tabla
+static inline size_t
+list_hash(uint64_t key) {
+    uint64_t row = (key >> LIST_COORD_POW) * 0x9E3779B97F4A7C15ULL;
+
+    return (size_t)((row ^ (row >> 29U)) + (key & LIST_COORD_MASK));
+}
+
+static int
+list_cmp(const void* lhs, const void* rhs) {
+    uint64_t a = *(const uint64_t*)lhs;
+    uint64_t b = *(const uint64_t*)rhs;
+
+    return (a > b) - (a < b);
+}
+
+// primera posición de la lista cuya clave no es menor que key
+static size_t
+list_lower_bound(const list_t* list, uint64_t key) {
+    size_t lo = 0;
+    size_t hi = list->cells_len;
+
+    while (lo < hi) {
+        size_t mid = lo + ((hi - lo) >> 1U);
+
+        if (list->cells[mid] < key) {
+            lo = mid + 1;
+        } else {
+            hi = mid;
+        }
+    }
+
+    return lo;
+}
+
+static int
+list_reserve(uint64_t** cells, size_t* cap, size_t len) {
+    if (len <= *cap) {
+        return 0;
+    }
+
+    size_t new_cap = *cap == 0 ? LIST_CELLS_INIT : *cap;
+
+    while (new_cap < len) {
+        new_cap *= 2;
+    }
+
+    uint64_t* new_cells = safe_realloc(*cells, new_cap * sizeof(uint64_t));
+
+    if (new_cells == NULL) {
+        fprintf(stderr, "error: failed to allocate memory for cell list\n");
+        return -1;
+    }
+
+    *cells = new_cells;
+    *cap = new_cap;
+
+    return 0;
+}
+
+// deja la tabla vacía con al menos el doble de casillas que claves
+static int
+list_reset_slots(list_t* list, size_t keys) {
+    size_t len = list->slots_mask + 1;
+
+    if (len < 2 * keys) {
+        while (len < 2 * keys) {
+            len *= 2;
+        }
+
+        uint64_t* slot_keys = safe_realloc(list->slot_keys, len * sizeof(uint64_t));
+
+        if (slot_keys == NULL) {
+            fprintf(stderr, "error: failed to allocate memory for neighbour counts\n");
+            return -1;
+        }
+
+        list->slot_keys = slot_keys;
+
+        uint8_t* slot_counts = safe_realloc(list->slot_counts, len * sizeof(uint8_t));
+
+        if (slot_counts == NULL) {
+            fprintf(stderr, "error: failed to allocate memory for neighbour counts\n");
+            return -1;
+        }
+
+        list->slot_counts = slot_counts;
+        list->slots_mask = len - 1;
+    }
+
+    memset(list->slot_keys, 0xFF, (list->slots_mask + 1) * sizeof(uint64_t));
+    list->slots_used = 0;
+
+    return 0;
+}
+
+static inline void
+list_count(list_t* list, uint64_t key, uint8_t amount) {
+    size_t idx = list_hash(key) & list->slots_mask;
+
+    while (list->slot_keys[idx] != key) {
+        if (list->slot_keys[idx] == LIST_EMPTY) {
+            list->slot_keys[idx] = key;
+            list->slot_counts[idx] = 0;
+            list->slots_used += 1;
+            break;
+        }
+
+        idx = (idx + 1) & list->slots_mask;
+    }
+
+    list->slot_counts[idx] += amount;
+}
+
+int
+list_make(list_t** list_ptr, size_t rows, size_t cols, grid_rule_t rule) {
+    if (rows >= LIST_COORD_MASK || cols >= LIST_COORD_MASK) {
+        fprintf(stderr, "error: grid dimensions too large for a cell list\n");
+        return -1;
+    }
+
+    *list_ptr = safe_malloc(sizeof(list_t));
+
+    if (*list_ptr == NULL) {
+        fprintf(stderr, "error: failed to allocate memory for cell list\n");
+        return -1;
+    }
+
+    **list_ptr = (list_t) {
+        .rows = rows,
+        .cols = cols,
+
+        .cells = NULL,
+        .cells_len = 0,
+        .cells_cap = 0,
+
+        .cells_next = NULL,
+        .cells_next_cap = 0,
+
+        .slot_keys = NULL,
+        .slot_counts = NULL,
+        .slots_mask = LIST_SLOTS_INIT - 1,
+        .slots_used = 0,
+
+        .rule = rule,
+    };
+
+    (*list_ptr)->slot_keys = safe_malloc(LIST_SLOTS_INIT * sizeof(uint64_t));
+    (*list_ptr)->slot_counts = safe_malloc(LIST_SLOTS_INIT * sizeof(uint8_t));
+
+    if ((*list_ptr)->slot_keys == NULL || (*list_ptr)->slot_counts == NULL ||
+        list_reserve(&(*list_ptr)->cells, &(*list_ptr)->cells_cap, LIST_CELLS_INIT) < 0 ||
+        list_reserve(&(*list_ptr)->cells_next, &(*list_ptr)->cells_next_cap, LIST_CELLS_INIT) < 0) {
+        list_destroy(list_ptr);
+
+        fprintf(stderr, "error: failed to allocate memory for cell list\n");
+        return -1;
+    }
+
+    return 0;
+}
+
+void
+list_destroy(list_t** list_ptr) {
+    free((*list_ptr)->cells);
+    free((*list_ptr)->cells_next);
+    free((*list_ptr)->slot_keys);
+    free((*list_ptr)->slot_counts);
+    free(*list_ptr);
+
+    *list_ptr = NULL;
+}
+
+int
+list_set_alive(list_t* list, size_t row, size_t col) {
+    if (row >= list->rows || col >= list->cols) {
+        return -1;
+    }
+
+    uint64_t key = list_key(row, col);
+
+    // los ficheros guardados van por filas, así que al cargarlos
+    // cada célula se añade al final sin mover las demás
+    size_t idx = list->cells_len > 0 && list->cells[list->cells_len - 1] < key
+        ? list->cells_len
+        : list_lower_bound(list, key);
+
+    if (idx < list->cells_len && list->cells[idx] == key) {
+        return 0;
+    }
+
+    if (list_reserve(&list->cells, &list->cells_cap, list->cells_len + 1) < 0) {
+        return -1;
+    }
+
+    memmove(&list->cells[idx + 1], &list->cells[idx], (list->cells_len - idx) * sizeof(uint64_t));
+    list->cells[idx] = key;
+    list->cells_len += 1;
+
+    return 0;
+}
+
+int
+list_set_dead(list_t* list, size_t row, size_t col) {
+    if (row >= list->rows || col >= list->cols) {
+        return -1;
+    }
+
+    uint64_t key = list_key(row, col);
+    size_t idx = list_lower_bound(list, key);
+
+    if (idx == list->cells_len || list->cells[idx] != key) {
+        return 0;
+    }
+
+    memmove(&list->cells[idx], &list->cells[idx + 1], (list->cells_len - idx - 1) * sizeof(uint64_t));
+    list->cells_len -= 1;
+
+    return 0;
+}
+
+int
+list_cell_state(const list_t* list, cell_state_t* state, size_t row, size_t col) {
+    if (row >= list->rows || col >= list->cols) {
+        return -1;
+    }
+
+    uint64_t key = list_key(row, col);
+    size_t idx = list_lower_bound(list, key);
+
+    *state = idx < list->cells_len && list->cells[idx] == key ? CELL_ALIVE : CELL_DEAD;
+
+    return 0;
+}
+
+void
+list_clear(list_t* list) {
+    list->cells_len = 0;
+}
+
+int
+list_update(list_t* list, bool torus) {
+    // cada célula viva toca como mucho a sí misma y a sus 8 vecinas
+    if (list_reset_slots(list, 9 * list->cells_len) < 0) {
+        return -1;
+    }
+
+    for (size_t i = 0; i < list->cells_len; ++i) {
+        size_t row = (size_t)(list->cells[i] >> LIST_COORD_POW);
+        size_t col = (size_t)(list->cells[i] & LIST_COORD_MASK);
+
+        // filas y columnas vecinas que existen, con el toro
+        // dando la vuelta y el modo acotado recortando el borde
+        size_t ngb_rows[3];
+        size_t ngb_cols[3];
+        size_t rows_len = 0;
+        size_t cols_len = 0;
+
+        if (row > 0 || torus) {
+            ngb_rows[rows_len++] = row > 0 ? row - 1 : list->rows - 1;
+        }
+        ngb_rows[rows_len++] = row;
+        if (row + 1 < list->rows || torus) {
+            ngb_rows[rows_len++] = row + 1 < list->rows ? row + 1 : 0;
+        }
+
+        if (col > 0 || torus) {
+            ngb_cols[cols_len++] = col > 0 ? col - 1 : list->cols - 1;
+        }
+        ngb_cols[cols_len++] = col;
+        if (col + 1 < list->cols || torus) {
+            ngb_cols[cols_len++] = col + 1 < list->cols ? col + 1 : 0;
+        }
+
+        for (size_t r = 0; r < rows_len; ++r) {
+            for (size_t c = 0; c < cols_len; ++c) {
+                bool centre = ngb_rows[r] == row && ngb_cols[c] == col;
+
+                list_count(list, list_key(ngb_rows[r], ngb_cols[c]), centre ? LIST_ALIVE : 1U);
+            }
+        }
+    }
+
+    if (list_reserve(&list->cells_next, &list->cells_next_cap, list->slots_used) < 0) {
+        return -1;
+    }
+
+    size_t next_len = 0;
+
+    for (size_t idx = 0; idx <= list->slots_mask; ++idx) {
+        if (list->slot_keys[idx] == LIST_EMPTY) {
+            continue;
+        }
+
+        uint8_t value = list->slot_counts[idx];
+        uint16_t mask = (value & LIST_ALIVE) != 0 ? list->rule.survive : list->rule.birth;
+
+        if (((mask >> (value & LIST_COUNT)) & 1U) != 0) {
+            list->cells_next[next_len++] = list->slot_keys[idx];
+        }
+    }
+
+    qsort(list->cells_next, next_len, sizeof(uint64_t), list_cmp);
+
+    uint64_t* cells = list->cells;
+    list->cells = list->cells_next;
+    list->cells_next = cells;
+
+    size_t cap = list->cells_cap;
+    list->cells_cap = list->cells_next_cap;
+    list->cells_next_cap = cap;
+
+    list->cells_len = next_len;
+
+    return 0;
+}
+
+size_t
+list_population(const list_t* list) {
+    return list->cells_len;
+}
+
+size_t
+list_computed(const list_t* list) {
+    return list->slots_used;
+}
+
+int
+list_visit_alive(const list_t* list, grid_visit_fn_t visit, void* ctx) {
+    for (size_t i = 0; i < list->cells_len; ++i) {
+        visit(ctx, (int64_t)(list->cells[i] >> LIST_COORD_POW), (int64_t)(list->cells[i] & LIST_COORD_MASK));
+    }
+
+    return 0;
+}
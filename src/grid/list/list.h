@@ -0,0 +1,44 @@
+#ifndef INCLUDE_LIST_LIST_H_
+#define INCLUDE_LIST_LIST_H_
+
+#include <stdbool.h>
+#include <stddef.h>
+#include <stdint.h>
+
+#include "../grid.h"
+
+
+typedef struct list list_t;
+
+extern int
+list_make(list_t** list_ptr, size_t rows, size_t cols, grid_rule_t rule);
+
+extern void
+list_destroy(list_t** list_ptr);
+
+extern int
+list_set_alive(list_t* list, size_t row, size_t col);
+
+extern int
+list_set_dead(list_t* list, size_t row, size_t col);
+
+extern int
+list_cell_state(const list_t* list, cell_state_t* state, size_t row, size_t col);
+
+extern void
+list_clear(list_t* list);
+
+extern int
+list_update(list_t* list, bool torus);
+
+extern size_t
+list_population(const list_t* list);
+
+extern size_t
+list_computed(const list_t* list);
+
+extern int
+list_visit_alive(const list_t* list, grid_visit_fn_t visit, void* ctx);
+
+
+#endif  // INCLUDE_LIST_LIST_H_
@@ -0,0 +1,186 @@
+#include "memo.h"
+
+#include <stdbool.h>
+#include <stddef.h>
+#include <stdint.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#include "../../syscalls/syscalls.h"
+
+
+// palabras necesarias para guardar un bit por cada fila de una columna
+#define MEMO_EDGE_WORDS ((CHUNK_PADDED + CHUNK_SIZE - 1) / CHUNK_SIZE)
+
+// lo único que lee el kernel de los nueve chunks: el propio chunk con
+// la última fila del de arriba y la primera del de abajo, y una columna
+// de bits de cada lado, así dos vecindarios que solo difieren en células
+// que no tocan al chunk comparten entrada
+typedef struct memo_key {
+    chunk_word_t centre[CHUNK_PADDED];
+    chunk_word_t west[MEMO_EDGE_WORDS];
+    chunk_word_t east[MEMO_EDGE_WORDS];
+} memo_key_t;
+
+// marca de las entradas ocupadas, junto a las que devolvió el kernel
+#define MEMO_USED 0x80U
+
+typedef struct memo_entry {
+    memo_key_t key;
+    chunk_t next;
+    uint8_t flags;
+} memo_entry_t;
+
+// tabla de correspondencia directa: cada vecindario tiene una sola
+// entrada posible y un fallo sobrescribe lo que hubiera en ella. cada
+// trabajador tiene la suya, así que no hace falta sincronizar nada
+struct memo {
+    memo_entry_t* entries;
+    size_t mask;
+    safe_mapping_t map;
+
+    // clave y entrada de la última búsqueda, para guardar su resultado
+    memo_key_t key;
+    memo_entry_t* pending;
+
+    size_t hits;
+    size_t misses;
+};
+
+static inline uint64_t
+memo_mix(uint64_t hash, chunk_word_t word) {
+#if CHUNK_BITS > 64
+    hash = (hash ^ (uint64_t)(word >> 64U)) * 0x9E3779B97F4A7C15ULL;
+#endif
+    hash = (hash ^ (uint64_t)word) * 0x9E3779B97F4A7C15ULL;
+
+    return hash ^ (hash >> 32U);
+}
+
+int
+memo_make(memo_t** memo_ptr, size_t bytes) {
+    size_t len = 1;
+
+    while (len * 2 * sizeof(memo_entry_t) <= bytes) {
+        len *= 2;
+    }
+
+    // las páginas del mapeo llegan a cero, sin MEMO_USED en ninguna
+    // entrada, y solo ocupan memoria cuando se escribe en ellas
+    safe_mapping_t map = {0};
+
+    if (safe_map(&map, len * sizeof(memo_entry_t)) < 0) {
+        fprintf(stderr, "error: failed to allocate memory for memo cache\n");
+        return -1;
+    }
+
+    *memo_ptr = safe_malloc(sizeof(memo_t));
+
+    if (*memo_ptr == NULL) {
+        safe_unmap(&map);
+
+        fprintf(stderr, "error: failed to allocate memory for memo cache\n");
+        return -1;
+    }
+
+    **memo_ptr = (memo_t) {
+        .entries = map.ptr,
+        .mask = len - 1,
+        .map = map,
+
+        .pending = NULL,
+
+        .hits = 0,
+        .misses = 0,
+    };
+
+    return 0;
+}
+
+void
+memo_destroy(memo_t** memo_ptr) {
+    safe_unmap(&(*memo_ptr)->map);
+    free(*memo_ptr);
+
+    *memo_ptr = NULL;
+}
+
+bool
+memo_lookup(
+    memo_t* memo,
+    const chunk_word_t* west,
+    const chunk_word_t* centre,
+    const chunk_word_t* east,
+    chunk_word_t* next,
+    unsigned* flags)
+{
+    memo_key_t* key = &memo->key;
+    uint64_t hash = 0;
+
+    memcpy(key->centre, centre, sizeof(key->centre));
+    memset(key->west, 0, sizeof(key->west));
+    memset(key->east, 0, sizeof(key->east));
+
+    for (size_t i = 0; i < CHUNK_PADDED; ++i) {
+        key->west[i / CHUNK_SIZE] |= ((west[i] >> CHUNK_LAST) & CHUNK_ONE) << (i & (CHUNK_SIZE - 1));
+        key->east[i / CHUNK_SIZE] |= (east[i] & CHUNK_ONE) << (i & (CHUNK_SIZE - 1));
+
+        hash = memo_mix(hash, centre[i]);
+    }
+
+    for (size_t i = 0; i < MEMO_EDGE_WORDS; ++i) {
+        hash = memo_mix(hash, key->west[i]);
+        hash = memo_mix(hash, key->east[i]);
+    }
+
+    memo_entry_t* entry = &memo->entries[hash & memo->mask];
+
+    if ((entry->flags & MEMO_USED) != 0 && memcmp(&entry->key, key, sizeof(memo_key_t)) == 0) {
+        memcpy(next, entry->next.rows, sizeof(entry->next.rows));
+        *flags = entry->flags & ~MEMO_USED;
+
+        memo->hits += 1;
+        memo->pending = NULL;
+
+        return true;
+    }
+
+    memo->misses += 1;
+    memo->pending = entry;
+
+    return false;
+}
+
+void
+memo_store(memo_t* memo, const chunk_word_t* next, unsigned flags) {
+    if (memo->pending == NULL) {
+        return;
+    }
+
+    memo->pending->key = memo->key;
+    memcpy(memo->pending->next.rows, next, sizeof(memo->pending->next.rows));
+    memo->pending->flags = (uint8_t)(flags | MEMO_USED);
+
+    memo->pending = NULL;
+}
+
+size_t
+memo_hits(const memo_t* memo) {
+    return memo->hits;
+}
+
+size_t
+memo_misses(const memo_t* memo) {
+    return memo->misses;
+}
+
+size_t
+memo_entries(const memo_t* memo) {
+    return memo->mask + 1;
+}
+
+size_t
+memo_bytes(const memo_t* memo) {
+    return memo->map.len;
+}
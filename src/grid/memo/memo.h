@@ -0,0 +1,47 @@
+#ifndef INCLUDE_MEMO_MEMO_H_
+#define INCLUDE_MEMO_MEMO_H_
+
+#include <stdbool.h>
+#include <stddef.h>
+#include <stdint.h>
+
+#include "../chunk.h"
+
+
+typedef struct memo memo_t;
+
+extern int
+memo_make(memo_t** memo_ptr, size_t bytes);
+
+extern void
+memo_destroy(memo_t** memo_ptr);
+
+// busca el resultado de las tres columnas que recibiría el kernel, si
+// está lo copia en next y deja en flags las marcas que devolvió el kernel
+extern bool
+memo_lookup(
+    memo_t* memo,
+    const chunk_word_t* west,
+    const chunk_word_t* centre,
+    const chunk_word_t* east,
+    chunk_word_t* next,
+    unsigned* flags);
+
+// guarda el resultado de la última búsqueda fallida
+extern void
+memo_store(memo_t* memo, const chunk_word_t* next, unsigned flags);
+
+extern size_t
+memo_hits(const memo_t* memo);
+
+extern size_t
+memo_misses(const memo_t* memo);
+
+extern size_t
+memo_entries(const memo_t* memo);
+
+extern size_t
+memo_bytes(const memo_t* memo);
+
+
+#endif  // INCLUDE_MEMO_MEMO_H_
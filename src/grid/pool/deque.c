@@ -0,0 +1,126 @@
+#include "deque.h"
+
+#include <assert.h>
+#include <stdatomic.h>
+#include <stddef.h>
+#include <stdint.h>
+#include <stdio.h>
+#include <stdlib.h>
+
+#include "../../syscalls/syscalls.h"
+
+
+// deque de Chase-Lev de capacidad fija: el dueño inserta y saca por
+// abajo sin bloqueos, el resto de hilos roban por arriba con un CAS.
+// los índices nunca se reinician, así un ladrón con un top antiguo
+// siempre falla el CAS aunque el deque se haya vaciado y rellenado
+struct deque {
+    _Atomic int64_t top;
+    _Atomic int64_t bottom;
+
+    size_t mask;
+    _Atomic size_t* items;
+};
+
+int
+deque_make(deque_t** deque_ptr, size_t capacity) {
+    assert(capacity > 0);
+
+    size_t size = 1;
+    while (size < capacity) {
+        size <<= 1U;
+    }
+
+    *deque_ptr = safe_malloc(sizeof(deque_t));
+
+    if (*deque_ptr == NULL) {
+        fprintf(stderr, "error: failed to allocate memory for deque\n");
+        return -1;
+    }
+
+    _Atomic size_t* items = safe_calloc(size, sizeof(_Atomic size_t));
+
+    if (items == NULL) {
+        free(*deque_ptr);
+        *deque_ptr = NULL;
+
+        fprintf(stderr, "error: failed to allocate memory for deque items\n");
+        return -1;
+    }
+
+    atomic_init(&(*deque_ptr)->top, 0);
+    atomic_init(&(*deque_ptr)->bottom, 0);
+
+    (*deque_ptr)->mask = size - 1;
+    (*deque_ptr)->items = items;
+
+    return 0;
+}
+
+void
+deque_destroy(deque_t** deque_ptr) {
+    free((*deque_ptr)->items);
+    free(*deque_ptr);
+
+    *deque_ptr = NULL;
+}
+
+void
+deque_push(deque_t* deque, size_t item) {
+    int64_t bottom = atomic_load_explicit(&deque->bottom, memory_order_relaxed);
+
+    assert(bottom - atomic_load_explicit(&deque->top, memory_order_relaxed) <= (int64_t)deque->mask);
+
+    atomic_store_explicit(&deque->items[(size_t)bottom & deque->mask], item, memory_order_relaxed);
+    atomic_thread_fence(memory_order_release);
+    atomic_store_explicit(&deque->bottom, bottom + 1, memory_order_relaxed);
+}
+
+size_t
+deque_take(deque_t* deque) {
+    int64_t bottom = atomic_load_explicit(&deque->bottom, memory_order_relaxed) - 1;
+
+    atomic_store_explicit(&deque->bottom, bottom, memory_order_relaxed);
+    atomic_thread_fence(memory_order_seq_cst);
+
+    int64_t top = atomic_load_explicit(&deque->top, memory_order_relaxed);
+
+    if (top > bottom) {
+        atomic_store_explicit(&deque->bottom, bottom + 1, memory_order_relaxed);
+        return DEQUE_EMPTY;
+    }
+
+    size_t item = atomic_load_explicit(&deque->items[(size_t)bottom & deque->mask], memory_order_relaxed);
+
+    if (top == bottom) {
+        // último elemento, se compite con los ladrones por él
+        if (!atomic_compare_exchange_strong_explicit(&deque->top, &top, top + 1,
+                    memory_order_seq_cst, memory_order_relaxed)) {
+            item = DEQUE_EMPTY;
+        }
+
+        atomic_store_explicit(&deque->bottom, bottom + 1, memory_order_relaxed);
+    }
+
+    return item;
+}
+
+size_t
+deque_steal(deque_t* deque) {
+    int64_t top = atomic_load_explicit(&deque->top, memory_order_acquire);
+    atomic_thread_fence(memory_order_seq_cst);
+    int64_t bottom = atomic_load_explicit(&deque->bottom, memory_order_acquire);
+
+    if (top >= bottom) {
+        return DEQUE_EMPTY;
+    }
+
+    size_t item = atomic_load_explicit(&deque->items[(size_t)top & deque->mask], memory_order_relaxed);
+
+    if (!atomic_compare_exchange_strong_explicit(&deque->top, &top, top + 1,
+                memory_order_seq_cst, memory_order_relaxed)) {
+        return DEQUE_EMPTY;
+    }
+
+    return item;
+}
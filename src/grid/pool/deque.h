@@ -0,0 +1,28 @@
+#ifndef INCLUDE_POOL_DEQUE_H_
+#define INCLUDE_POOL_DEQUE_H_
+
+#include <stddef.h>
+#include <stdint.h>
+
+
+#define DEQUE_EMPTY SIZE_MAX
+
+typedef struct deque deque_t;
+
+extern int
+deque_make(deque_t** deque_ptr, size_t capacity);
+
+extern void
+deque_destroy(deque_t** deque_ptr);
+
+extern void
+deque_push(deque_t* deque, size_t item);
+
+extern size_t
+deque_take(deque_t* deque);
+
+extern size_t
+deque_steal(deque_t* deque);
+
+
+#endif  // INCLUDE_POOL_DEQUE_H_
@@ -0,0 +1,193 @@
+#include "pool.h"
+
+#include <assert.h>
+#include <errno.h>
+#include <pthread.h>
+#include <stdbool.h>
+#include <stddef.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#include "../../syscalls/syscalls.h"
+
+
+struct pool {
+    pthread_t* threads;
+    size_t workers;
+
+    pthread_mutex_t lock;
+    pthread_cond_t start;
+    pthread_cond_t done;
+
+    // cada llamada a pool_run abre una nueva ronda, los hilos
+    // esperan a que cambie el contador para ejecutar la tarea
+    size_t round;
+    size_t pending;
+    bool stop;
+
+    pool_task_t task;
+    void* arg;
+};
+
+typedef struct pool_worker {
+    pool_t* pool;
+    size_t idx;
+} pool_worker_t;
+
+static void*
+pool_worker_loop(void* data) {
+    pool_worker_t worker = *(pool_worker_t*)data;
+    free(data);
+
+    pool_t* pool = worker.pool;
+    size_t seen = 0;
+
+    pthread_mutex_lock(&pool->lock);
+
+    while (1) {
+        while (pool->round == seen && !pool->stop) {
+            pthread_cond_wait(&pool->start, &pool->lock);
+        }
+
+        if (pool->stop) {
+            break;
+        }
+
+        seen = pool->round;
+
+        pool_task_t task = pool->task;
+        void* arg = pool->arg;
+
+        pthread_mutex_unlock(&pool->lock);
+
+        task(arg, worker.idx, pool->workers);
+
+        pthread_mutex_lock(&pool->lock);
+
+        // el último hilo en terminar despierta al que lanzó la ronda
+        if (--pool->pending == 0) {
+            pthread_cond_signal(&pool->done);
+        }
+    }
+
+    pthread_mutex_unlock(&pool->lock);
+
+    return NULL;
+}
+
+static void
+pool_join(pool_t* pool, size_t spawned) {
+    pthread_mutex_lock(&pool->lock);
+    pool->stop = true;
+    pthread_cond_broadcast(&pool->start);
+    pthread_mutex_unlock(&pool->lock);
+
+    for (size_t i = 0; i < spawned; ++i) {
+        pthread_join(pool->threads[i], NULL);
+    }
+}
+
+int
+pool_make(pool_t** pool_ptr, size_t workers) {
+    assert(workers > 0);
+
+    *pool_ptr = safe_malloc(sizeof(pool_t));
+
+    if (*pool_ptr == NULL) {
+        fprintf(stderr, "error: failed to allocate memory for pool\n");
+        return -1;
+    }
+
+    pool_t* pool = *pool_ptr;
+
+    // el hilo que llama a pool_run actúa como trabajador 0,
+    // por lo que solo se crean workers - 1 hilos
+    *pool = (pool_t) {
+        .threads = safe_calloc(workers, sizeof(pthread_t)),
+        .workers = workers,
+        .round = 0,
+        .pending = 0,
+        .stop = false,
+    };
+
+    if (pool->threads == NULL) {
+        free(pool);
+        *pool_ptr = NULL;
+
+        fprintf(stderr, "error: failed to allocate memory for pool threads\n");
+        return -1;
+    }
+
+    pthread_mutex_init(&pool->lock, NULL);
+    pthread_cond_init(&pool->start, NULL);
+    pthread_cond_init(&pool->done, NULL);
+
+    for (size_t i = 1; i < workers; ++i) {
+        pool_worker_t* worker = safe_malloc(sizeof(pool_worker_t));
+        int err = worker == NULL ? ENOMEM : 0;
+
+        if (worker != NULL) {
+            *worker = (pool_worker_t) { .pool = pool, .idx = i };
+            err = pthread_create(&pool->threads[i - 1], NULL, pool_worker_loop, worker);
+        }
+
+        if (err != 0) {
+            free(worker);
+            pool_join(pool, i - 1);
+            pool_destroy(pool_ptr);
+
+            fprintf(stderr, "error: failed to spawn pool thread: %s\n", strerror(err));
+            return -1;
+        }
+    }
+
+    return 0;
+}
+
+void
+pool_destroy(pool_t** pool_ptr) {
+    pool_t* pool = *pool_ptr;
+
+    if (!pool->stop) {
+        pool_join(pool, pool->workers - 1);
+    }
+
+    pthread_cond_destroy(&pool->done);
+    pthread_cond_destroy(&pool->start);
+    pthread_mutex_destroy(&pool->lock);
+
+    free(pool->threads);
+    free(pool);
+
+    *pool_ptr = NULL;
+}
+
+size_t
+pool_workers(const pool_t* pool) {
+    return pool->workers;
+}
+
+void
+pool_run(pool_t* pool, pool_task_t task, void* arg) {
+    pthread_mutex_lock(&pool->lock);
+
+    pool->task = task;
+    pool->arg = arg;
+    pool->pending = pool->workers - 1;
+    pool->round += 1;
+
+    pthread_cond_broadcast(&pool->start);
+    pthread_mutex_unlock(&pool->lock);
+
+    task(arg, 0, pool->workers);
+
+    // barrera: no se vuelve hasta que todos los hilos acaban la ronda
+    pthread_mutex_lock(&pool->lock);
+
+    while (pool->pending > 0) {
+        pthread_cond_wait(&pool->done, &pool->lock);
+    }
+
+    pthread_mutex_unlock(&pool->lock);
+}
@@ -0,0 +1,24 @@
+#ifndef INCLUDE_POOL_POOL_H_
+#define INCLUDE_POOL_POOL_H_
+
+#include <stddef.h>
+
+
+typedef struct pool pool_t;
+
+typedef void (*pool_task_t)(void* arg, size_t worker, size_t workers);
+
+extern int
+pool_make(pool_t** pool_ptr, size_t workers);
+
+extern void
+pool_destroy(pool_t** pool_ptr);
+
+extern size_t
+pool_workers(const pool_t* pool);
+
+extern void
+pool_run(pool_t* pool, pool_task_t task, void* arg);
+
+
+#endif  // INCLUDE_POOL_POOL_H_
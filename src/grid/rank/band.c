@@ -0,0 +1,236 @@
+#include "band.h"
+
+#include <inttypes.h>
+#include <stdatomic.h>
+#include <stdbool.h>
+#include <stddef.h>
+#include <stdint.h>
+#include <stdio.h>
+#include <string.h>
+
+#include "rank.h"
+#include "../chunk.h"
+#include "../grid_impl.h"
+
+#include "../../syscalls/syscalls.h"
+
+
+// células que se mandan en cada mensaje al recoger el grid
+#define RANK_GATHER_CELLS ((size_t)512)
+
+int
+rank_attach(grid_t* grid, size_t first, size_t total_rows, const grid_opts_t* opts) {
+    grid->rank_first = first;
+    grid->total_rows = total_rows;
+    grid->halo_len = (grid->chunk_cols + 2) * (sizeof(chunk_t) + sizeof(uint8_t));
+    grid->halos = safe_malloc(2 * RANK_SIDES * grid->halo_len);
+
+    if (grid->halos == NULL) {
+        fprintf(stderr, "error: failed to allocate memory for halos\n");
+        return -1;
+    }
+
+    // todos tienen que partir el mismo grid con la misma regla, o cada
+    // uno calcularía su franja de un grid distinto
+    const grid_rule_t* rule = &opts->rule;
+
+    uint64_t hello[RANK_HELLO_LEN] = {
+        total_rows,
+        grid->chunk_cols,
+        CHUNK_BITS,
+        rule->birth | ((uint64_t)rule->survive << 16U) | ((uint64_t)rule->states << 32U) | ((uint64_t)rule->range << 40U),
+        rule->birth_min | ((uint64_t)rule->birth_max << 8U) | ((uint64_t)rule->survive_min << 16U)
+            | ((uint64_t)rule->survive_max << 24U) | ((uint64_t)rule->middle << 32U),
+    };
+
+    return rank_make(&grid->rank, opts->socket, opts->rank, opts->ranks, hello);
+}
+
+// copia en buf la fila ring_row de chunks, anillo incluido, y sus marcas
+static void
+rank_halo_pack(const grid_t* grid, size_t ring_row, char* buf) {
+    size_t cols = grid->chunk_cols + 2;
+
+    for (size_t col = 0; col < cols; ++col) {
+        size_t idx = grid_idx(grid, ring_row, col);
+
+        memcpy(&buf[col * sizeof(chunk_t)], &grid->chunks[idx], sizeof(chunk_t));
+        buf[(cols * sizeof(chunk_t)) + col] = (char)grid->changed[idx];
+    }
+}
+
+// y la devuelve a una fila del anillo, con la ocupación de sus chunks
+static void
+rank_halo_unpack(const grid_t* grid, size_t ring_row, const char* buf) {
+    size_t cols = grid->chunk_cols + 2;
+
+    for (size_t col = 0; col < cols; ++col) {
+        size_t idx = grid_idx(grid, ring_row, col);
+
+        memcpy(&grid->chunks[idx], &buf[col * sizeof(chunk_t)], sizeof(chunk_t));
+        grid->changed[idx] = (uint8_t)buf[(cols * sizeof(chunk_t)) + col];
+
+        grid_occ_put(grid, grid->occ, grid_occ_bit(grid, ring_row, col), !chunk_empty(&grid->chunks[idx]));
+    }
+}
+
+// con varios procesos las filas del anillo de arriba y abajo son la
+// primera y la última de las franjas vecinas, que llegan mientras se
+// calculan las filas de dentro, que no las leen. solo la primera y la
+// última esperan a que acabe el intercambio
+int
+rank_step(grid_t* grid, bool torus) {
+    grid_topology(grid, torus);
+    grid->occ_skip = true;
+
+    // las esquinas del anillo llegan con las filas de los vecinos, que
+    // ya tienen sus columnas del anillo copiadas
+    if (torus) {
+        grid_halo_wrap_cols(grid);
+    }
+
+    size_t rows = grid->chunk_rows;
+    size_t len = grid->halo_len;
+    char* halos = grid->halos;
+
+    // en el modo acotado la primera franja y la última no tienen vecino
+    // por fuera, ese lado del anillo se queda a cero
+    bool north = torus || grid->rank_first > 0;
+    bool south = torus || grid->rank_first + rows < grid->total_rows;
+
+    rank_halo_pack(grid, 1, &halos[0]);
+    rank_halo_pack(grid, rows, &halos[len]);
+
+    const void* const send[RANK_SIDES] = {north ? &halos[0] : NULL, south ? &halos[len] : NULL};
+    void* const recv[RANK_SIDES] = {&halos[2 * len], &halos[3 * len]};
+
+    rank_exchange_start(grid->rank, send, recv, len);
+
+    grid_worker_t work = {
+        .memo = grid->memo_on ? grid->memos[0] : NULL,
+    };
+
+    // entre fila y fila se mueve lo que admitan los sockets, así el
+    // intercambio avanza sin esperar a que se llenen sus buffers
+    for (size_t row = 1; row + 1 < rows; ++row) {
+        grid_update_row(grid, row, 0, grid->chunk_cols, &work);
+
+        if (rank_exchange_poll(grid->rank, false) < 0) {
+            return -1;
+        }
+    }
+
+    if (rank_exchange_poll(grid->rank, true) < 0) {
+        return -1;
+    }
+
+    if (north) {
+        rank_halo_unpack(grid, 0, &halos[2 * len]);
+    }
+    if (south) {
+        rank_halo_unpack(grid, rows + 1, &halos[3 * len]);
+    }
+
+    grid_update_row(grid, 0, 0, grid->chunk_cols, &work);
+
+    if (rows > 1) {
+        grid_update_row(grid, rows - 1, 0, grid->chunk_cols, &work);
+    }
+
+    atomic_store(&grid->chunks_active, work.active);
+    atomic_store(&grid->chunks_periodic, work.periodic);
+
+    grid->chunks_computed += work.active;
+    grid->chunks_periodic_total += work.periodic;
+    grid->generations += 1;
+
+    return 0;
+}
+
+// células que un proceso manda de una vez, precedidas de su número.
+// un mensaje sin células cierra el envío
+typedef struct rank_gather {
+    rank_t* rank;
+    uint64_t len;
+    int64_t cells[2 * RANK_GATHER_CELLS];
+    bool failed;
+} rank_gather_t;
+
+static int
+rank_gather_flush(rank_gather_t* gather) {
+    if (rank_send(gather->rank, RANK_NORTH, &gather->len, sizeof(gather->len)) < 0
+        || rank_send(gather->rank, RANK_NORTH, gather->cells, gather->len * 2 * sizeof(int64_t)) < 0) {
+        return -1;
+    }
+
+    gather->len = 0;
+
+    return 0;
+}
+
+static void
+rank_gather_cell(void* ctx, int64_t row, int64_t col) {
+    rank_gather_t* gather = ctx;
+
+    gather->cells[2 * gather->len] = row;
+    gather->cells[(2 * gather->len) + 1] = col;
+    gather->len += 1;
+
+    if (gather->len == RANK_GATHER_CELLS && !gather->failed && rank_gather_flush(gather) < 0) {
+        gather->failed = true;
+    }
+}
+
+// las células suben de franja en franja hasta el primer proceso, que
+// las visita en el orden de las franjas, así que la salida es la misma
+// que la de un solo proceso. cada uno manda las suyas y luego pasa las
+// de los de abajo, el último no tiene nadie debajo que le mande nada
+int
+rank_gather(const grid_t* grid, grid_visit_fn_t visit, void* ctx) {
+    rank_gather_t gather = {.rank = grid->rank, .len = 0, .failed = false};
+    bool root = grid_root(grid);
+    bool last = grid->rank_first + grid->chunk_rows == grid->total_rows;
+
+    if (root) {
+        grid_visit_chunks(grid, visit, ctx);
+    } else {
+        grid_visit_chunks(grid, rank_gather_cell, &gather);
+
+        if (gather.failed || (gather.len > 0 && rank_gather_flush(&gather) < 0)) {
+            return -1;
+        }
+    }
+
+    while (!last) {
+        if (rank_recv(grid->rank, RANK_SOUTH, &gather.len, sizeof(gather.len)) < 0) {
+            return -1;
+        }
+
+        if (gather.len == 0) {
+            break;
+        }
+
+        if (gather.len > RANK_GATHER_CELLS) {
+            fprintf(stderr, "error: received %" PRIu64 " cells from a neighbouring rank\n", gather.len);
+            return -1;
+        }
+
+        if (rank_recv(grid->rank, RANK_SOUTH, gather.cells, gather.len * 2 * sizeof(int64_t)) < 0) {
+            return -1;
+        }
+
+        if (!root) {
+            if (rank_gather_flush(&gather) < 0) {
+                return -1;
+            }
+
+            continue;
+        }
+
+        for (size_t i = 0; i < gather.len; ++i) {
+            visit(ctx, gather.cells[2 * i], gather.cells[(2 * i) + 1]);
+        }
+    }
+
+    return root ? 0 : rank_gather_flush(&gather);
+}
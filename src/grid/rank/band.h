@@ -0,0 +1,25 @@
+#ifndef INCLUDE_RANK_BAND_H_
+#define INCLUDE_RANK_BAND_H_
+
+#include <stdbool.h>
+#include <stddef.h>
+
+#include "../grid.h"
+
+
+// convierte el grid en la franja que empieza en la fila de chunks first
+// de un grid de total_rows filas y lo conecta con los procesos vecinos
+extern int
+rank_attach(grid_t* grid, size_t first, size_t total_rows, const grid_opts_t* opts);
+
+// avanza una generación de la franja, intercambiando las filas del borde
+extern int
+rank_step(grid_t* grid, bool torus);
+
+// visita las células vivas del grid entero en el primer proceso, al que
+// el resto le manda las de su franja
+extern int
+rank_gather(const grid_t* grid, grid_visit_fn_t visit, void* ctx);
+
+
+#endif  // INCLUDE_RANK_BAND_H_
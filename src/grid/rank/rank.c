@@ -0,0 +1,411 @@
+#include "rank.h"
+
+#include <errno.h>
+#include <fcntl.h>
+#include <inttypes.h>
+#include <poll.h>
+#include <stdbool.h>
+#include <stddef.h>
+#include <stdint.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <unistd.h>
+#include <sys/socket.h>
+#include <sys/un.h>
+
+#include "../../syscalls/syscalls.h"
+
+
+// tiempo que se espera a que arranquen los vecinos, reintentando la
+// conexión cada RANK_RETRY_MS mientras su socket aún no existe
+#define RANK_CONNECT_MS 10000L
+#define RANK_RETRY_MS 10L
+
+// lo que queda de un sentido del intercambio en curso
+typedef struct rank_transfer {
+    const char* send;
+    char* recv;
+    size_t sent;
+    size_t received;
+} rank_transfer_t;
+
+struct rank {
+    size_t rank;
+    size_t ranks;
+
+    int fds[RANK_SIDES];
+
+    rank_transfer_t transfers[RANK_SIDES];
+    size_t len;
+};
+
+static int
+rank_address(struct sockaddr_un* addr, const char* path, size_t rank) {
+    *addr = (struct sockaddr_un) {.sun_family = AF_UNIX};
+
+    int len = snprintf(addr->sun_path, sizeof(addr->sun_path), "%s.%zu", path, rank);
+
+    if (len < 0 || (size_t)len >= sizeof(addr->sun_path)) {
+        fprintf(stderr, "error: socket path '%s' too long\n", path);
+        return -1;
+    }
+
+    return 0;
+}
+
+static int
+rank_listen(const char* path, size_t rank) {
+    struct sockaddr_un addr;
+
+    if (rank_address(&addr, path, rank) < 0) {
+        return -1;
+    }
+
+    int fd = socket(AF_UNIX, SOCK_STREAM, 0);
+
+    if (fd < 0) {
+        fprintf(stderr, "error: failed to create socket: %s\n", strerror(errno));
+        return -1;
+    }
+
+    // un socket que quedó de una ejecución anterior impediría el bind
+    unlink(addr.sun_path);
+
+    if (bind(fd, (struct sockaddr*)&addr, sizeof(addr)) < 0 || listen(fd, 1) < 0) {
+        fprintf(stderr, "error: failed to listen on '%s': %s\n", addr.sun_path, strerror(errno));
+        close(fd);
+        return -1;
+    }
+
+    return fd;
+}
+
+static int
+rank_connect(const char* path, size_t rank) {
+    struct sockaddr_un addr;
+
+    if (rank_address(&addr, path, rank) < 0) {
+        return -1;
+    }
+
+    for (long waited = 0; waited < RANK_CONNECT_MS; waited += RANK_RETRY_MS) {
+        int fd = socket(AF_UNIX, SOCK_STREAM, 0);
+
+        if (fd < 0) {
+            fprintf(stderr, "error: failed to create socket: %s\n", strerror(errno));
+            return -1;
+        }
+
+        if (connect(fd, (struct sockaddr*)&addr, sizeof(addr)) == 0) {
+            return fd;
+        }
+
+        int err = errno;
+        close(fd);
+
+        if (err != ENOENT && err != ECONNREFUSED) {
+            fprintf(stderr, "error: failed to connect to '%s': %s\n", addr.sun_path, strerror(err));
+            return -1;
+        }
+
+        safe_sleep(RANK_RETRY_MS);
+    }
+
+    fprintf(stderr, "error: timed out connecting to rank %zu on '%s'\n", rank, addr.sun_path);
+    return -1;
+}
+
+static int
+rank_accept(int listen_fd, size_t rank) {
+    struct pollfd pfd = {.fd = listen_fd, .events = POLLIN};
+    int ready;
+
+    do {
+        ready = poll(&pfd, 1, (int)RANK_CONNECT_MS);
+    } while (ready < 0 && errno == EINTR);
+
+    if (ready <= 0) {
+        fprintf(stderr, "error: timed out waiting for rank %zu to connect\n", rank);
+        return -1;
+    }
+
+    int fd = accept(listen_fd, NULL, NULL);
+
+    if (fd < 0) {
+        fprintf(stderr, "error: failed to accept rank %zu: %s\n", rank, strerror(errno));
+    }
+
+    return fd;
+}
+
+// espera hasta poder leer o escribir en fd, sin límite: si el vecino
+// muere su extremo se cierra y la espera acaba con error
+static int
+rank_wait(int fd, short events) {
+    struct pollfd pfd = {.fd = fd, .events = events};
+
+    while (poll(&pfd, 1, -1) < 0) {
+        if (errno != EINTR) {
+            fprintf(stderr, "error: failed to wait on rank connection: %s\n", strerror(errno));
+            return -1;
+        }
+    }
+
+    return 0;
+}
+
+// manda lo que pueda sin bloquearse, 1 si ya no queda nada
+static int
+rank_send_some(int fd, const char* buf, size_t len, size_t* done) {
+    while (*done < len) {
+        ssize_t n = send(fd, buf + *done, len - *done, MSG_NOSIGNAL | MSG_DONTWAIT);
+
+        if (n < 0) {
+            if (errno == EAGAIN || errno == EWOULDBLOCK) {
+                return 0;
+            }
+            if (errno == EINTR) {
+                continue;
+            }
+
+            fprintf(stderr, "error: failed to send to rank: %s\n", strerror(errno));
+            return -1;
+        }
+
+        *done += (size_t)n;
+    }
+
+    return 1;
+}
+
+static int
+rank_recv_some(int fd, char* buf, size_t len, size_t* done) {
+    while (*done < len) {
+        ssize_t n = recv(fd, buf + *done, len - *done, MSG_DONTWAIT);
+
+        if (n < 0) {
+            if (errno == EAGAIN || errno == EWOULDBLOCK) {
+                return 0;
+            }
+            if (errno == EINTR) {
+                continue;
+            }
+
+            fprintf(stderr, "error: failed to receive from rank: %s\n", strerror(errno));
+            return -1;
+        }
+
+        if (n == 0) {
+            fprintf(stderr, "error: a neighbouring rank closed its connection\n");
+            return -1;
+        }
+
+        *done += (size_t)n;
+    }
+
+    return 1;
+}
+
+int
+rank_send(rank_t* rank, rank_side_t side, const void* buf, size_t len) {
+    size_t done = 0;
+    int status;
+
+    while ((status = rank_send_some(rank->fds[side], buf, len, &done)) == 0) {
+        if (rank_wait(rank->fds[side], POLLOUT) < 0) {
+            return -1;
+        }
+    }
+
+    return status < 0 ? -1 : 0;
+}
+
+int
+rank_recv(rank_t* rank, rank_side_t side, void* buf, size_t len) {
+    size_t done = 0;
+    int status;
+
+    while ((status = rank_recv_some(rank->fds[side], buf, len, &done)) == 0) {
+        if (rank_wait(rank->fds[side], POLLIN) < 0) {
+            return -1;
+        }
+    }
+
+    return status < 0 ? -1 : 0;
+}
+
+// cada lado manda su número y su saludo y comprueba los del otro, que
+// caben de sobra en el buffer del socket aunque los dos escriban a la vez
+static int
+rank_greet(rank_t* rank, const uint64_t hello[RANK_HELLO_LEN]) {
+    uint64_t mine[RANK_HELLO_LEN + 1];
+
+    mine[0] = rank->rank;
+    memcpy(mine + 1, hello, RANK_HELLO_LEN * sizeof(uint64_t));
+
+    size_t expected[RANK_SIDES] = {
+        (rank->rank + rank->ranks - 1) % rank->ranks,
+        (rank->rank + 1) % rank->ranks,
+    };
+
+    for (size_t side = 0; side < RANK_SIDES; ++side) {
+        if (rank_send(rank, (rank_side_t)side, mine, sizeof(mine)) < 0) {
+            return -1;
+        }
+    }
+
+    for (size_t side = 0; side < RANK_SIDES; ++side) {
+        uint64_t theirs[RANK_HELLO_LEN + 1];
+
+        if (rank_recv(rank, (rank_side_t)side, theirs, sizeof(theirs)) < 0) {
+            return -1;
+        }
+
+        if (theirs[0] != expected[side]) {
+            fprintf(stderr, "error: expected rank %zu as a neighbour, got rank %" PRIu64 "\n", expected[side], theirs[0]);
+            return -1;
+        }
+
+        if (memcmp(theirs + 1, hello, RANK_HELLO_LEN * sizeof(uint64_t)) != 0) {
+            fprintf(stderr, "error: rank %zu was started with a different grid or rule\n", expected[side]);
+            return -1;
+        }
+    }
+
+    return 0;
+}
+
+int
+rank_make(rank_t** rank_ptr, const char* path, size_t rank, size_t ranks, const uint64_t hello[RANK_HELLO_LEN]) {
+    *rank_ptr = safe_malloc(sizeof(rank_t));
+
+    if (*rank_ptr == NULL) {
+        fprintf(stderr, "error: failed to allocate memory for rank\n");
+        return -1;
+    }
+
+    **rank_ptr = (rank_t) {
+        .rank = rank,
+        .ranks = ranks,
+        .fds = {-1, -1},
+        .transfers = {{0}},
+        .len = 0,
+    };
+
+    // primero se escucha, así el de abajo puede conectarse en cuanto
+    // arranque aunque este proceso aún esté esperando al de arriba
+    int listen_fd = rank_listen(path, rank);
+
+    if (listen_fd < 0) {
+        rank_destroy(rank_ptr);
+        return -1;
+    }
+
+    rank_t* self = *rank_ptr;
+
+    self->fds[RANK_NORTH] = rank_connect(path, (rank + ranks - 1) % ranks);
+
+    if (self->fds[RANK_NORTH] >= 0) {
+        self->fds[RANK_SOUTH] = rank_accept(listen_fd, (rank + 1) % ranks);
+    }
+
+    struct sockaddr_un addr;
+
+    if (rank_address(&addr, path, rank) == 0) {
+        unlink(addr.sun_path);
+    }
+
+    close(listen_fd);
+
+    if (self->fds[RANK_NORTH] < 0 || self->fds[RANK_SOUTH] < 0) {
+        rank_destroy(rank_ptr);
+        return -1;
+    }
+
+    for (size_t side = 0; side < RANK_SIDES; ++side) {
+        int flags = fcntl(self->fds[side], F_GETFL);
+
+        if (flags < 0 || fcntl(self->fds[side], F_SETFL, flags | O_NONBLOCK) < 0) {
+            fprintf(stderr, "error: failed to configure rank connection: %s\n", strerror(errno));
+            rank_destroy(rank_ptr);
+            return -1;
+        }
+    }
+
+    if (rank_greet(self, hello) < 0) {
+        rank_destroy(rank_ptr);
+        return -1;
+    }
+
+    return 0;
+}
+
+void
+rank_destroy(rank_t** rank_ptr) {
+    for (size_t side = 0; side < RANK_SIDES; ++side) {
+        if ((*rank_ptr)->fds[side] >= 0) {
+            close((*rank_ptr)->fds[side]);
+        }
+    }
+
+    free(*rank_ptr);
+    *rank_ptr = NULL;
+}
+
+void
+rank_exchange_start(rank_t* rank, const void* const send[RANK_SIDES], void* const recv[RANK_SIDES], size_t len) {
+    for (size_t side = 0; side < RANK_SIDES; ++side) {
+        rank->transfers[side] = (rank_transfer_t) {
+            .send = send[side],
+            .recv = recv[side],
+            .sent = 0,
+            .received = 0,
+        };
+    }
+
+    rank->len = len;
+}
+
+int
+rank_exchange_poll(rank_t* rank, bool wait) {
+    while (1) {
+        struct pollfd pfds[RANK_SIDES];
+        nfds_t pending = 0;
+
+        for (size_t side = 0; side < RANK_SIDES; ++side) {
+            rank_transfer_t* transfer = &rank->transfers[side];
+
+            if (transfer->send == NULL) {
+                continue;
+            }
+
+            int sent = rank_send_some(rank->fds[side], transfer->send, rank->len, &transfer->sent);
+            int received = rank_recv_some(rank->fds[side], transfer->recv, rank->len, &transfer->received);
+
+            if (sent < 0 || received < 0) {
+                return -1;
+            }
+
+            if (sent == 0 || received == 0) {
+                pfds[pending++] = (struct pollfd) {
+                    .fd = rank->fds[side],
+                    .events = (short)((sent == 0 ? POLLOUT : 0) | (received == 0 ? POLLIN : 0)),
+                };
+            }
+        }
+
+        if (pending == 0) {
+            return 1;
+        }
+
+        if (!wait) {
+            return 0;
+        }
+
+        if (poll(pfds, pending, -1) < 0 && errno != EINTR) {
+            fprintf(stderr, "error: failed to wait on rank connections: %s\n", strerror(errno));
+            return -1;
+        }
+    }
+}
@@ -0,0 +1,53 @@
+#ifndef INCLUDE_RANK_RANK_H_
+#define INCLUDE_RANK_RANK_H_
+
+#include <stdbool.h>
+#include <stddef.h>
+#include <stdint.h>
+
+
+// palabras que cada proceso manda a sus vecinos al conectarse, que
+// tienen que coincidir para que todos simulen el mismo grid
+#define RANK_HELLO_LEN 5
+
+// lados de la franja de un proceso, con un vecino conectado en cada uno
+typedef enum rank_side {
+    RANK_NORTH,
+    RANK_SOUTH,
+    RANK_SIDES,
+} rank_side_t;
+
+// uno de los ranks procesos que se reparten el grid en franjas, unido por
+// un socket unix al de la franja de arriba y otro al de la de abajo. el
+// primero y el último también están unidos entre sí para el toro
+typedef struct rank rank_t;
+
+// escucha en <path>.<rank>, se conecta al de arriba en <path>.<rank - 1>
+// y espera a que se conecte el de abajo, reintentando mientras el otro
+// proceso aún no ha arrancado
+extern int
+rank_make(rank_t** rank_ptr, const char* path, size_t rank, size_t ranks, const uint64_t hello[RANK_HELLO_LEN]);
+
+extern void
+rank_destroy(rank_t** rank_ptr);
+
+// empieza a mandar send[side] al vecino de cada lado y a recibir lo que
+// él manda en recv[side], len bytes en cada sentido. un lado con send a
+// NULL no manda ni recibe nada
+extern void
+rank_exchange_start(rank_t* rank, const void* const send[RANK_SIDES], void* const recv[RANK_SIDES], size_t len);
+
+// avanza el intercambio en curso sin bloquearse, o hasta acabarlo si
+// wait. devuelve 1 si ha acabado, 0 si no y -1 si falla una conexión
+extern int
+rank_exchange_poll(rank_t* rank, bool wait);
+
+// envío y recepción bloqueantes de len bytes con el vecino de un lado
+extern int
+rank_send(rank_t* rank, rank_side_t side, const void* buf, size_t len);
+
+extern int
+rank_recv(rank_t* rank, rank_side_t side, void* buf, size_t len);
+
+
+#endif  // INCLUDE_RANK_RANK_H_
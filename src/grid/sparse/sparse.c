@@ -0,0 +1,610 @@
+#include "sparse.h"
+
+#include <assert.h>
+#include <stdbool.h>
+#include <stddef.h>
+#include <stdint.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#include "../../syscalls/syscalls.h"
+
+
+#define SPARSE_NO_NODE UINT32_MAX
+
+#define SPARSE_SLOTS_INIT 1024
+
+// los nodos se reservan en bloques fijos que nunca se mueven, así los
+// índices y punteros a nodos siguen valiendo aunque el pool crezca
+#define SPARSE_SLAB_POW 8
+#define SPARSE_SLAB_LEN (1U << SPARSE_SLAB_POW)
+
+// margen para que las coordenadas de los vecinos nunca desborden
+#define SPARSE_COORD_MAX (INT64_MAX >> 2)
+
+typedef struct sparse_node {
+    chunk_t gens[2];
+
+    int64_t crow;
+    int64_t ccol;
+
+    uint32_t next_free;
+    bool live;
+} sparse_node_t;
+
+typedef struct sparse_slot {
+    int64_t crow;
+    int64_t ccol;
+    uint32_t node;
+} sparse_slot_t;
+
+// plano infinito: solo existen los chunks con alguna célula viva y los
+// que tocan su borde, indexados por una tabla hash de direccionamiento
+// abierto con sondeo lineal y borrado por desplazamiento hacia atrás
+struct sparse {
+    sparse_slot_t* slots;
+    size_t slots_mask;
+    size_t slots_used;
+
+    sparse_node_t** slabs;
+    size_t slabs_len;
+    size_t slabs_cap;
+
+    size_t nodes_len;
+    size_t nodes_live;
+    uint32_t free_head;
+
+    // índice en gens del estado actual, el otro recibe la siguiente generación
+    unsigned gen;
+
+    kernel_fn_t kernel;
+    grid_rule_t rule;
+    size_t computed;
+};
+
+static inline size_t
+sparse_hash(int64_t crow, int64_t ccol) {
+    uint64_t hash = ((uint64_t)crow * 0x9E3779B97F4A7C15ULL) ^ (uint64_t)ccol;
+
+    hash ^= hash >> 31U;
+    hash *= 0xBF58476D1CE4E5B9ULL;
+    hash ^= hash >> 29U;
+
+    return (size_t)hash;
+}
+
+static inline sparse_node_t*
+sparse_node(const sparse_t* sparse, uint32_t idx) {
+    assert(idx < sparse->nodes_len);
+
+    return &sparse->slabs[idx >> SPARSE_SLAB_POW][idx & (SPARSE_SLAB_LEN - 1)];
+}
+
+static size_t
+sparse_probe(const sparse_t* sparse, int64_t crow, int64_t ccol) {
+    size_t slot = sparse_hash(crow, ccol) & sparse->slots_mask;
+
+    while (sparse->slots[slot].node != SPARSE_NO_NODE) {
+        if (sparse->slots[slot].crow == crow && sparse->slots[slot].ccol == ccol) {
+            break;
+        }
+
+        slot = (slot + 1) & sparse->slots_mask;
+    }
+
+    return slot;
+}
+
+static inline const chunk_t*
+sparse_find(const sparse_t* sparse, int64_t crow, int64_t ccol) {
+    uint32_t idx = sparse->slots[sparse_probe(sparse, crow, ccol)].node;
+
+    return idx == SPARSE_NO_NODE ? NULL : &sparse_node(sparse, idx)->gens[sparse->gen];
+}
+
+// los chunks que no están en la tabla se leen como este, todo muerto
+static const chunk_t SPARSE_DEAD;
+
+static inline const chunk_t*
+sparse_ngb(const sparse_t* sparse, int64_t crow, int64_t ccol) {
+    const chunk_t* chunk = sparse_find(sparse, crow, ccol);
+
+    return chunk == NULL ? &SPARSE_DEAD : chunk;
+}
+
+static sparse_slot_t*
+sparse_slots_make(size_t len) {
+    sparse_slot_t* slots = safe_malloc(len * sizeof(sparse_slot_t));
+
+    if (slots == NULL) {
+        return NULL;
+    }
+
+    for (size_t i = 0; i < len; ++i) {
+        slots[i].node = SPARSE_NO_NODE;
+    }
+
+    return slots;
+}
+
+static int
+sparse_grow(sparse_t* sparse) {
+    size_t len = (sparse->slots_mask + 1) * 2;
+    sparse_slot_t* slots = sparse_slots_make(len);
+
+    if (slots == NULL) {
+        fprintf(stderr, "error: failed to allocate memory for chunk table\n");
+        return -1;
+    }
+
+    sparse_slot_t* old = sparse->slots;
+    size_t old_len = sparse->slots_mask + 1;
+
+    sparse->slots = slots;
+    sparse->slots_mask = len - 1;
+
+    for (size_t i = 0; i < old_len; ++i) {
+        if (old[i].node != SPARSE_NO_NODE) {
+            sparse->slots[sparse_probe(sparse, old[i].crow, old[i].ccol)] = old[i];
+        }
+    }
+
+    free(old);
+
+    return 0;
+}
+
+static uint32_t
+sparse_node_alloc(sparse_t* sparse) {
+    if (sparse->free_head != SPARSE_NO_NODE) {
+        uint32_t idx = sparse->free_head;
+        sparse->free_head = sparse_node(sparse, idx)->next_free;
+
+        return idx;
+    }
+
+    if (sparse->nodes_len >= SPARSE_NO_NODE) {
+        fprintf(stderr, "error: too many chunks in unbounded grid\n");
+        return SPARSE_NO_NODE;
+    }
+
+    if (sparse->nodes_len == sparse->slabs_len * SPARSE_SLAB_LEN) {
+        if (sparse->slabs_len == sparse->slabs_cap) {
+            size_t cap = sparse->slabs_cap == 0 ? 16 : sparse->slabs_cap * 2;
+            sparse_node_t** slabs = safe_realloc(sparse->slabs, cap * sizeof(sparse_node_t*));
+
+            if (slabs == NULL) {
+                fprintf(stderr, "error: failed to allocate memory for chunk pool\n");
+                return SPARSE_NO_NODE;
+            }
+
+            sparse->slabs = slabs;
+            sparse->slabs_cap = cap;
+        }
+
+        sparse_node_t* slab = safe_malloc(SPARSE_SLAB_LEN * sizeof(sparse_node_t));
+
+        if (slab == NULL) {
+            fprintf(stderr, "error: failed to allocate memory for chunk pool\n");
+            return SPARSE_NO_NODE;
+        }
+
+        sparse->slabs[sparse->slabs_len++] = slab;
+    }
+
+    return (uint32_t)sparse->nodes_len++;
+}
+
+static uint32_t
+sparse_insert(sparse_t* sparse, int64_t crow, int64_t ccol) {
+    size_t slot = sparse_probe(sparse, crow, ccol);
+
+    if (sparse->slots[slot].node != SPARSE_NO_NODE) {
+        return sparse->slots[slot].node;
+    }
+
+    // la tabla se mantiene como mucho a la mitad para que los sondeos sean cortos
+    if ((sparse->slots_used + 1) * 2 > sparse->slots_mask + 1) {
+        if (sparse_grow(sparse) < 0) {
+            return SPARSE_NO_NODE;
+        }
+
+        slot = sparse_probe(sparse, crow, ccol);
+    }
+
+    uint32_t idx = sparse_node_alloc(sparse);
+
+    if (idx == SPARSE_NO_NODE) {
+        return SPARSE_NO_NODE;
+    }
+
+    sparse_node_t* node = sparse_node(sparse, idx);
+
+    memset(node->gens, 0, sizeof(node->gens));
+    node->crow = crow;
+    node->ccol = ccol;
+    node->live = true;
+
+    sparse->slots[slot] = (sparse_slot_t) {
+        .crow = crow,
+        .ccol = ccol,
+        .node = idx,
+    };
+
+    sparse->slots_used += 1;
+    sparse->nodes_live += 1;
+
+    return idx;
+}
+
+static void
+sparse_remove(sparse_t* sparse, int64_t crow, int64_t ccol) {
+    size_t hole = sparse_probe(sparse, crow, ccol);
+    uint32_t idx = sparse->slots[hole].node;
+
+    assert(idx != SPARSE_NO_NODE);
+
+    // se desplazan hacia el hueco las entradas posteriores de la misma
+    // secuencia de sondeo que no quedarían antes de su posición ideal
+    size_t slot = hole;
+
+    while (1) {
+        slot = (slot + 1) & sparse->slots_mask;
+
+        if (sparse->slots[slot].node == SPARSE_NO_NODE) {
+            break;
+        }
+
+        size_t home = sparse_hash(sparse->slots[slot].crow, sparse->slots[slot].ccol) & sparse->slots_mask;
+        size_t dist_home = (slot - home) & sparse->slots_mask;
+        size_t dist_hole = (slot - hole) & sparse->slots_mask;
+
+        if (dist_home >= dist_hole) {
+            sparse->slots[hole] = sparse->slots[slot];
+            hole = slot;
+        }
+    }
+
+    sparse->slots[hole].node = SPARSE_NO_NODE;
+    sparse->slots_used -= 1;
+
+    sparse_node_t* node = sparse_node(sparse, idx);
+
+    node->live = false;
+    node->next_free = sparse->free_head;
+    sparse->free_head = idx;
+    sparse->nodes_live -= 1;
+}
+
+static inline int
+sparse_split(int64_t coord, int64_t* chunk, size_t* local) {
+    if (coord < -SPARSE_COORD_MAX || coord > SPARSE_COORD_MAX) {
+        return -1;
+    }
+
+    *chunk = coord >> CHUNK_POW;
+    *local = (size_t)(coord & (CHUNK_SIZE - 1));
+
+    return 0;
+}
+
+int
+sparse_make(sparse_t** sparse_ptr, kernel_fn_t kernel, grid_rule_t rule) {
+    sparse_slot_t* slots = sparse_slots_make(SPARSE_SLOTS_INIT);
+
+    if (slots == NULL) {
+        fprintf(stderr, "error: failed to allocate memory for chunk table\n");
+        return -1;
+    }
+
+    *sparse_ptr = safe_malloc(sizeof(sparse_t));
+
+    if (*sparse_ptr == NULL) {
+        free(slots);
+
+        fprintf(stderr, "error: failed to allocate memory for unbounded grid\n");
+        return -1;
+    }
+
+    **sparse_ptr = (sparse_t) {
+        .slots = slots,
+        .slots_mask = SPARSE_SLOTS_INIT - 1,
+        .slots_used = 0,
+
+        .slabs = NULL,
+        .slabs_len = 0,
+        .slabs_cap = 0,
+
+        .nodes_len = 0,
+        .nodes_live = 0,
+        .free_head = SPARSE_NO_NODE,
+
+        .gen = 0,
+
+        .kernel = kernel,
+        .rule = rule,
+        .computed = 0,
+    };
+
+    return 0;
+}
+
+void
+sparse_destroy(sparse_t** sparse_ptr) {
+    for (size_t i = 0; i < (*sparse_ptr)->slabs_len; ++i) {
+        free((*sparse_ptr)->slabs[i]);
+    }
+
+    free((*sparse_ptr)->slabs);
+    free((*sparse_ptr)->slots);
+    free(*sparse_ptr);
+
+    *sparse_ptr = NULL;
+}
+
+chunk_t*
+sparse_chunk_at(sparse_t* sparse, int64_t crow, int64_t ccol) {
+    uint32_t idx = sparse_insert(sparse, crow, ccol);
+
+    return idx == SPARSE_NO_NODE ? NULL : &sparse_node(sparse, idx)->gens[sparse->gen];
+}
+
+int
+sparse_set_alive(sparse_t* sparse, int64_t row, int64_t col) {
+    int64_t crow, ccol;
+    size_t local_row, local_col;
+
+    if (sparse_split(row, &crow, &local_row) < 0 || sparse_split(col, &ccol, &local_col) < 0) {
+        return -1;
+    }
+
+    chunk_t* chunk = sparse_chunk_at(sparse, crow, ccol);
+
+    if (chunk == NULL) {
+        return -1;
+    }
+
+    chunk_set_alive(chunk, local_row, local_col);
+
+    return 0;
+}
+
+int
+sparse_set_dead(sparse_t* sparse, int64_t row, int64_t col) {
+    int64_t crow, ccol;
+    size_t local_row, local_col;
+
+    if (sparse_split(row, &crow, &local_row) < 0 || sparse_split(col, &ccol, &local_col) < 0) {
+        return -1;
+    }
+
+    // si queda vacío, el chunk se libera en la siguiente generación
+    chunk_t* chunk = (chunk_t*)sparse_find(sparse, crow, ccol);
+
+    if (chunk != NULL) {
+        chunk_set_dead(chunk, local_row, local_col);
+    }
+
+    return 0;
+}
+
+cell_state_t
+sparse_cell_state(const sparse_t* sparse, int64_t row, int64_t col) {
+    int64_t crow, ccol;
+    size_t local_row, local_col;
+
+    if (sparse_split(row, &crow, &local_row) < 0 || sparse_split(col, &ccol, &local_col) < 0) {
+        return CELL_DEAD;
+    }
+
+    const chunk_t* chunk = sparse_find(sparse, crow, ccol);
+
+    return chunk == NULL ? CELL_DEAD : chunk_get(chunk, local_row, local_col);
+}
+
+void
+sparse_clear(sparse_t* sparse) {
+    // los bloques del pool se conservan para reutilizarlos
+    for (size_t i = 0; i <= sparse->slots_mask; ++i) {
+        sparse->slots[i].node = SPARSE_NO_NODE;
+    }
+
+    sparse->slots_used = 0;
+    sparse->nodes_len = 0;
+    sparse->nodes_live = 0;
+    sparse->free_head = SPARSE_NO_NODE;
+}
+
+static int
+sparse_touch(sparse_t* sparse, bool needed, int64_t crow, int64_t ccol) {
+    if (!needed) {
+        return 0;
+    }
+
+    return sparse_insert(sparse, crow, ccol) == SPARSE_NO_NODE ? -1 : 0;
+}
+
+static int
+sparse_expand(sparse_t* sparse) {
+    // solo se crean los vecinos hacia los que el chunk tiene células en el
+    // borde, son los únicos que pueden recibir nacimientos. los nodos que se
+    // crean aquí están vacíos, así que no importa si el bucle los visita
+    size_t len = sparse->nodes_len;
+
+    for (size_t i = 0; i < len; ++i) {
+        const sparse_node_t* node = sparse_node(sparse, (uint32_t)i);
+
+        if (!node->live) {
+            continue;
+        }
+
+        const chunk_t* chunk = &node->gens[sparse->gen];
+
+        chunk_word_t top = chunk->rows[0];
+        chunk_word_t bot = chunk->rows[CHUNK_LAST];
+        chunk_word_t any = 0;
+
+        for (size_t row = 0; row < CHUNK_SIZE; ++row) {
+            any |= chunk->rows[row];
+        }
+
+        if (any == 0) {
+            continue;
+        }
+
+        int64_t crow = node->crow;
+        int64_t ccol = node->ccol;
+
+        // el bit 0 es la columna oeste del chunk y el bit CHUNK_LAST la este
+        if (sparse_touch(sparse, top != 0,                             crow - 1, ccol)     < 0 ||
+            sparse_touch(sparse, bot != 0,                             crow + 1, ccol)     < 0 ||
+            sparse_touch(sparse, (any & CHUNK_ONE) != 0,               crow,     ccol - 1) < 0 ||
+            sparse_touch(sparse, ((any >> CHUNK_LAST) & CHUNK_ONE) != 0, crow,   ccol + 1) < 0 ||
+            sparse_touch(sparse, (top & CHUNK_ONE) != 0,               crow - 1, ccol - 1) < 0 ||
+            sparse_touch(sparse, ((top >> CHUNK_LAST) & CHUNK_ONE) != 0, crow - 1, ccol + 1) < 0 ||
+            sparse_touch(sparse, (bot & CHUNK_ONE) != 0,               crow + 1, ccol - 1) < 0 ||
+            sparse_touch(sparse, ((bot >> CHUNK_LAST) & CHUNK_ONE) != 0, crow + 1, ccol + 1) < 0) {
+            return -1;
+        }
+    }
+
+    return 0;
+}
+
+int
+sparse_update(sparse_t* sparse) {
+    if (sparse_expand(sparse) < 0) {
+        fprintf(stderr, "error: failed to grow unbounded grid\n");
+        return -1;
+    }
+
+    unsigned next = sparse->gen ^ 1U;
+
+    chunk_word_t west[CHUNK_PADDED];
+    chunk_word_t centre[CHUNK_PADDED];
+    chunk_word_t east[CHUNK_PADDED];
+
+    sparse->computed = 0;
+
+    for (size_t i = 0; i < sparse->nodes_len; ++i) {
+        sparse_node_t* node = sparse_node(sparse, (uint32_t)i);
+
+        if (!node->live) {
+            continue;
+        }
+
+        int64_t crow = node->crow;
+        int64_t ccol = node->ccol;
+
+        chunk_column(sparse_ngb(sparse, crow - 1, ccol - 1),
+                     sparse_ngb(sparse, crow,     ccol - 1),
+                     sparse_ngb(sparse, crow + 1, ccol - 1), west);
+        chunk_column(sparse_ngb(sparse, crow - 1, ccol),
+                     &node->gens[sparse->gen],
+                     sparse_ngb(sparse, crow + 1, ccol),     centre);
+        chunk_column(sparse_ngb(sparse, crow - 1, ccol + 1),
+                     sparse_ngb(sparse, crow,     ccol + 1),
+                     sparse_ngb(sparse, crow + 1, ccol + 1), east);
+
+        (void)sparse->kernel(west, centre, east, node->gens[next].rows, &sparse->rule);
+
+        sparse->computed += 1;
+    }
+
+    sparse->gen = next;
+
+    // los chunks que se han quedado vacíos vuelven al pool
+    for (size_t i = 0; i < sparse->nodes_len; ++i) {
+        sparse_node_t* node = sparse_node(sparse, (uint32_t)i);
+
+        if (node->live && chunk_empty(&node->gens[next])) {
+            sparse_remove(sparse, node->crow, node->ccol);
+        }
+    }
+
+    return 0;
+}
+
+size_t
+sparse_chunks(const sparse_t* sparse) {
+    return sparse->nodes_live;
+}
+
+size_t
+sparse_computed(const sparse_t* sparse) {
+    return sparse->computed;
+}
+
+typedef struct sparse_key {
+    int64_t crow;
+    int64_t ccol;
+    const chunk_t* chunk;
+} sparse_key_t;
+
+static int
+sparse_key_cmp(const void* lhs, const void* rhs) {
+    const sparse_key_t* a = lhs;
+    const sparse_key_t* b = rhs;
+
+    if (a->crow != b->crow) {
+        return a->crow < b->crow ? -1 : 1;
+    }
+    if (a->ccol != b->ccol) {
+        return a->ccol < b->ccol ? -1 : 1;
+    }
+
+    return 0;
+}
+
+int
+sparse_visit_alive(const sparse_t* sparse, grid_visit_fn_t visit, void* ctx) {
+    if (sparse->nodes_live == 0) {
+        return 0;
+    }
+
+    sparse_key_t* keys = safe_malloc(sparse->nodes_live * sizeof(sparse_key_t));
+
+    if (keys == NULL) {
+        fprintf(stderr, "error: failed to allocate memory for chunk listing\n");
+        return -1;
+    }
+
+    size_t keys_len = 0;
+
+    for (size_t i = 0; i < sparse->nodes_len; ++i) {
+        const sparse_node_t* node = sparse_node(sparse, (uint32_t)i);
+
+        if (node->live) {
+            keys[keys_len++] = (sparse_key_t) {
+                .crow = node->crow,
+                .ccol = node->ccol,
+                .chunk = &node->gens[sparse->gen],
+            };
+        }
+    }
+
+    // el orden de la tabla es arbitrario, se ordenan los chunks para
+    // recorrer las células por filas igual que en el grid denso
+    qsort(keys, keys_len, sizeof(sparse_key_t), sparse_key_cmp);
+
+    for (size_t begin = 0, end = 0; begin < keys_len; begin = end) {
+        while (end < keys_len && keys[end].crow == keys[begin].crow) {
+            ++end;
+        }
+
+        for (size_t local_row = 0; local_row < CHUNK_SIZE; ++local_row) {
+            int64_t row = (keys[begin].crow * CHUNK_SIZE) + (int64_t)local_row;
+
+            for (size_t k = begin; k < end; ++k) {
+                for (chunk_word_t word = keys[k].chunk->rows[local_row]; word != 0; word &= word - 1) {
+                    visit(ctx, row, (keys[k].ccol * CHUNK_SIZE) + (int64_t)chunk_word_ctz(word));
+                }
+            }
+        }
+    }
+
+    free(keys);
+
+    return 0;
+}
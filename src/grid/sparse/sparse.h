@@ -0,0 +1,48 @@
+#ifndef INCLUDE_SPARSE_SPARSE_H_
+#define INCLUDE_SPARSE_SPARSE_H_
+
+#include <stddef.h>
+#include <stdint.h>
+
+#include "../chunk.h"
+#include "../grid.h"
+#include "../kernel/kernel.h"
+
+
+typedef struct sparse sparse_t;
+
+extern int
+sparse_make(sparse_t** sparse_ptr, kernel_fn_t kernel, grid_rule_t rule);
+
+extern void
+sparse_destroy(sparse_t** sparse_ptr);
+
+extern int
+sparse_set_alive(sparse_t* sparse, int64_t row, int64_t col);
+
+extern int
+sparse_set_dead(sparse_t* sparse, int64_t row, int64_t col);
+
+extern cell_state_t
+sparse_cell_state(const sparse_t* sparse, int64_t row, int64_t col);
+
+extern chunk_t*
+sparse_chunk_at(sparse_t* sparse, int64_t crow, int64_t ccol);
+
+extern void
+sparse_clear(sparse_t* sparse);
+
+extern int
+sparse_update(sparse_t* sparse);
+
+extern size_t
+sparse_chunks(const sparse_t* sparse);
+
+extern size_t
+sparse_computed(const sparse_t* sparse);
+
+extern int
+sparse_visit_alive(const sparse_t* sparse, grid_visit_fn_t visit, void* ctx);
+
+
+#endif  // INCLUDE_SPARSE_SPARSE_H_
@@ -0,0 +1,424 @@
+#include "timeblock.h"
+
+#include <stdatomic.h>
+#include <stdbool.h>
+#include <stddef.h>
+#include <stdint.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#include "../chunk.h"
+#include "../grid_impl.h"
+#include "../kernel/kernel.h"
+#include "../pool/pool.h"
+
+#include "../../syscalls/syscalls.h"
+
+
+// memoria de los dos buffers de cada trabajador cuando no se pide un
+// tamaño de tile, pensada para que quepan en L2
+#define TIMEBLOCK_BYTES ((size_t)1 << 19)
+
+// cada tile se copia con un margen de halo chunks a un buffer del
+// trabajador, ahí avanza varias generaciones seguidas sin salir de caché
+// y solo se devuelve el interior. still marca los tiles que en la pasada
+// anterior ya estaban quietos
+struct timeblock {
+    size_t tile;
+    size_t halo;
+    size_t side;
+    size_t len;
+    size_t rows;
+    size_t cols;
+    chunk_t* chunks;
+    uint8_t* changed;
+    uint8_t* still;
+    size_t gens;
+    bool torus;
+    _Atomic size_t computed;
+};
+
+// k generaciones necesitan k células de margen, que se redondean a
+// chunks enteros, y cada trabajador tiene sus dos buffers con anillo
+int
+timeblock_make(timeblock_t** block_ptr, size_t chunk_rows, size_t chunk_cols, size_t tile, size_t gens, size_t workers) {
+    size_t halo = (gens + CHUNK_SIZE - 1) / CHUNK_SIZE;
+
+    // el tile más grande cuyos buffers caben en TIMEBLOCK_BYTES
+    if (tile == 0) {
+        tile = 1;
+
+        while ((tile + (2 * halo) + 3) * (tile + (2 * halo) + 3) * 2 * sizeof(chunk_t) <= TIMEBLOCK_BYTES) {
+            tile += 1;
+        }
+    }
+
+    *block_ptr = safe_malloc(sizeof(timeblock_t));
+
+    if (*block_ptr == NULL) {
+        fprintf(stderr, "error: failed to allocate memory for time blocking\n");
+        return -1;
+    }
+
+    size_t side = tile + (2 * halo) + 2;
+    size_t len = side * side;
+    size_t rows = (chunk_rows + tile - 1) / tile;
+    size_t cols = (chunk_cols + tile - 1) / tile;
+
+    **block_ptr = (timeblock_t) {
+        .tile = tile,
+        .halo = halo,
+        .side = side,
+        .len = len,
+        .rows = rows,
+        .cols = cols,
+        .chunks = safe_calloc(2 * workers * len, sizeof(chunk_t)),
+        .changed = safe_calloc(2 * workers * len, sizeof(uint8_t)),
+        .still = safe_calloc(rows * cols, sizeof(uint8_t)),
+        .gens = 0,
+        .torus = false,
+    };
+
+    atomic_init(&(*block_ptr)->computed, 0);
+
+    if ((*block_ptr)->chunks == NULL || (*block_ptr)->changed == NULL || (*block_ptr)->still == NULL) {
+        timeblock_destroy(block_ptr);
+
+        fprintf(stderr, "error: failed to allocate memory for time blocking\n");
+        return -1;
+    }
+
+    return 0;
+}
+
+void
+timeblock_destroy(timeblock_t** block_ptr) {
+    free((*block_ptr)->chunks);
+    free((*block_ptr)->changed);
+    free((*block_ptr)->still);
+    free(*block_ptr);
+
+    *block_ptr = NULL;
+}
+
+// chunk de una dimensión de len chunks que cae en la posición pos de un
+// tile ampliado con halo chunks de margen, o SIZE_MAX si queda fuera
+static inline size_t
+timeblock_coord(size_t pos, size_t halo, size_t len, bool torus) {
+    if (pos < halo) {
+        if (!torus) {
+            return SIZE_MAX;
+        }
+
+        size_t back = (halo - pos) % len;
+        return back == 0 ? 0 : len - back;
+    }
+
+    pos -= halo;
+
+    if (pos >= len) {
+        return torus ? pos % len : SIZE_MAX;
+    }
+
+    return pos;
+}
+
+// buffers de un trabajador para el bloqueo temporal, con la misma
+// disposición que el grid: side x side chunks y sus marcas
+typedef struct timeblock_scratch {
+    chunk_t* chunks;
+    chunk_t* chunks_next;
+    uint8_t* changed;
+    uint8_t* changed_next;
+} timeblock_scratch_t;
+
+static bool
+timeblock_stable(const grid_t* grid, size_t row_begin, size_t col_begin, size_t span_rows, size_t span_cols) {
+    const timeblock_t* block = grid->timeblock;
+
+    size_t halo = block->halo;
+    bool torus = block->torus;
+
+    for (size_t i = 0; i < span_rows; ++i) {
+        size_t row = timeblock_coord(row_begin + i, halo, grid->chunk_rows, torus);
+
+        for (size_t j = 0; j < span_cols && row != SIZE_MAX; ++j) {
+            size_t col = timeblock_coord(col_begin + j, halo, grid->chunk_cols, torus);
+
+            if (col != SIZE_MAX && grid->changed[grid_chunk_idx(grid, row, col)]) {
+                return false;
+            }
+        }
+    }
+
+    return true;
+}
+
+static void
+timeblock_load(const grid_t* grid, const timeblock_scratch_t* scratch, size_t row_begin, size_t col_begin, size_t span_rows, size_t span_cols) {
+    const timeblock_t* block = grid->timeblock;
+
+    size_t halo = block->halo;
+    size_t side = block->side;
+    bool torus = block->torus;
+
+    // donde la marca cargada del grid está a 0 los dos buffers empiezan
+    // iguales, así sigue significando que el chunk no cambió respecto al
+    // otro buffer, el resto se calcula en la primera generación
+    for (size_t i = 0; i < span_rows; ++i) {
+        size_t row = timeblock_coord(row_begin + i, halo, grid->chunk_rows, torus);
+
+        for (size_t j = 0; j < span_cols; ++j) {
+            size_t col = timeblock_coord(col_begin + j, halo, grid->chunk_cols, torus);
+            size_t idx = ((i + 1) * side) + j + 1;
+
+            if (row == SIZE_MAX || col == SIZE_MAX) {
+                memset(&scratch->chunks[idx], 0, sizeof(chunk_t));
+                scratch->changed[idx] = 0;
+            } else {
+                size_t src = grid_chunk_idx(grid, row, col);
+
+                scratch->chunks[idx] = grid->chunks[src];
+                scratch->changed[idx] = grid->changed[src];
+            }
+
+            if (!scratch->changed[idx]) {
+                scratch->chunks_next[idx] = scratch->chunks[idx];
+            }
+        }
+    }
+
+    // fuera del buffer no se sabe qué pasa, así que el anillo que lo rodea
+    // se da siempre por cambiado y obliga a calcular los chunks del borde
+    for (size_t i = 0; i < span_rows + 2; ++i) {
+        size_t west = i * side;
+        size_t east = west + span_cols + 1;
+
+        memset(&scratch->chunks[west], 0, sizeof(chunk_t));
+        memset(&scratch->chunks[east], 0, sizeof(chunk_t));
+        memset(&scratch->chunks_next[west], 0, sizeof(chunk_t));
+        memset(&scratch->chunks_next[east], 0, sizeof(chunk_t));
+
+        scratch->changed[west] = scratch->changed_next[west] = 1;
+        scratch->changed[east] = scratch->changed_next[east] = 1;
+    }
+
+    for (size_t j = 0; j < span_cols + 2; ++j) {
+        size_t north = j;
+        size_t south = ((span_rows + 1) * side) + j;
+
+        memset(&scratch->chunks[north], 0, sizeof(chunk_t));
+        memset(&scratch->chunks[south], 0, sizeof(chunk_t));
+        memset(&scratch->chunks_next[north], 0, sizeof(chunk_t));
+        memset(&scratch->chunks_next[south], 0, sizeof(chunk_t));
+
+        scratch->changed[north] = scratch->changed_next[north] = 1;
+        scratch->changed[south] = scratch->changed_next[south] = 1;
+    }
+}
+
+static size_t
+timeblock_tile(const grid_t* grid, size_t tile, timeblock_scratch_t* scratch, size_t* computed) {
+    const timeblock_t* block = grid->timeblock;
+
+    size_t halo = block->halo;
+    size_t side = block->side;
+    size_t gens = block->gens;
+
+    size_t row_begin = (tile / block->cols) * block->tile;
+    size_t col_begin = (tile % block->cols) * block->tile;
+
+    size_t rows = block->tile;
+    size_t cols = block->tile;
+
+    if (row_begin + rows > grid->chunk_rows) {
+        rows = grid->chunk_rows - row_begin;
+    }
+    if (col_begin + cols > grid->chunk_cols) {
+        cols = grid->chunk_cols - col_begin;
+    }
+
+    size_t span_rows = rows + (2 * halo);
+    size_t span_cols = cols + (2 * halo);
+
+    // si nada cambió en el tile ni en su margen la región es estable y,
+    // como en gens generaciones la información avanza como mucho halo
+    // chunks, el interior sigue igual al final de la pasada
+    if (timeblock_stable(grid, row_begin, col_begin, span_rows, span_cols)) {
+        // si ya estaba quieto en la pasada anterior los dos buffers
+        // del grid coinciden y no hace falta ni copiarlo
+        for (size_t i = 0; i < rows; ++i) {
+            for (size_t j = 0; j < cols; ++j) {
+                size_t idx = grid_chunk_idx(grid, row_begin + i, col_begin + j);
+
+                size_t bit = grid_occ_bit(grid, row_begin + i + 1, col_begin + j + 1);
+
+                if (!block->still[tile]) {
+                    grid->chunks_next[idx] = grid->chunks[idx];
+                    grid_occ_put(grid, grid->occ_next, bit, grid_occ_get(grid->occ, bit));
+                }
+                grid->changed_next[idx] = 0;
+            }
+        }
+
+        block->still[tile] = 1;
+        return 0;
+    }
+
+    block->still[tile] = 0;
+
+    timeblock_load(grid, scratch, row_begin, col_begin, span_rows, span_cols);
+
+    // en un grid acotado lo que queda fuera está siempre muerto, así que
+    // esos chunks se quedan a cero en los dos buffers y no se calculan
+    size_t row_lo = 0;
+    size_t col_lo = 0;
+    size_t row_hi = span_rows;
+    size_t col_hi = span_cols;
+
+    if (!block->torus) {
+        row_lo = row_begin < halo ? halo - row_begin : 0;
+        col_lo = col_begin < halo ? halo - col_begin : 0;
+
+        if (row_hi > grid->chunk_rows + halo - row_begin) {
+            row_hi = grid->chunk_rows + halo - row_begin;
+        }
+        if (col_hi > grid->chunk_cols + halo - col_begin) {
+            col_hi = grid->chunk_cols + halo - col_begin;
+        }
+    }
+
+    chunk_t* curr = scratch->chunks;
+    chunk_t* next = scratch->chunks_next;
+    uint8_t* changed = scratch->changed;
+    uint8_t* changed_next = scratch->changed_next;
+
+    size_t active = 0;
+
+    // los bordes del buffer ven vecinos que no son los reales, pero el
+    // error avanza una célula por generación y no llega al interior
+    for (size_t gen = 0; gen < gens; ++gen) {
+        bool last = gen + 1 == gens;
+
+        // del último paso solo se devuelve el interior
+        size_t i_begin = last ? halo : row_lo;
+        size_t j_begin = last ? halo : col_lo;
+        size_t i_end = last ? halo + rows : row_hi;
+        size_t j_end = last ? halo + cols : col_hi;
+
+        for (size_t i = i_begin; i < i_end; ++i) {
+            for (size_t j = j_begin; j < j_end; ++j) {
+                size_t idx = ((i + 1) * side) + j + 1;
+                size_t up = idx - side;
+                size_t down = idx + side;
+
+                uint8_t near = changed[up - 1]   | changed[up]   | changed[up + 1]
+                             | changed[idx - 1]  | changed[idx]  | changed[idx + 1]
+                             | changed[down - 1] | changed[down] | changed[down + 1];
+
+                uint8_t flag = 0;
+
+                if (near) {
+                    chunk_word_t west[CHUNK_PADDED];
+                    chunk_word_t centre[CHUNK_PADDED];
+                    chunk_word_t east[CHUNK_PADDED];
+
+                    chunk_column(&curr[up - 1], &curr[idx - 1], &curr[down - 1], west);
+                    chunk_column(&curr[up],     &curr[idx],     &curr[down],     centre);
+                    chunk_column(&curr[up + 1], &curr[idx + 1], &curr[down + 1], east);
+
+                    flag = (grid->kernel(west, centre, east, next[idx].rows, &grid->rule) & KERNEL_CHANGED) != 0;
+                }
+
+                changed_next[idx] = flag;
+
+                if (i >= halo && i < halo + rows && j >= halo && j < halo + cols) {
+                    *computed += near != 0;
+                }
+
+                // la marca del último paso es el cambio respecto a la
+                // generación anterior, la que espera la siguiente pasada
+                if (last) {
+                    grid->changed_next[grid_chunk_idx(grid, row_begin + i - halo, col_begin + j - halo)] = flag;
+                    active += near != 0;
+                }
+            }
+        }
+
+        chunk_t* swap = curr;
+        curr = next;
+        next = swap;
+
+        uint8_t* swap_changed = changed;
+        changed = changed_next;
+        changed_next = swap_changed;
+    }
+
+    for (size_t i = 0; i < rows; ++i) {
+        for (size_t j = 0; j < cols; ++j) {
+            const chunk_t* chunk = &curr[((halo + i + 1) * side) + halo + j + 1];
+
+            grid->chunks_next[grid_chunk_idx(grid, row_begin + i, col_begin + j)] = *chunk;
+            grid_occ_put(grid, grid->occ_next, grid_occ_bit(grid, row_begin + i + 1, col_begin + j + 1), !chunk_empty(chunk));
+        }
+    }
+
+    return active;
+}
+
+static void
+timeblock_band(void* arg, size_t worker, size_t workers) {
+    grid_t* grid = arg;
+    timeblock_t* block = grid->timeblock;
+
+    size_t tiles = block->rows * block->cols;
+    size_t len = block->len;
+
+    timeblock_scratch_t scratch = {
+        .chunks = &block->chunks[2 * worker * len],
+        .chunks_next = &block->chunks[((2 * worker) + 1) * len],
+        .changed = &block->changed[2 * worker * len],
+        .changed_next = &block->changed[((2 * worker) + 1) * len],
+    };
+
+    // los tiles se reparten intercalados para equilibrar la carga
+    // cuando la actividad se concentra en una zona del grid
+    size_t active = 0;
+    size_t computed = 0;
+
+    for (size_t tile = worker; tile < tiles; tile += workers) {
+        active += timeblock_tile(grid, tile, &scratch, &computed);
+    }
+
+    atomic_fetch_add_explicit(&grid->chunks_active, active, memory_order_relaxed);
+    atomic_fetch_add_explicit(&block->computed, computed, memory_order_relaxed);
+}
+
+void
+timeblock_run(grid_t* grid, size_t gens, bool torus) {
+    timeblock_t* block = grid->timeblock;
+
+    // tras una generación normal chunks_next vuelve a ser el estado
+    // anterior, así que ningún tile tiene ya los dos buffers iguales
+    if (!grid->block_last) {
+        memset(block->still, 0, block->rows * block->cols);
+    }
+
+    block->gens = gens;
+    block->torus = torus;
+    grid->block_last = true;
+
+    atomic_store(&grid->chunks_active, 0);
+    atomic_store(&grid->chunks_periodic, 0);
+    atomic_store(&block->computed, 0);
+
+    if (grid->pool == NULL) {
+        timeblock_band(grid, 0, 1);
+    } else {
+        pool_run(grid->pool, timeblock_band, grid);
+    }
+
+    grid->chunks_computed += atomic_load(&block->computed);
+    grid->generations += gens;
+}
@@ -0,0 +1,28 @@
+#ifndef INCLUDE_TIMEBLOCK_TIMEBLOCK_H_
+#define INCLUDE_TIMEBLOCK_TIMEBLOCK_H_
+
+#include <stdbool.h>
+#include <stddef.h>
+
+#include "../grid.h"
+
+
+// bloqueo temporal: los tiles del grid avanzan varias generaciones
+// seguidas en buffers de cada trabajador
+typedef struct timeblock timeblock_t;
+
+// tiles de tile chunks de lado, o del mayor que quepa en caché si es 0,
+// con margen para gens generaciones
+extern int
+timeblock_make(timeblock_t** block_ptr, size_t chunk_rows, size_t chunk_cols, size_t tile, size_t gens, size_t workers);
+
+extern void
+timeblock_destroy(timeblock_t** block_ptr);
+
+// avanza gens generaciones, como mucho las de timeblock_make, dejando el
+// resultado en chunks_next como una generación normal
+extern void
+timeblock_run(grid_t* grid, size_t gens, bool torus);
+
+
+#endif  // INCLUDE_TIMEBLOCK_TIMEBLOCK_H_
@@ -1,3 +1,4 @@
+#include <inttypes.h>
 #include <stddef.h>
 #include <stdio.h>
 #include <stdlib.h>
@@ -9,6 +10,9 @@
 
 #include "grid/grid.h"
 #include "grid/grid_io.h"
+#include "grid/hashlife/hashlife.h"
+
+#include "syscalls/syscalls.h"
 
 int
 grid_init(grid_t** grid_ptr, const config_t* config) {
@@ -18,15 +22,39 @@ grid_init(grid_t** grid_ptr, const config_t* config) {
             return -1;
         }
     } else {
-        if (grid_make(grid_ptr, config->chunk_rows, config->chunk_cols) < 0) {
+        if (grid_make(grid_ptr, config->chunk_rows, config->chunk_cols, &config->grid_opts) < 0) {
             fprintf(stderr, "error: failed to make ui\n");
             return -1;
         }
+
+        if (config->random && grid_randomize(*grid_ptr) < 0) {
+            grid_destroy(grid_ptr);
+
+            fprintf(stderr, "error: failed to randomize grid\n");
+            return -1;
+        }
     }
 
     return 0;
 }
 
+void
+check_allocs(const grid_t* grid, const config_t* config, size_t allocs, const char* loop) {
+    size_t count = safe_alloc_count() - allocs;
+
+    // el estado estacionario no debe reservar memoria, salvo cuando el
+    // almacenamiento crece con el patrón, en un plano infinito o en una
+    // lista de células que además puede pasar al bitboard
+    if (count > 0 && !grid_grows(grid)) {
+        fprintf(stderr, "warning: %zu heap allocations in the %s\n", count, loop);
+        return;
+    }
+
+    if (config->verbose) {
+        fprintf(stderr, "stats: %zu heap allocations in the %s\n", count, loop);
+    }
+}
+
 int
 graphic_mode(grid_t* grid, config_t* config) {
     ui_t* ui = NULL;
@@ -44,7 +72,11 @@ graphic_mode(grid_t* grid, config_t* config) {
     }
 
     size_t step = 0;
-    ui_status_t status = STATUS_CONTINUE;
+
+    // el primer fotograma reserva el buffer del printer, a partir
+    // de ahí repintar no debería volver a reservar memoria
+    ui_status_t status = ui_loop(ui, grid, config, &step);
+    size_t allocs = safe_alloc_count();
 
     while (status == STATUS_CONTINUE) {
         status = ui_loop(ui, grid, config, &step);
@@ -54,22 +86,167 @@ graphic_mode(grid_t* grid, config_t* config) {
         fprintf(stderr, "error: failed to finnish ui correctly\n");
     }
 
+    check_allocs(grid, config, allocs, "repaint loop");
+
     ui_destroy(&ui);
 
     return status == STATUS_FINISH ? 0 : -1;
 }
 
+void
+print_stats(const grid_t* grid, int64_t elapsed) {
+    grid_stats_t stats;
+    grid_stats(grid, &stats);
+
+    double seconds = (double)elapsed / MS_IN_SC;
+    double computed = stats.generations == 0
+        ? 0.0
+        : 100.0 * (double)stats.chunks_computed / ((double)stats.chunks * (double)stats.generations);
+
+    fprintf(stderr, "stats: %zu generations in %.3fs (%.1f gen/s)\n",
+            stats.generations, seconds, seconds > 0 ? (double)stats.generations / seconds : 0.0);
+
+    // en un plano infinito el número de chunks varía en cada generación
+    if (grid_unbounded(grid)) {
+        fprintf(stderr, "stats: %zu %s allocated, %zu computed in the last generation\n",
+                stats.chunks, stats.unit, stats.chunks_active);
+        return;
+    }
+
+    fprintf(stderr, "stats: %zu/%zu %s active in the last generation, %.1f%% computed overall\n",
+            stats.chunks_active, stats.chunks, stats.unit, computed);
+
+    // el resto de chunks no se calcula porque su vecindario no cambió o se
+    // repite cada dos generaciones, solo lo hace el grid de chunks
+    if (stats.generations > 0 && stats.chunks_periodic_total > 0) {
+        size_t updates = stats.chunks * stats.generations;
+        size_t still = updates - stats.chunks_computed - stats.chunks_periodic_total;
+
+        fprintf(stderr, "stats: %zu period-2 chunks copied in the last generation, %.1f%% periodic and %.1f%% still overall\n",
+                stats.chunks_periodic,
+                100.0 * (double)stats.chunks_periodic_total / (double)updates,
+                100.0 * (double)still / (double)updates);
+    }
+
+    if (stats.memo_bytes > 0) {
+        size_t lookups = stats.memo_hits + stats.memo_misses;
+
+        fprintf(stderr, "stats: memo cache %s, %zu hits and %zu misses (%.1f%% hit rate) in %.1f MiB\n",
+                stats.memo_on ? "on" : "off", stats.memo_hits, stats.memo_misses,
+                lookups > 0 ? 100.0 * (double)stats.memo_hits / (double)lookups : 0.0,
+                (double)stats.memo_bytes / (1024.0 * 1024.0));
+    }
+
+    if (stats.promoted) {
+        fprintf(stderr, "stats: cell list promoted to the bitboard at generation %zu with %zu cells\n",
+                stats.promoted_at, stats.promoted_cells);
+    }
+}
+
+// cada cambio de motor con el rendimiento del periodo que lo decidió y
+// el del primero con el motor nuevo, que faltan si no se llegó a medir
+void
+format_rate(char* buf, size_t len, double rate) {
+    if (rate > 0) {
+        snprintf(buf, len, "%.1f gen/s", rate);
+    } else {
+        snprintf(buf, len, "not measured");
+    }
+}
+
+void
+print_switches(const grid_t* grid) {
+    const grid_switch_t* switches = NULL;
+    size_t len = grid_switches(grid, &switches);
+
+    for (size_t i = 0; i < len; ++i) {
+        char before[32], after[32];
+
+        format_rate(before, sizeof(before), switches[i].before);
+        format_rate(after, sizeof(after), switches[i].after);
+
+        fprintf(stderr, "auto: generation %zu: %s -> %s, %s before, %s after\n",
+                switches[i].generation, switches[i].from, switches[i].to, before, after);
+    }
+}
+
+void
+print_memory(const grid_t* grid) {
+    grid_memory_t memory;
+    grid_memory(grid, &memory);
+
+    if (memory.bytes == 0) {
+        return;
+    }
+
+    fprintf(stderr, "stats: %.1f MiB of cells in %zu KiB pages%s, allocated in %.3fs\n",
+            (double)memory.bytes / (1024.0 * 1024.0), memory.page_size / 1024,
+            memory.transparent ? " (transparent huge pages advised)" : "",
+            (double)memory.alloc_ms / MS_IN_SC);
+}
+
 int
 silent_mode(grid_t* grid, config_t* config) {
     int status = 0;
+    size_t allocs = safe_alloc_count();
+    int64_t start = safe_time();
+
+    status = grid_advance(grid, config->steps, config->use_torus);
 
-    for (size_t step = 0; step < config->steps && status == 0; ++step) {
-        status = config->use_torus ? grid_update_toroidal(grid) : grid_update(grid);
+    if (config->engine == ENGINE_AUTO) {
+        print_switches(grid);
     }
 
+    if (config->verbose) {
+        print_stats(grid, safe_time() - start);
+    }
+
+    check_allocs(grid, config, allocs, "generation loop");
+
     return status;
 }
 
+int
+hashlife_mode(grid_t* grid, config_t* config) {
+    hashlife_t* hashlife = NULL;
+
+    if (hashlife_make(&hashlife, HASHLIFE_MEM_DEFAULT, config->grid_opts.rule) < 0) {
+        fprintf(stderr, "error: failed to make hashlife engine\n");
+        return -1;
+    }
+
+    int64_t start = safe_time();
+
+    if (hashlife_import(hashlife, grid) < 0 || hashlife_advance(hashlife, config->steps) < 0) {
+        hashlife_destroy(&hashlife);
+        return -1;
+    }
+
+    // el grid solo hace falta para escribir la salida, y un patrón que
+    // crece llena el plano infinito de chunks aunque el árbol siga siendo
+    // pequeño, así que sin -o el resultado se queda en el árbol
+    if (config->output_file != NULL && hashlife_export(hashlife, grid) < 0) {
+        hashlife_destroy(&hashlife);
+        return -1;
+    }
+
+    if (config->verbose) {
+        hashlife_stats_t stats;
+        hashlife_stats(hashlife, &stats);
+
+        double seconds = (double)(safe_time() - start) / MS_IN_SC;
+
+        fprintf(stderr, "stats: %" PRIu64 " generations in %.3fs\n", config->steps, seconds);
+        fprintf(stderr, "stats: %zu hashlife nodes, root level %zu, %zu collections\n",
+                stats.nodes, stats.level, stats.collections);
+        fprintf(stderr, "stats: %" PRIu64 " cells alive\n", stats.population);
+    }
+
+    hashlife_destroy(&hashlife);
+
+    return 0;
+}
+
 int
 main(int argc, char* const* argv) {
     config_t* config = NULL;
@@ -84,18 +261,26 @@ main(int argc, char* const* argv) {
         return EXIT_FAILURE;
     }
 
+    // en modo gráfico se imprime antes de pasar al buffer alternativo,
+    // así que sigue en la terminal al salir
+    if (config->verbose) {
+        print_memory(grid);
+    }
+
     int status = 0;
 
     switch (config->mode) {
     case MODE_SILENT:
-        status = silent_mode(grid, config);
+        status = config->engine == ENGINE_HASHLIFE ? hashlife_mode(grid, config) : silent_mode(grid, config);
         break;
     case MODE_GRAPHIC:
         status = graphic_mode(grid, config);
         break;
     }
 
-    if (config->output_file != NULL) {
+    // si la simulación falla el grid no llegó a la generación pedida, y
+    // guardarlo dejaría un fichero de salida con apariencia válida
+    if (status == 0 && config->output_file != NULL) {
         grid_io_save(grid, config);
     }
 
@@ -1,14 +1,21 @@
 #include "syscalls.h"
 
 #include <errno.h>
+#include <stdatomic.h>
 #include <stdio.h>
+#include <stdlib.h>
 #include <string.h>
 #include <time.h>
 #include <stdint.h>
 #include <fcntl.h>
 #include <unistd.h>
+#include <sys/mman.h>
 
 
+// número de reservas hechas con safe_malloc, safe_calloc y safe_realloc,
+// permite comprobar que el bucle principal no reserva memoria
+static _Atomic size_t alloc_count = 0;  /* NOLINT */
+
 int
 safe_sleep(long ms) {
     struct timespec req = {ms / MS_IN_SC, (ms % MS_IN_SC) * NS_IN_MS};
@@ -82,3 +89,109 @@ safe_time(void) {
     return (ts.tv_sec * MS_IN_SC) + (ts.tv_nsec / NS_IN_MS);
 
 }
+
+void*
+safe_malloc(size_t size) {
+    atomic_fetch_add_explicit(&alloc_count, 1, memory_order_relaxed);
+
+    return malloc(size);
+}
+
+void*
+safe_calloc(size_t count, size_t size) {
+    atomic_fetch_add_explicit(&alloc_count, 1, memory_order_relaxed);
+
+    return calloc(count, size);
+}
+
+void*
+safe_realloc(void* ptr, size_t size) {
+    atomic_fetch_add_explicit(&alloc_count, 1, memory_order_relaxed);
+
+    return realloc(ptr, size);
+}
+
+size_t
+safe_alloc_count(void) {
+    return atomic_load_explicit(&alloc_count, memory_order_relaxed);
+}
+
+int
+safe_map(safe_mapping_t* map, size_t size) {
+    atomic_fetch_add_explicit(&alloc_count, 1, memory_order_relaxed);
+
+    size_t page_size = (size_t)sysconf(_SC_PAGESIZE);
+
+    // con tamaño suficiente se intentan páginas enormes reservadas, que
+    // pueden no estar configuradas, y si no páginas normales redondeando
+    // a página enorme para que las transparentes puedan usarse enteras
+#ifdef MAP_HUGETLB
+    if (size >= HUGE_PAGE_SIZE) {
+        size_t len = (size + HUGE_PAGE_SIZE - 1) & ~(HUGE_PAGE_SIZE - 1);
+        void* ptr = mmap(NULL, len, PROT_READ | PROT_WRITE, MAP_PRIVATE | MAP_ANONYMOUS | MAP_HUGETLB, -1, 0);
+
+        if (ptr != MAP_FAILED) {
+            *map = (safe_mapping_t) {
+                .ptr = ptr,
+                .len = len,
+                .page_size = HUGE_PAGE_SIZE,
+                .transparent = false,
+            };
+
+            return 0;
+        }
+    }
+#endif
+
+    bool huge = size >= HUGE_PAGE_SIZE;
+
+    size_t align = huge ? HUGE_PAGE_SIZE : page_size;
+    size_t len = (size + align - 1) & ~(align - 1);
+
+    // las páginas enormes transparentes solo cubren regiones alineadas,
+    // así que se mapea de más y se recortan los extremos sobrantes
+    size_t extra = huge ? HUGE_PAGE_SIZE : 0;
+    char* ptr = mmap(NULL, len + extra, PROT_READ | PROT_WRITE, MAP_PRIVATE | MAP_ANONYMOUS, -1, 0);
+
+    if (ptr == MAP_FAILED) {
+        fprintf(stderr, "error: failed to map %zu bytes: %s\n", len, strerror(errno));
+        return -1;
+    }
+
+    if (huge) {
+        size_t head = (HUGE_PAGE_SIZE - ((uintptr_t)ptr & (HUGE_PAGE_SIZE - 1))) & (HUGE_PAGE_SIZE - 1);
+
+        if (head > 0) {
+            munmap(ptr, head);
+        }
+        if (extra - head > 0) {
+            munmap(ptr + head + len, extra - head);
+        }
+
+        ptr += head;
+    }
+
+    bool transparent = false;
+
+#ifdef MADV_HUGEPAGE
+    transparent = huge && madvise(ptr, len, MADV_HUGEPAGE) == 0;
+#endif
+
+    *map = (safe_mapping_t) {
+        .ptr = ptr,
+        .len = len,
+        .page_size = page_size,
+        .transparent = transparent,
+    };
+
+    return 0;
+}
+
+void
+safe_unmap(safe_mapping_t* map) {
+    if (map->ptr != NULL && munmap(map->ptr, map->len) < 0) {
+        fprintf(stderr, "error: failed to unmap %zu bytes: %s\n", map->len, strerror(errno));
+    }
+
+    *map = (safe_mapping_t) {0};
+}
@@ -1,6 +1,8 @@
 #ifndef INCLUDE_SYSCALLS_SYSCALLS_H_
 #define INCLUDE_SYSCALLS_SYSCALLS_H_
 
+#include <stdbool.h>
+#include <stddef.h>
 #include <stdint.h>
 #include <string.h>
 
@@ -10,6 +12,18 @@
 
 #define ONE_MS 1L
 
+// tamaño de las páginas enormes que se piden con MAP_HUGETLB
+#define HUGE_PAGE_SIZE ((size_t)2 << 20)
+
+// memoria pedida directamente al kernel, llega a cero y las páginas
+// no existen hasta que se escriben por primera vez
+typedef struct safe_mapping {
+    void* ptr;
+    size_t len;
+    size_t page_size;
+    bool transparent;
+} safe_mapping_t;
+
 extern int
 safe_sleep(long ms);
 
@@ -22,5 +36,23 @@ safe_read(char* key);
 extern int64_t
 safe_time(void);
 
+extern void*
+safe_malloc(size_t size);
+
+extern void*
+safe_calloc(size_t count, size_t size);
+
+extern void*
+safe_realloc(void* ptr, size_t size);
+
+extern size_t
+safe_alloc_count(void);
+
+extern int
+safe_map(safe_mapping_t* map, size_t size);
+
+extern void
+safe_unmap(safe_mapping_t* map);
+
 
 #endif  // INCLUDE_SYSCALLS_SYSCALLS_H_
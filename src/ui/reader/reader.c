@@ -9,6 +9,8 @@
 #include <unistd.h>
 #include <stdbool.h>
 
+#include "../../syscalls/syscalls.h"
+
 
 #define MAX_ESCSEQ_LEN 32
 #define MIN_ESCSEQ_LEN 6
@@ -106,6 +108,10 @@ found_key(reader_t* reader, char c) {       /* NOLINT */
             reader->key = KEY_CLEAR;
             return true;
         }
+        if (c == KEY_MEMO) {
+            reader->key = KEY_MEMO;
+            return true;
+        }
         if (c == KEY_FRAME) {
             reader->key = KEY_FRAME;
             return true;
@@ -178,7 +184,7 @@ found_key(reader_t* reader, char c) {       /* NOLINT */
 
 int
 reader_make(reader_t** reader_ptr) {
-    *reader_ptr = malloc(sizeof(reader_t));
+    *reader_ptr = safe_malloc(sizeof(reader_t));
 
     if (*reader_ptr == NULL) {
         fprintf(stderr, "error: failed to allocate memory for reader\n");
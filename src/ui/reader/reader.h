@@ -18,6 +18,7 @@ typedef enum reader_status {
 typedef enum reader_key {
     KEY_RANDM = 'r',
     KEY_CLEAR = 'c',
+    KEY_MEMO  = 'm',
     KEY_PAUSE = ' ',
     KEY_FRAME = '.',
     KEY_EXIT  = CNTL('q'),
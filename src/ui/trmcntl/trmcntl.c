@@ -20,7 +20,7 @@ struct trmcntl {
 
 int
 trmcntl_make(trmcntl_t** trmcntl_ptr) {
-    *trmcntl_ptr = malloc(sizeof(trmcntl_t));
+    *trmcntl_ptr = safe_malloc(sizeof(trmcntl_t));
 
     if (*trmcntl_ptr == NULL) {
         fprintf(stderr, "error: failed to allocate memory for trmcntl\n");
@@ -196,6 +196,19 @@ handle_clear(ui_t* ui, grid_t* grid) {
     return STATUS_CONTINUE;
 }
 
+// con --memo la caché se puede apagar y encender sin parar la simulación
+static ui_status_t
+handle_memo(ui_t* ui, grid_t* grid) {
+    (void)ui;
+
+    grid_stats_t stats;
+    grid_stats(grid, &stats);
+
+    grid_set_memo(grid, !stats.memo_on);
+
+    return STATUS_CONTINUE;
+}
+
 static ui_status_t
 handle_frame(ui_t* ui, grid_t* grid, config_t* config, size_t* step) {
     if (ui->mode != MODE_PAUSE) {
@@ -232,6 +245,8 @@ handle_key(ui_t* ui, grid_t* grid, config_t* config, size_t* step) {
         return handle_randomize(ui, grid);
     case KEY_CLEAR:
         return handle_clear(ui, grid);
+    case KEY_MEMO:
+        return handle_memo(ui, grid);
     case KEY_FRAME:
         return handle_frame(ui, grid, config, step);
     default:
@@ -407,7 +422,7 @@ ui_make(ui_t** ui_ptr, const config_t* config) {
         return -1;
     }
 
-    *ui_ptr = malloc(sizeof(ui_t));
+    *ui_ptr = safe_malloc(sizeof(ui_t));
 
     if (*ui_ptr == NULL) {
         restore_signals();
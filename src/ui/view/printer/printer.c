@@ -6,6 +6,8 @@
 #include <stdio.h>
 #include <unistd.h>
 
+#include "../../../syscalls/syscalls.h"
+
 
 #define PRINTER_INIT_SIZE 512
 
@@ -17,7 +19,7 @@ struct printer {
 
 int
 printer_make(printer_t** printer) {
-    *printer = malloc(sizeof(printer_t));
+    *printer = safe_malloc(sizeof(printer_t));
 
     if (*printer == NULL) {
         fprintf(stderr, "error: failed to allocate memory for printer\n");
@@ -25,7 +27,7 @@ printer_make(printer_t** printer) {
     }
 
     **printer = (printer_t) {
-        .buf = malloc(PRINTER_INIT_SIZE),
+        .buf = safe_malloc(PRINTER_INIT_SIZE),
         .size = PRINTER_INIT_SIZE,
         .len = 0,
     };
@@ -47,6 +49,25 @@ printer_destroy(printer_t** printer) {
     *printer = NULL;
 }
 
+int
+printer_reserve(printer_t* printer, size_t size) {
+    if (size <= printer->size) {
+        return 0;
+    }
+
+    char* new_buf = safe_realloc(printer->buf, size);
+
+    if (new_buf == NULL) {
+        fprintf(stderr, "error: failed to allocate memory for printer resize\n");
+        return -1;
+    }
+
+    printer->buf = new_buf;
+    printer->size = size;
+
+    return 0;
+}
+
 int
 printer_append(printer_t* printer, const char *fmt, ...) {
     va_list args;
@@ -65,18 +86,18 @@ printer_append(printer_t* printer, const char *fmt, ...) {
             return -1;
         }
 
+        // se crece al doble para que un frame que no cabe
+        // no provoque una reserva por cada llamada
         size_t new_size = printer->len + len + 1;
 
-        char* new_buf = realloc(printer->buf, new_size);
+        if (new_size < printer->size * 2) {
+            new_size = printer->size * 2;
+        }
 
-        if (new_buf == NULL) {
+        if (printer_reserve(printer, new_size) < 0) {
             va_end(args);
-            fprintf(stderr, "error: failed to allocate memory for printer resize\n");
             return -1;
         }
-
-        printer->buf = new_buf;
-        printer->size = new_size;
     }
 
     printer->len += vsnprintf(printer->buf + printer->len, printer->size - printer->len, fmt, args);
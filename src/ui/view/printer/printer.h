@@ -1,6 +1,7 @@
 #ifndef INCLUDE_PRINTER_PRINTER_H_
 #define INCLUDE_PRINTER_PRINTER_H_
 
+#include <stddef.h>
 
 #define INIT_ALT_BUF "\x1b[?1049h"
 #define KILL_ALT_BUF "\x1b[?1049l"
@@ -30,6 +31,9 @@ printer_make(printer_t** printer);
 extern void
 printer_destroy(printer_t** printer);
 
+extern int
+printer_reserve(printer_t* printer, size_t size);
+
 extern int
 printer_append(printer_t* printer, const char* fmt, ...);
 
@@ -12,6 +12,8 @@
 #include "printer/printer.h"
 #include "../trmcntl/trmcntl.h"
 
+#include "../../syscalls/syscalls.h"
+
 /* font */
 #define THIN 0
 #define BOLD 1
@@ -34,6 +36,17 @@
 #define COLOR_DEFAULT 103
 #define COLOR_DARK 60
 
+/* aging states of Generations rules, from just left alive to about to die */
+static const uint8_t COLOR_AGES[] = {147, 111, 105, 99, 62, 61};
+
+#define COLOR_AGES_LEN (sizeof(COLOR_AGES) / sizeof(COLOR_AGES[0]))
+
+/* frame size estimate, in bytes */
+#define FRAME_CELL_ESC 16
+#define FRAME_ROW_EXTRA 96
+#define FRAME_LINE_GLYPH 3
+#define FRAME_EXTRA 512
+
 
 struct view {
     printer_t* printer;
@@ -44,6 +57,7 @@ struct view {
     const char* cell_alive;
     uint8_t color_light;
     uint8_t color_dark;
+    size_t states;
 };
 
 int
@@ -72,7 +86,7 @@ view_make(view_t** view_ptr, const config_t* config) {
         return -1;
     }
 
-    *view_ptr = malloc(sizeof(view_t));
+    *view_ptr = safe_malloc(sizeof(view_t));
 
     if (*view_ptr == NULL) {
         printer_destroy(&printer);
@@ -93,6 +107,7 @@ view_make(view_t** view_ptr, const config_t* config) {
         .cell_alive = config->shape_alive,
         .cell_dead = config->shape_dead,
         .cell_width = config->shape_len,
+        .states = config->grid_opts.rule.states,
     };
 
     return 0;
@@ -149,21 +164,45 @@ view_paint_line(const view_t* view, size_t len) {
     return 0;
 }
 
+static int
+view_paint_cell(const view_t* view, cell_state_t state) {
+    if (state == CELL_ALIVE) {
+        return printer_append(view->printer, "\x1b[1;38;5;%dm%s", view->color_light, view->cell_alive);
+    }
+
+    /* aging cells spread over the whole palette whatever the state count */
+    if (state > CELL_ALIVE) {
+        size_t age = ((size_t)state - 2) * COLOR_AGES_LEN / (view->states - 2);
+
+        return printer_append(view->printer, "\x1b[0;38;5;%dm%s", COLOR_AGES[age], view->cell_alive);
+    }
+
+    return printer_append(view->printer, "\x1b[0;38;5;%dm%s", view->color_dark, view->cell_dead);
+}
+
 static int
 view_paint_grid_row(const view_t* view, const grid_t* grid, size_t row, size_t cols) {
     cell_state_t state;
-    for (size_t col = 0; col < cols; ++col) {
-        if (grid_cell_state(grid, &state, row, col) < 0) {
-            fprintf(stderr, "error: failed to fetch cell state\n");
-            return -1;
-        }
+    for (size_t col = 0; col < cols;) {
+        // los tramos que el grid sabe vacíos se pintan sin consultarlos
+        size_t run = grid_dead_run(grid, row, col);
 
-        if (state == CELL_ALIVE) {
-            if (printer_append(view->printer, "\x1b[1;38;5;%dm%s", view->color_light, view->cell_alive) < 0) {
+        if (run == 0) {
+            if (grid_cell_state(grid, &state, row, col) < 0) {
+                fprintf(stderr, "error: failed to fetch cell state\n");
                 return -1;
             }
-        } else {
-            if (printer_append(view->printer, "\x1b[0;38;5;%dm%s", view->color_dark, view->cell_dead) < 0) {
+
+            if (view_paint_cell(view, state) < 0) {
+                return -1;
+            }
+
+            col += 1;
+            continue;
+        }
+
+        for (; run > 0 && col < cols; --run, ++col) {
+            if (view_paint_cell(view, CELL_DEAD) < 0) {
                 return -1;
             }
         }
@@ -464,6 +503,20 @@ view_paint_body(const view_t* view, const grid_t* grid, size_t rows, size_t cols
     return 0;
 }
 
+static size_t
+view_frame_size(const view_t* view, size_t rows, size_t cols) {
+    size_t shape_len = strlen(view->cell_alive);
+
+    if (strlen(view->cell_dead) > shape_len) {
+        shape_len = strlen(view->cell_dead);
+    }
+
+    size_t row_size = (cols * (FRAME_CELL_ESC + shape_len)) + FRAME_ROW_EXTRA;
+    size_t line_size = cols * view->cell_width * FRAME_LINE_GLYPH;
+
+    return (rows * row_size) + (2 * line_size) + FRAME_EXTRA;
+}
+
 int
 view_paint_grid(const view_t* view, const grid_t* grid, size_t step, size_t steps, const char* mode, bool redraw) {
     size_t rows, cols;
@@ -485,6 +538,13 @@ view_paint_grid(const view_t* view, const grid_t* grid, size_t step, size_t step
         return view_screen_narrow(view);
     }
 
+    /* size the buffer for a whole frame once, so later frames don't allocate;
+     * past the checks above the grid fits on screen, so this is bounded by
+     * the terminal size */
+    if (printer_reserve(view->printer, view_frame_size(view, rows, cols)) < 0) {
+        return -1;
+    }
+
     if (view_center_rows(view, occupied_rows) < 0) {
         return -1;
     }